@@ -56,6 +56,7 @@ public:
         QArvCamera::init();
 
         m_outStream = registerOutputPort<Frame>(QStringLiteral("video"), QStringLiteral("Video"));
+        registerSynchronizerTelemetryPort();
         m_modIcon = modInfo->icon();
     }
 
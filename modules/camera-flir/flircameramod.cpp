@@ -45,6 +45,7 @@ public:
         m_camera = new FLIRCamera(),
 
         m_outStream = registerOutputPort<Frame>(QStringLiteral("video"), QStringLiteral("Video"));
+        registerSynchronizerTelemetryPort();
 
         m_camSettingsWindow = new FLIRCamSettingsDialog(m_camera);
         addSettingsWindow(m_camSettingsWindow);
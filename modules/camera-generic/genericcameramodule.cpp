@@ -48,6 +48,7 @@ public:
           m_stopped(true)
     {
         m_outStream = registerOutputPort<Frame>(QStringLiteral("video"), QStringLiteral("Video"));
+        registerSynchronizerTelemetryPort();
 
         m_camSettingsWindow = new GenericCameraSettingsDialog(m_camera);
         addSettingsWindow(m_camSettingsWindow);
@@ -136,6 +137,7 @@ public:
         waitCondition->wait(this);
 
         while (m_running) {
+            SY_TRACE_SCOPE("acquire frame");
             const auto cycleStartTime = currentTimePoint();
 
             Frame frame;
@@ -49,6 +49,7 @@ private:
     GstElement *m_pipeline = nullptr;
     GstAppSink *m_appSink = nullptr;
     cv::Size m_resolution;
+    FramePool m_framePool;
 
     double m_fps;
     QString m_imgFormat;
@@ -57,9 +58,11 @@ private:
 public:
     explicit TISCameraModule(QObject *parent = nullptr)
         : AbstractModule(parent),
-          m_capConfig(std::make_shared<TcamCaptureConfig>())
+          m_capConfig(std::make_shared<TcamCaptureConfig>()),
+          m_framePool(QStringLiteral("tis-camera"))
     {
         m_outStream = registerOutputPort<Frame>(QStringLiteral("video"), QStringLiteral("Video"));
+        registerSynchronizerTelemetryPort();
 
         m_ctlDialog = new TcamControlDialog(m_capConfig);
         connect(m_ctlDialog, &TcamControlDialog::deviceLost, this, &TISCameraModule::onDeviceLost);
@@ -138,6 +141,7 @@ public:
     bool prepare(const TestSubject &) override
     {
         m_deviceLost = false;
+        m_framePool.setName(name());
         m_device = m_ctlDialog->selectedDevice();
         if (m_device.serial().empty()) {
             raiseError("Unable to continue: No valid camera was selected!");
@@ -232,23 +236,21 @@ public:
                 const auto gS = gst_caps_get_structure(caps, 0);
                 const gchar *format_str = gst_structure_get_string(gS, "format");
 
-                // create our frame and push it to subscribers
+                // create our frame from a recycled buffer and push it to subscribers
                 Frame frame;
                 if (g_strcmp0(format_str, "BGRx") == 0) {
-                    frame.mat.create(m_resolution, CV_8UC(4));
-                    memcpy(frame.mat.data, info.data, m_resolution.width * m_resolution.height * 4);
+                    frame.mat = m_framePool.mat(m_resolution, CV_8UC(4));
                 } else if (g_strcmp0(format_str, "GRAY8") == 0) {
-                    frame.mat.create(m_resolution, CV_8UC(1));
-                    memcpy(frame.mat.data, info.data, m_resolution.width * m_resolution.height);
+                    frame.mat = m_framePool.mat(m_resolution, CV_8UC(1));
                 } else if (g_strcmp0(format_str, "GRAY16_LE") == 0) {
-                    frame.mat.create(m_resolution, CV_16UC(1));
-                    memcpy(frame.mat.data, info.data, m_resolution.width * m_resolution.height);
+                    frame.mat = m_framePool.mat(m_resolution, CV_16UC(1));
                 } else {
                     qCDebug(logTISCam).noquote().nospace() << QString::fromStdString(m_device.str()) << ": "
                                                            << "Received buffer with unsupported format: " << format_str;
                     gst_buffer_unmap(buffer, &info);
                     continue;
                 }
+                memcpy(frame.mat.data, info.data, std::min(info.size, frame.mat.total() * frame.mat.elemSize()));
 
                 // only do time adjustment if we have a valid timestamp
                 // NOTE: We use the DTS here as using PTS (as before) has stopped working with newer TIS camera
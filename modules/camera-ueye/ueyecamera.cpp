@@ -26,7 +26,8 @@ UEyeCamera::UEyeCamera(QObject *parent)
     : QObject(parent),
       m_camId(-1),
       m_hCam(0),
-      m_camBuf(nullptr)
+      m_camBuf(nullptr),
+      m_framePool(QStringLiteral("ueye-camera"))
 {
 }
 
@@ -235,7 +236,7 @@ cv::Mat UEyeCamera::getFrame(time_t *time)
 
     is_WaitEvent(m_hCam, IS_SET_EVENT_FRAME, 1);
 
-    cv::Mat frame(m_frameSize.height, m_frameSize.width, CV_8UC3);
+    auto frame = m_framePool.mat(m_frameSize, CV_8UC3);
 
     auto res = is_GetImageInfo(m_hCam, m_camBufId, &imgInfo, sizeof(imgInfo));
     if (res == IS_SUCCESS) {
@@ -27,6 +27,8 @@
 #include <QSize>
 #include <opencv2/core/core.hpp>
 
+#include "datactl/frametype.h"
+
 class UEyeCamera : public QObject
 {
     Q_OBJECT
@@ -75,6 +77,7 @@ private:
 
     cv::Size m_frameSize;
     cv::Mat m_mat;
+    FramePool m_framePool;
 
     QString m_confFile;
 };
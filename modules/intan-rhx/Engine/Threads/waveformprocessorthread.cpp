@@ -173,9 +173,8 @@ void WaveformProcessorThread::run()
                                     // This signal should be ultimately received by ProbeMapWindow, which will then internally handle the time decay
                                 }
 
-                                syntalosModuleExportAmplifierChanData(syMod, group, channel->getNativeChannelNumber(),
-                                                                      wide, NumSamples,
-                                                                      signalSources->numAmplifierChannels(), gpuWaveformAddress.waveformIndex);
+                                syntalosModuleSetAmplifierChanRawIndex(syMod, group, channel->getNativeChannelNumber(),
+                                                                       gpuWaveformAddress.waveformIndex);
 
                                 if (signalSources->getControllerType() == ControllerStimRecord) {
                                     // Load DC amplifier data and stimulation markers.
@@ -218,6 +217,8 @@ void WaveformProcessorThread::run()
                         }
                     }
 
+                    syntalosModuleExportAmplifierData(syMod, wide, NumSamples, signalSources->numAmplifierChannels());
+
                     if (state->getReportSpikes()) {
                         state->spikeReport(spikingChannelNames);
                     }
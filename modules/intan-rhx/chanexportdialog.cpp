@@ -72,6 +72,11 @@ ChanExportDialog::ChanExportDialog(SystemState *state, QWidget *parent) :
     m_exportChannelsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     m_exportChannelsTable->setSelectionMode(QAbstractItemView::ExtendedSelection);
 
+    m_groupedOutputCheckBox = new QCheckBox("Combine amplifier channels of each port into a single output", this);
+    m_groupedOutputCheckBox->setToolTip("Emit one signal block per port, containing all selected amplifier channels "
+                                        "of that port as columns, instead of one output per channel.");
+    connect(m_groupedOutputCheckBox, &QCheckBox::toggled, this, &ChanExportDialog::updateExportChannelsTable);
+
     QVBoxLayout *presentChannelsColumn = new QVBoxLayout;
     presentChannelsColumn->addWidget(new QLabel("Available Channels:", this));
     presentChannelsColumn->addWidget(m_availableChannelsTable);
@@ -100,6 +105,7 @@ ChanExportDialog::ChanExportDialog(SystemState *state, QWidget *parent) :
     QVBoxLayout *mainLayout = new QVBoxLayout;
     //dataOutputColumn->addWidget(waveformOutputGroupBox);
     mainLayout->addLayout(channelsRow);
+    mainLayout->addWidget(m_groupedOutputCheckBox);
 
     updateAvailableChannelsTable();
 
@@ -177,6 +183,18 @@ QStringList ChanExportDialog::exportedChannelNames() const
     return m_exportedChannels.keys();
 }
 
+bool ChanExportDialog::groupedOutput() const
+{
+    return m_groupedOutputCheckBox->isChecked();
+}
+
+void ChanExportDialog::setGroupedOutput(bool grouped)
+{
+    // the caller is expected to update the exported channels table afterwards
+    const QSignalBlocker blocker(m_groupedOutputCheckBox);
+    m_groupedOutputCheckBox->setChecked(grouped);
+}
+
 void ChanExportDialog::availableChannelSelected()
 {
     bool changeChannelsAllowed = !m_state->running && (m_availableChannelsTable->selectedItems().size() > 0);
@@ -26,6 +26,7 @@
 class QPushButton;
 class QLabel;
 class QTableWidget;
+class QCheckBox;
 
 class ChanExportDialog : public QWidget
 {
@@ -39,6 +40,8 @@ public slots:
     void removeAllChannels();
     void updateExportChannelsTable();
     QStringList exportedChannelNames() const;
+    bool groupedOutput() const;
+    void setGroupedOutput(bool grouped);
 
 private slots:
     void availableChannelSelected();
@@ -65,6 +68,7 @@ private:
     QComboBox *m_filterSelectComboBox;
 
     QTableWidget *m_exportChannelsTable;
+    QCheckBox *m_groupedOutputCheckBox;
 
     SystemState *m_state;
     SignalSources *m_signalSources;
@@ -21,6 +21,7 @@
 
 #include <QTimer>
 #include <QMessageBox>
+#include <algorithm>
 
 #include "utils/misc.h"
 #include "boardselectdialog.h"
@@ -83,6 +84,7 @@ IntanRhxModule::IntanRhxModule(const QString &id, IntanRhxModuleInfo *modInfo, Q
     m_boardSelectDlg = new BoardSelectDialog(this);
     m_modIcon = modInfo->icon();
     m_boardSelectDlg->setWindowIcon(m_modIcon);
+    registerSynchronizerTelemetryPort();
 }
 
 IntanRhxModule::~IntanRhxModule()
@@ -184,6 +186,8 @@ bool IntanRhxModule::prepare(const TestSubject &)
     for (auto &blocks : floatSdiByGroupChannel) {
         for (uint i = 0; i < blocks.size(); ++ i) {
             auto &sdi = blocks[i];
+            // the raw channel indices are only valid for a single run
+            sdi.rawChanIndex = -1;
             if (!sdi.active)
                 continue;
             sdi.stream->setMetadataValue(QStringLiteral("sample_rate"), sampleRate);
@@ -192,6 +196,14 @@ bool IntanRhxModule::prepare(const TestSubject &)
             sdi.stream->setMetadataValue("signal_names", QStringList() << QStringLiteral("F%1").arg(i));
         }
     }
+    for (auto &gsdi : floatSdiByGroup) {
+        if (!gsdi.active)
+            continue;
+        gsdi.stream->setMetadataValue(QStringLiteral("sample_rate"), sampleRate);
+        gsdi.stream->setMetadataValue("time_unit", "index");
+        gsdi.stream->setMetadataValue("data_unit", "µV");
+        gsdi.stream->setMetadataValue("signal_names", gsdi.signalNames);
+    }
 
     // start output port streams
     for (auto &port : outPorts())
@@ -260,6 +272,7 @@ void IntanRhxModule::serializeSettings(const QString&, QVariantHash &settings, Q
     extraData = m_ctlWindow->globalSettingsAsByteArray();
 
     settings.insert("port_channel_names", m_chanExportDlg->exportedChannelNames());
+    settings.insert("grouped_output", m_chanExportDlg->groupedOutput());
 }
 
 bool IntanRhxModule::loadSettings(const QString &, const QVariantHash &settings, const QByteArray &extraData)
@@ -270,6 +283,7 @@ bool IntanRhxModule::loadSettings(const QString &, const QVariantHash &settings,
             return ret;
     }
 
+    m_chanExportDlg->setGroupedOutput(settings.value("grouped_output", false).toBool());
     m_chanExportDlg->removeAllChannels();
     const auto exportedChannelNames = settings.value("port_channel_names").toStringList();
     for (const auto &chanName : exportedChannelNames)
@@ -295,10 +309,17 @@ void IntanRhxModule::setPortSignalBlockSampleSize(size_t sampleNum)
 
     for (auto &blocks : floatSdiByGroupChannel) {
         for (auto &sdi : blocks) {
+            if (sdi.column >= 0)
+                continue;
             sdi.signalBlock->timestamps.resize(sampleNum);
             sdi.signalBlock->data.resize(sampleNum, 1);
         }
     }
+
+    for (auto &gsdi : floatSdiByGroup) {
+        gsdi.signalBlock->timestamps.resize(sampleNum);
+        gsdi.signalBlock->data.resize(sampleNum, gsdi.signalNames.size());
+    }
 }
 
 void IntanRhxModule::onExportedChannelsChanged(const QList<Channel *> &channels)
@@ -308,8 +329,11 @@ void IntanRhxModule::onExportedChannelsChanged(const QList<Channel *> &channels)
     clearInPorts();
     intSdiByGroupChannel.clear();
     floatSdiByGroupChannel.clear();
+    floatSdiByGroup.clear();
 
     auto signalSources = m_sysState->signalSources;
+    const auto grouped = m_chanExportDlg->groupedOutput();
+    std::vector<QList<Channel *>> groupedChannels;
 
     // add new ports
     for (const auto &channel : channels) {
@@ -327,6 +351,12 @@ void IntanRhxModule::onExportedChannelsChanged(const QList<Channel *> &channels)
             sdi.active = true;
 
             intSdiByGroupChannel[groupIndex][channel->getNativeChannelNumber()] = sdi;
+        } else if (grouped && channel->getSignalType() == AmplifierSignal) {
+            // amplifier channels are combined per group below
+            const auto groupIndex = signalSources->groupIndexByName(channel->getGroupName());
+            if ((int) groupedChannels.size() <= groupIndex)
+                groupedChannels.resize(groupIndex + 1);
+            groupedChannels[groupIndex].append(channel);
         } else {
             const auto groupIndex = signalSources->groupIndexByName(channel->getGroupName());
             if ((int) floatSdiByGroupChannel.size() <= groupIndex)
@@ -341,4 +371,43 @@ void IntanRhxModule::onExportedChannelsChanged(const QList<Channel *> &channels)
             floatSdiByGroupChannel[groupIndex][channel->getNativeChannelNumber()] = sdi;
         }
     }
+
+    // add one port per group, with every exported channel of the group as one column of the signal block
+    for (int groupIndex = 0; groupIndex < (int) groupedChannels.size(); ++groupIndex) {
+        auto &groupChannels = groupedChannels[groupIndex];
+        if (groupChannels.isEmpty())
+            continue;
+        std::sort(groupChannels.begin(), groupChannels.end(), [](Channel *a, Channel *b) {
+            return a->getNativeChannelNumber() < b->getNativeChannelNumber();
+        });
+
+        if ((int) floatSdiByGroup.size() <= groupIndex)
+            floatSdiByGroup.resize(groupIndex + 1);
+        if ((int) floatSdiByGroupChannel.size() <= groupIndex)
+            floatSdiByGroupChannel.resize(groupIndex + 1);
+
+        const auto signalGroup = signalSources->groupByIndex(groupIndex);
+        auto &gsdi = floatSdiByGroup[groupIndex];
+        gsdi.stream = registerOutputPort<FloatSignalBlock>(
+            QStringLiteral("group-%1").arg(signalGroup->getPrefix()), signalGroup->getName());
+        gsdi.active = true;
+
+        for (const auto &channel : groupChannels) {
+            const auto nativeChannel = channel->getNativeChannelNumber();
+            if ((int) floatSdiByGroupChannel[groupIndex].size() <= nativeChannel)
+                floatSdiByGroupChannel[groupIndex].resize(nativeChannel + 1);
+
+            StreamDataInfo<FloatSignalBlock> sdi(groupIndex, nativeChannel);
+            sdi.signalBlock = gsdi.signalBlock;
+            sdi.column = gsdi.signalNames.size();
+            sdi.active = true;
+            floatSdiByGroupChannel[groupIndex][nativeChannel] = sdi;
+
+            gsdi.signalNames.append(channel->getNativeAndCustomNames());
+        }
+        gsdi.signalBlock->data.resize(0, gsdi.signalNames.size());
+    }
+
+    // all ports were removed above, so the telemetry port needs to be added again
+    registerSynchronizerTelemetryPort();
 }
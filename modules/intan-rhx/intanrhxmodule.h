@@ -21,6 +21,7 @@
 
 #include <QObject>
 #include "moduleapi.h"
+#include "datactl/signalconv.h"
 
 SYNTALOS_DECLARE_MODULE
 
@@ -54,7 +55,9 @@ public:
     explicit StreamDataInfo(int group = -1, int channel = -1)
         : active(false),
           channelGroup(group),
-          nativeChannel(channel)
+          nativeChannel(channel),
+          column(-1),
+          rawChanIndex(-1)
     {
         signalBlock = std::make_shared<T>();
     }
@@ -64,6 +67,32 @@ public:
     std::shared_ptr<T> signalBlock;
     int channelGroup;
     int nativeChannel;
+
+    // column in the signal block of the channel group, or -1 if this channel has its own stream
+    int column;
+
+    // index of this channel in the interleaved raw amplifier data, or -1 if unknown
+    int rawChanIndex;
+};
+
+/**
+ * Output stream that carries all exported channels of a channel group (port),
+ * one channel per column of the signal block.
+ */
+template<typename T>
+class GroupStreamDataInfo
+{
+public:
+    explicit GroupStreamDataInfo()
+        : active(false)
+    {
+        signalBlock = std::make_shared<T>();
+    }
+
+    bool active;
+    std::shared_ptr<DataStream<T>> stream;
+    std::shared_ptr<T> signalBlock;
+    QStringList signalNames;
 };
 
 class IntanRhxModule : public AbstractModule
@@ -96,6 +125,15 @@ public:
     void setPortSignalBlockSampleSize(size_t sampleNum);
     std::vector<std::vector<StreamDataInfo<FloatSignalBlock>>> floatSdiByGroupChannel;
     std::vector<std::vector<StreamDataInfo<IntSignalBlock>>> intSdiByGroupChannel;
+    std::vector<GroupStreamDataInfo<FloatSignalBlock>> floatSdiByGroup;
+
+    // scratch space for the amplifier data conversion
+    std::vector<int> amplifierRawIndices;
+    std::vector<double *> amplifierColumns;
+
+    // scratch space for the raw block timestamps, and the ones adjusted by the synchronizer
+    VectorXul blockTimestamps;
+    VectorXul syncTimestamps;
 
     std::unique_ptr<FreqCounterSynchronizer> clockSync;
 
@@ -129,9 +167,12 @@ inline void syntalosModuleSetSignalBlocksTimestamps(IntanRhxModule *mod, const m
         return;
 
     // cast timestamps (uint32_t -> uint64_t) and assign them
-    VectorXul tvm(tsLen);
+    // (the blocks carry the raw device indices, this does not reallocate if the block size is unchanged)
+    auto &tvm = mod->blockTimestamps;
+    if (tvm.rows() != (Eigen::Index) tsLen)
+        tvm.resize(tsLen);
     for (size_t i = 0; i < tsLen; ++i)
-        tvm[i] = static_cast<uint64_t>(tsBuf[i]);
+        tvm[i] = static_cast<quint64>(tsBuf[i]);
 
     for (auto &blocks : mod->intSdiByGroupChannel) {
         for (auto &sdi : blocks) {
@@ -143,12 +184,19 @@ inline void syntalosModuleSetSignalBlocksTimestamps(IntanRhxModule *mod, const m
 
     for (auto &blocks : mod->floatSdiByGroupChannel) {
         for (auto &sdi : blocks) {
-            if (!sdi.active)
+            // grouped channels share the signal block of their group
+            if (!sdi.active || sdi.column >= 0)
                 continue;
             sdi.signalBlock->timestamps = tvm;
         }
     }
 
+    for (auto &gsdi : mod->floatSdiByGroup) {
+        if (!gsdi.active)
+            continue;
+        gsdi.signalBlock->timestamps = tvm;
+    }
+
     int currentBlockIdx = mod->currentBlockIdx;
     const auto blocksPerTimestamp = mod->blocksPerTimestamp;
     if (blockRecvTimestamp != mod->lastBlockTimestamp) {
@@ -160,15 +208,17 @@ inline void syntalosModuleSetSignalBlocksTimestamps(IntanRhxModule *mod, const m
             currentBlockIdx = blocksPerTimestamp;
     }
 
-    // calculate time sync guesstimates
+    // calculate time sync guesstimates, the adjusted indices are only used by the synchronizer
+    auto &syncTvm = mod->syncTimestamps;
+    if (syncTvm.rows() != (Eigen::Index) tsLen)
+        syncTvm.resize(tsLen);
     mod->clockSync->processTimestamps(blockRecvTimestamp,
                                       currentBlockIdx, blocksPerTimestamp,
-                                      tvm);
+                                      tsBuf, syncTvm.data(), tsLen);
     mod->currentBlockIdx = currentBlockIdx;
 }
 
-inline void syntalosModuleExportAmplifierChanData(IntanRhxModule *mod, int group, int channel, uint16_t *rawBuf, size_t numSamples,
-                                                  int numAmplifierChannels, int rawChanIndex)
+inline void syntalosModuleSetAmplifierChanRawIndex(IntanRhxModule *mod, int group, int channel, int rawChanIndex)
 {
     if (mod == nullptr)
         return;
@@ -182,12 +232,66 @@ inline void syntalosModuleExportAmplifierChanData(IntanRhxModule *mod, int group
     if (!sdi.active)
         return;
 
-    sdi.signalBlock->data.resize(numSamples, 1);
-    for (size_t i = 0; i < numSamples; ++i)
-        sdi.signalBlock->data(i, 0) = 0.195F * (((double) rawBuf[numAmplifierChannels * i + rawChanIndex]) - 32768.0F);
+    sdi.rawChanIndex = rawChanIndex;
+}
 
-    // publish new data on this stream
-    sdi.stream->push(*sdi.signalBlock.get());
+inline void syntalosModuleExportAmplifierData(IntanRhxModule *mod, uint16_t *rawBuf, size_t numSamples,
+                                              int numAmplifierChannels)
+{
+    if (mod == nullptr)
+        return;
+
+    // collect the output columns of all exported amplifier channels
+    auto &rawIndices = mod->amplifierRawIndices;
+    auto &columns = mod->amplifierColumns;
+    rawIndices.clear();
+    columns.clear();
+
+    for (auto &gsdi : mod->floatSdiByGroup) {
+        if (!gsdi.active)
+            continue;
+        if (gsdi.signalBlock->data.rows() != (Eigen::Index) numSamples)
+            gsdi.signalBlock->data.resize(numSamples, gsdi.signalNames.size());
+    }
+
+    for (auto &blocks : mod->floatSdiByGroupChannel) {
+        for (auto &sdi : blocks) {
+            if (!sdi.active)
+                continue;
+            if (sdi.rawChanIndex < 0) {
+                // we have no data for this channel yet, so don't publish garbage in its group column
+                if (sdi.column >= 0)
+                    sdi.signalBlock->data.col(sdi.column).setZero();
+                continue;
+            }
+            if (sdi.column < 0)
+                sdi.signalBlock->data.resize(numSamples, 1);
+            rawIndices.push_back(sdi.rawChanIndex);
+            columns.push_back(sdi.signalBlock->data.col(std::max(sdi.column, 0)).data());
+        }
+    }
+
+    if (columns.empty())
+        return;
+
+    // convert all channels in a single pass over the interleaved raw data
+    Syntalos::convertInterleavedRawToMicrovolts(rawBuf, numSamples, numAmplifierChannels,
+                                                rawIndices.data(), columns.data(), columns.size());
+
+    // publish new data on all streams
+    for (auto &blocks : mod->floatSdiByGroupChannel) {
+        for (auto &sdi : blocks) {
+            if (!sdi.active || sdi.rawChanIndex < 0 || sdi.column >= 0)
+                continue;
+            sdi.stream->push(*sdi.signalBlock.get());
+        }
+    }
+
+    for (auto &gsdi : mod->floatSdiByGroup) {
+        if (!gsdi.active)
+            continue;
+        gsdi.stream->push(*gsdi.signalBlock.get());
+    }
 }
 
 inline void syntalosModuleExportDigitalChanData(IntanRhxModule *mod, int group, int channel, float *rawBuf, size_t numSamples)
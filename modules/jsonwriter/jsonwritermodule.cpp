@@ -42,6 +42,7 @@ private:
     std::shared_ptr<StreamInputPort<TableRow>> m_rowsIn;
 
     std::shared_ptr<StreamSubscription<FloatSignalBlock>> m_floatSub;
+    std::shared_ptr<StreamSubscription<Float32SignalBlock>> m_float32Sub;
     std::shared_ptr<StreamSubscription<IntSignalBlock>> m_intSub;
     std::shared_ptr<StreamSubscription<TableRow>> m_rowSub;
 
@@ -62,6 +63,7 @@ public:
     {
         // Input ports for all the data we could potentially handle
         m_floatIn = registerInputPort<FloatSignalBlock>(QStringLiteral("fpsig1-in"), QStringLiteral("Float Signals"));
+        m_floatIn->acceptAlternativeType<Float32SignalBlock>();
         m_intIn = registerInputPort<IntSignalBlock>(QStringLiteral("intsig1-in"), QStringLiteral("Integer Signals"));
         m_rowsIn = registerInputPort<TableRow>(QStringLiteral("rows"), QStringLiteral("Table Rows"));
 
@@ -96,11 +98,22 @@ public:
         m_writeData = !isEphemeralRun();
 
         m_floatSub.reset();
+        m_float32Sub.reset();
         if (m_floatIn->hasSubscription()) {
-            m_floatSub = m_floatIn->subscription();
             m_isrcKind = InputSourceKind::FLOAT;
+            if (m_floatIn->subscriptionVar()->dataTypeId() == syDataTypeId<Float32SignalBlock>()) {
+                m_float32Sub = m_floatIn->subscriptionAs<Float32SignalBlock>();
 
-            registerDataReceivedEvent(&JSONWriterModule::onFloatSignalBlockReceived, m_floatSub);
+                // we drain all pending blocks per wakeup, so one notification per burst is enough
+                m_float32Sub->setNotifyMode(SubscriptionNotifyMode::Coalesced);
+                registerDataReceivedEvent(&JSONWriterModule::onFloat32SignalBlockReceived, m_float32Sub);
+            } else {
+                m_floatSub = m_floatIn->subscription();
+
+                // we drain all pending blocks per wakeup, so one notification per burst is enough
+                m_floatSub->setNotifyMode(SubscriptionNotifyMode::Coalesced);
+                registerDataReceivedEvent(&JSONWriterModule::onFloatSignalBlockReceived, m_floatSub);
+            }
         }
 
         bool excessConnections = false;
@@ -111,6 +124,8 @@ public:
                 excessConnections = true;
             m_isrcKind = InputSourceKind::INT;
 
+            // we drain all pending blocks per wakeup, so one notification per burst is enough
+            m_intSub->setNotifyMode(SubscriptionNotifyMode::Coalesced);
             registerDataReceivedEvent(&JSONWriterModule::onIntSignalBlockReceived, m_intSub);
         }
 
@@ -145,8 +160,9 @@ public:
         QStringList signalNames;
         switch (m_isrcKind) {
         case InputSourceKind::FLOAT:
-            mdata = m_floatSub->metadata();
-            signalNames = m_floatSub->metadataValue("signal_names", QStringList()).toStringList();
+            // the float port may be subscribed to either float signal block variant
+            mdata = m_floatIn->subscriptionVar()->metadata();
+            signalNames = m_floatIn->subscriptionVar()->metadataValue("signal_names", QStringList()).toStringList();
             break;
         case InputSourceKind::INT:
             mdata = m_intSub->metadata();
@@ -260,9 +276,9 @@ public:
 
         switch (m_isrcKind) {
         case InputSourceKind::FLOAT:
-            columns = m_floatSub->metadataValue("signal_names", QStringList()).toStringList();
-            timeUnit = m_floatSub->metadataValue("time_unit", QString()).toString();
-            dataUnit = m_floatSub->metadataValue("data_unit", QString()).toString();
+            columns = m_floatIn->subscriptionVar()->metadataValue("signal_names", QStringList()).toStringList();
+            timeUnit = m_floatIn->subscriptionVar()->metadataValue("time_unit", QString()).toString();
+            dataUnit = m_floatIn->subscriptionVar()->metadataValue("data_unit", QString()).toString();
             break;
         case InputSourceKind::INT:
             columns = m_intSub->metadataValue("signal_names", QStringList()).toStringList();
@@ -336,13 +352,24 @@ public:
 
     void onFloatSignalBlockReceived()
     {
-        auto maybeData = m_floatSub->peekNext();
-        if (!maybeData.has_value())
-            return;
-        const auto data = maybeData.value();
-        if (!m_writeData)
-            return;
+        // process the whole burst of pending blocks at once
+        m_floatSub->drainInto([this](const FloatSignalBlock &data) {
+            if (m_writeData)
+                writeFloatSignalBlock(data);
+        });
+    }
+
+    void onFloat32SignalBlockReceived()
+    {
+        m_float32Sub->drainInto([this](const Float32SignalBlock &data) {
+            if (m_writeData)
+                writeFloatSignalBlock(data);
+        });
+    }
 
+    template<typename T>
+    void writeFloatSignalBlock(const T &data)
+    {
         if (m_initFile)
             initJsonFile();
 
@@ -365,13 +392,14 @@ public:
 
     void onIntSignalBlockReceived()
     {
-        auto maybeData = m_intSub->peekNext();
-        if (!maybeData.has_value())
-            return;
-        const auto data = maybeData.value();
-        if (!m_writeData)
-            return;
+        m_intSub->drainInto([this](const IntSignalBlock &data) {
+            if (m_writeData)
+                writeIntSignalBlock(data);
+        });
+    }
 
+    void writeIntSignalBlock(const IntSignalBlock &data)
+    {
         if (m_initFile)
             initJsonFile();
 
@@ -64,6 +64,7 @@ public:
         m_bnoVecOut = registerOutputPort<FloatSignalBlock>(
             QStringLiteral("bno-raw-out"), QStringLiteral("Orientation Vector"));
         m_bnoTabOut = registerOutputPort<TableRow>(QStringLiteral("bno-tab-out"), QStringLiteral("Orientation Rows"));
+        registerSynchronizerTelemetryPort();
 
         m_bnoVecOut->setMetadataValue("time_unit", "milliseconds");
         m_bnoVecOut->setMetadataValue("data_unit", "au");
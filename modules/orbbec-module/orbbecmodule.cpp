@@ -134,6 +134,7 @@ public:
         m_depthDispOut = registerOutputPort<Frame>(
             QStringLiteral("depth-disp-out"), QStringLiteral("Display Depth Frames"));
         m_irOut = registerOutputPort<Frame>(QStringLiteral("ir-out"), QStringLiteral("IR Frames"));
+        registerSynchronizerTelemetryPort();
 
         m_settingsDialog = new OrbbecSettingsDialog();
         m_settingsDialog->setWindowIcon(modInfo->icon());
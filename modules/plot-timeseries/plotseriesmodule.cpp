@@ -50,6 +50,7 @@ class PlotSeriesModule : public AbstractModule
     Q_OBJECT
 private:
     std::vector<PlotSubscriptionDetails<FloatSignalBlock>> m_fpSubs;
+    std::vector<PlotSubscriptionDetails<Float32SignalBlock>> m_f32Subs;
     std::vector<PlotSubscriptionDetails<IntSignalBlock>> m_intSubs;
 
     PlotWindow *m_plotWindow;
@@ -86,6 +87,7 @@ public:
         m_active = false;
 
         m_fpSubs.clear();
+        m_f32Subs.clear();
         m_intSubs.clear();
         for (auto &port : inPorts()) {
             auto plotWidget = m_plotWindow->plotWidgetForPort(port->id());
@@ -115,6 +117,13 @@ public:
 
                 // prevent receiving more than 4k items/s to safeguard a bit against overflows
                 sdF.sub->setThrottleItemsPerSec(4000);
+            } else if (port->dataTypeName() == "Float32SignalBlock") {
+                PlotSubscriptionDetails<Float32SignalBlock> sdF(
+                    std::static_pointer_cast<StreamInputPort<Float32SignalBlock>>(port), plotWidget);
+                m_f32Subs.push_back(sdF);
+
+                // prevent receiving more than 4k items/s
+                sdF.sub->setThrottleItemsPerSec(4000);
             } else if (port->dataTypeName() == "IntSignalBlock") {
                 PlotSubscriptionDetails<IntSignalBlock> sdI(
                     std::static_pointer_cast<StreamInputPort<IntSignalBlock>>(port), plotWidget);
@@ -128,7 +137,7 @@ public:
         }
 
         // we are only active if we have something subscribed
-        if (!m_fpSubs.empty() || !m_intSubs.empty())
+        if (!m_fpSubs.empty() || !m_f32Subs.empty() || !m_intSubs.empty())
             m_active = true;
 
         // success
@@ -187,6 +196,9 @@ public:
         for (auto &sd : m_fpSubs)
             applyMetadataForSubscription(sd);
 
+        for (auto &sd : m_f32Subs)
+            applyMetadataForSubscription(sd);
+
         for (auto &sd : m_intSubs)
             applyMetadataForSubscription(sd);
     }
@@ -194,11 +206,17 @@ public:
     template<typename T>
     void processIncomingData(PlotSubscriptionDetails<T> &sd)
     {
-        auto maybeData = sd.sub->peekNext();
-        if (!maybeData.has_value())
-            return;
-        const auto data = maybeData.value();
+        // add all pending blocks in one go, stop adding data on error
+        bool failed = false;
+        sd.sub->drainInto([&](const T &data) {
+            if (!failed)
+                failed = !addBlockToPlot(sd, data);
+        });
+    }
 
+    template<typename T>
+    bool addBlockToPlot(PlotSubscriptionDetails<T> &sd, const T &data)
+    {
         sd.plotWidget->addToTimeseries(data.timestamps, sd.timestampDivisor);
 
         // sanity check
@@ -209,7 +227,7 @@ public:
                     .arg(sd.port->title())
                     .arg(sd.expectedSigSeriesCount)
                     .arg(data.data.cols()));
-            return;
+            return false;
         }
 
         // set the new data
@@ -220,10 +238,14 @@ public:
 
             if constexpr (std::is_same_v<T, IntSignalBlock>)
                 sd.plotWidget->addToSeriesI(seriesIdx, data.data.col(i));
+            else if constexpr (std::is_same_v<T, Float32SignalBlock>)
+                sd.plotWidget->addToSeriesF(seriesIdx, data.data.col(i).template cast<double>());
             else
                 sd.plotWidget->addToSeriesF(seriesIdx, data.data.col(i));
             seriesIdx++;
         }
+
+        return true;
     }
 
     void onSignalBlockReceived()
@@ -234,6 +256,9 @@ public:
         for (auto &sd : m_fpSubs)
             processIncomingData(sd);
 
+        for (auto &sd : m_f32Subs)
+            processIncomingData(sd);
+
         for (auto &sd : m_intSubs)
             processIncomingData(sd);
     }
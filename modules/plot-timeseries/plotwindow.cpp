@@ -300,6 +300,8 @@ void PlotWindow::on_addPortBtn_clicked()
     for (const auto &key : allStreamTypes.keys()) {
         if (key == "FloatSignalBlock")
             streamSignalTypeMap["Float"] = allStreamTypes[key];
+        else if (key == "Float32SignalBlock")
+            streamSignalTypeMap["Float32"] = allStreamTypes[key];
         else if (key == "IntSignalBlock")
             streamSignalTypeMap["Int"] = allStreamTypes[key];
     }
@@ -52,6 +52,7 @@ public:
             QStringLiteral("sensor-data-pressure"), QStringLiteral("Pressure Data"));
         m_tempStream = registerOutputPort<FloatSignalBlock>(
             QStringLiteral("sensor-data-temperature"), QStringLiteral("Temperature Data"));
+        registerSynchronizerTelemetryPort();
 
         m_settingsDlg = new SP210SettingsDialog;
         addSettingsWindow(m_settingsDlg);
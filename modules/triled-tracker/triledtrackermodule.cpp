@@ -108,6 +108,7 @@ public:
             if (!mFrame.has_value())
                 break;
             const auto frame = mFrame.value();
+            SY_TRACE_SCOPE("track frame");
 
             cv::Mat infoMat;
             cv::Mat trackMat;
@@ -118,7 +118,7 @@ void EncodeTask::run()
     std::vector<std::pair<long long, long long>> tsyncTimes;
     if (m_writeTsync) {
         TimeSyncFileReader tfr;
-        if (!tfr.open(m_tsyncSrcFname)) {
+        if (!tfr.openParallel(m_tsyncSrcFname, m_codecThreadCount)) {
             m_item->setError(
                 QStringLiteral("Unable to open tsync file of this video for reading: %1").arg(tfr.lastError()));
             return;
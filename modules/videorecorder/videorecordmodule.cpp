@@ -213,6 +213,9 @@ public:
         QString currentSecSuffix;
         int secCount = 0;
 
+        // last known file slice, to register new slices with our dataset
+        uint lastSliceNo = 1;
+
         // state of the recording - we are supposed to be running, unless explicitly
         // requested to be stopped
         auto state = m_startStopped ? RecordingState::STOPPED : RecordingState::RUNNING;
@@ -264,6 +267,10 @@ public:
                                                .arg(QString::fromStdString(m_videoWriter->lastError())));
                                 return;
                             }
+
+                            // register the new section file with our dataset
+                            lastSliceNo = m_videoWriter->fileSliceNumber();
+                            m_vidDataset->scheduleSave();
                         }
 
                         // resume normal operation
@@ -387,6 +394,7 @@ public:
                     encInfo.insert("target_quality", m_activeCodecProps.quality());
                 m_vidDataset->insertAttribute(QStringLiteral("video"), vInfo);
                 m_vidDataset->insertAttribute(QStringLiteral("encoder"), encInfo);
+                m_vidDataset->scheduleSave();
 
                 // signal that we are actually recording this session
                 m_initDone = true;
@@ -397,6 +405,7 @@ public:
             }
 
             // encode current frame
+            SY_TRACE_SCOPE("encode frame");
             if (!m_videoWriter->encodeFrame(frame.mat, frame.time)) {
                 if (m_videoWriter->lastError().empty())
                     raiseError(QStringLiteral("Unable to encode frame"));
@@ -405,6 +414,12 @@ public:
                 m_running = false;
                 break;
             }
+
+            // the writer started a new file slice, so update our dataset
+            if (m_videoWriter->fileSliceNumber() != lastSliceNo) {
+                lastSliceNo = m_videoWriter->fileSliceNumber();
+                m_vidDataset->scheduleSave();
+            }
         }
 
         m_recordingFinished = true;
@@ -477,9 +492,10 @@ public:
                                      : QStringLiteral("%1 @ %2 on %3")
                                            .arg(m_subjectName, m_vidDataset->name(), time.toString("HH:mm yy-MM-dd"));
 
-        // we need to explicitly save the dataset here to ensure any globs are finalized into
-        // actual data- and aux file parts.
-        m_vidDataset->save();
+        // we need to explicitly resolve the scan patterns here to ensure any globs are finalized into
+        // actual data- and aux file parts. Writing the manifest can happen in the background.
+        m_vidDataset->applyScanPatterns();
+        m_vidDataset->scheduleSave();
 
         // schedule encoding jobs in the external encoder process
         for (auto &dataPart : m_vidDataset->dataFile().parts) {
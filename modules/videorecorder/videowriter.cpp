@@ -1413,6 +1413,11 @@ void VideoWriter::setFileSliceInterval(uint minutes)
     d->fileSliceIntervalMin = minutes;
 }
 
+uint VideoWriter::fileSliceNumber() const
+{
+    return d->currentSliceNo;
+}
+
 std::string VideoWriter::lastError() const
 {
     return d->lastError;
@@ -199,6 +199,7 @@ public:
 
     uint fileSliceInterval() const;
     void setFileSliceInterval(uint minutes);
+    uint fileSliceNumber() const;
 
     std::string lastError() const;
 
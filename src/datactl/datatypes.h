@@ -20,6 +20,7 @@
 #pragma once
 
 #include <QDataStream>
+#include <QDebug>
 #include <QMetaType>
 #include <QMetaEnum>
 #include <memory>
@@ -68,6 +69,21 @@ Q_DECLARE_METATYPE(ConnectionHeatLevel)
 
 QString connectionHeatToHumanString(ConnectionHeatLevel heat);
 
+/**
+ * @brief Buffer state of a connection
+ *
+ * Details about the data that is pending in the buffer of a
+ * connection, and how quickly it grows.
+ */
+struct ConnectionHeatInfo {
+    ConnectionHeatLevel level = ConnectionHeatLevel::NONE;
+    size_t pendingCount = 0;        /// number of pending elements
+    size_t pendingBytes = 0;        /// approximate memory used by the pending elements
+    double growthBytesPerSec = 0;   /// rate at which the buffer grows (or shrinks, if negative)
+    double memoryExhaustedSec = -1; /// predicted time until system memory runs out at this rate, -1 if not growing
+};
+Q_DECLARE_METATYPE(ConnectionHeatInfo)
+
 /**
  * @brief The ModuleState enum
  *
@@ -111,6 +127,7 @@ public:
         FirmataData,
         IntSignalBlock,
         FloatSignalBlock,
+        Float32SignalBlock,
         Last
     };
     Q_ENUM(TypeId)
@@ -501,25 +518,33 @@ struct IntSignalBlock : BaseDataType {
     VectorXul timestamps;
     MatrixXsi data;
 
-    QByteArray toBytes() const override
+    ssize_t memorySize() const override
     {
-        QByteArray bytes;
-        QDataStream stream(&bytes, QIODevice::WriteOnly);
+        return timestampedMatrixMemorySize(timestamps, data);
+    }
 
-        serializeEigen(stream, timestamps);
-        serializeEigen(stream, data);
+    bool writeToMemory(void *memory, ssize_t size = -1) const override
+    {
+        if (size < 0)
+            size = memorySize();
+        return writeTimestampedMatrix(memory, size, timestamps, data);
+    }
 
+    QByteArray toBytes() const override
+    {
+        QByteArray bytes(memorySize(), Qt::Uninitialized);
+        writeToMemory(bytes.data(), bytes.size());
         return bytes;
     }
 
     static IntSignalBlock fromMemory(const void *memory, size_t size)
     {
         IntSignalBlock obj;
-        QByteArray block(reinterpret_cast<const char *>(memory), size);
-        QDataStream stream(block);
-
-        obj.timestamps = deserializeEigen<VectorXul>(stream);
-        obj.data = deserializeEigen<MatrixXsi>(stream);
+        if (!readTimestampedMatrix(memory, size, obj.timestamps, obj.data)) {
+            qWarning().noquote().nospace() << "Received invalid IntSignalBlock data (" << size << " bytes)";
+            obj.timestamps.resize(0);
+            obj.data.resize(0, 1);
+        }
 
         return obj;
     }
@@ -566,25 +591,108 @@ struct FloatSignalBlock : BaseDataType {
     VectorXul timestamps;
     MatrixXd data;
 
-    QByteArray toBytes() const override
+    ssize_t memorySize() const override
     {
-        QByteArray bytes;
-        QDataStream stream(&bytes, QIODevice::WriteOnly);
+        return timestampedMatrixMemorySize(timestamps, data);
+    }
 
-        serializeEigen(stream, timestamps);
-        serializeEigen(stream, data);
+    bool writeToMemory(void *memory, ssize_t size = -1) const override
+    {
+        if (size < 0)
+            size = memorySize();
+        return writeTimestampedMatrix(memory, size, timestamps, data);
+    }
 
+    QByteArray toBytes() const override
+    {
+        QByteArray bytes(memorySize(), Qt::Uninitialized);
+        writeToMemory(bytes.data(), bytes.size());
         return bytes;
     }
 
     static FloatSignalBlock fromMemory(const void *memory, size_t size)
     {
         FloatSignalBlock obj;
-        QByteArray block(reinterpret_cast<const char *>(memory), size);
-        QDataStream stream(block);
+        if (!readTimestampedMatrix(memory, size, obj.timestamps, obj.data)) {
+            qWarning().noquote().nospace() << "Received invalid FloatSignalBlock data (" << size << " bytes)";
+            obj.timestamps.resize(0);
+            obj.data.resize(0, 1);
+        }
+
+        return obj;
+    }
+};
 
-        obj.timestamps = deserializeEigen<VectorXul>(stream);
-        obj.data = deserializeEigen<MatrixXd>(stream);
+/**
+ * @brief A block of single-precision floating-point signal data
+ *
+ * Same as FloatSignalBlock, but stores its data with single precision. Most analog
+ * data sources deliver single-precision values, so this type halves memory use and
+ * transfer size for them without losing any precision.
+ * Modules can use toFloatSignalBlock() to convert to the double-precision variant.
+ */
+struct Float32SignalBlock : BaseDataType {
+    SY_DEFINE_DATA_TYPE(Float32SignalBlock)
+
+    explicit Float32SignalBlock(uint sampleCount = 60, uint channelCount = 1)
+    {
+        Q_ASSERT(channelCount > 0);
+        timestamps.resize(sampleCount);
+        data.resize(sampleCount, channelCount);
+    }
+
+    size_t length() const
+    {
+        return timestamps.size();
+    }
+
+    size_t rows() const
+    {
+        return data.rows();
+    }
+    size_t cols() const
+    {
+        return data.cols();
+    }
+
+    ::FloatSignalBlock toFloatSignalBlock() const
+    {
+        ::FloatSignalBlock block(0, 1);
+        block.timestamps = timestamps;
+        block.data = data.cast<double>();
+        return block;
+    }
+
+    VectorXul timestamps;
+    MatrixXf data;
+
+    ssize_t memorySize() const override
+    {
+        return timestampedMatrixMemorySize(timestamps, data);
+    }
+
+    bool writeToMemory(void *memory, ssize_t size = -1) const override
+    {
+        if (size < 0)
+            size = memorySize();
+        return writeTimestampedMatrix(memory, size, timestamps, data);
+    }
+
+    QByteArray toBytes() const override
+    {
+        QByteArray bytes(memorySize(), Qt::Uninitialized);
+        writeToMemory(bytes.data(), bytes.size());
+        return bytes;
+    }
+
+    static Float32SignalBlock fromMemory(const void *memory, size_t size)
+    {
+        Float32SignalBlock obj;
+        if (!readTimestampedMatrix(memory, size, obj.timestamps, obj.data)) {
+            qWarning().noquote().nospace() << "Received invalid Float32SignalBlock data (" << size << " bytes)";
+            obj.timestamps.resize(0);
+            obj.data.resize(0, 1);
+        }
 
         return obj;
     }
@@ -0,0 +1,560 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "edlindex.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThread>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+
+#include "utils/tomlutils.h"
+
+/**
+ * Name of the index file placed in the root directory of each collection.
+ */
+static const QString EDL_INDEX_FILENAME = QStringLiteral(".edl-index.json");
+
+/**
+ * Version of the index file format, bumped whenever the cached data changes.
+ */
+static const int EDL_INDEX_VERSION = 1;
+
+namespace
+{
+
+class FunctionRunnable : public QRunnable
+{
+public:
+    explicit FunctionRunnable(std::function<void()> func)
+        : m_func(std::move(func))
+    {
+    }
+
+    void run() override
+    {
+        m_func();
+    }
+
+private:
+    std::function<void()> m_func;
+};
+
+/**
+ * Modification state of an EDL unit directory, used to decide whether
+ * cached data about the unit is still valid.
+ */
+struct UnitStamp {
+    QString path; // relative to the collection root
+    qint64 dirMTime;
+    qint64 manifestMTime;
+    qint64 manifestSize;
+};
+
+QStringList listUnitDirs(const QString &dir)
+{
+    QDir d(dir);
+    return d.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+}
+
+UnitStamp stampForUnit(const QString &root, const QString &relPath)
+{
+    UnitStamp stamp;
+    stamp.path = relPath;
+
+    const auto unitDir = relPath.isEmpty() ? root : QStringLiteral("%1/%2").arg(root, relPath);
+    QFileInfo dirInfo(unitDir);
+    QFileInfo manifestInfo(QStringLiteral("%1/manifest.toml").arg(unitDir));
+    stamp.dirMTime = dirInfo.exists() ? dirInfo.lastModified().toMSecsSinceEpoch() : -1;
+    stamp.manifestMTime = manifestInfo.exists() ? manifestInfo.lastModified().toMSecsSinceEpoch() : -1;
+    stamp.manifestSize = manifestInfo.exists() ? manifestInfo.size() : -1;
+
+    return stamp;
+}
+
+QString joinRelPath(const QString &parent, const QString &name)
+{
+    return parent.isEmpty() ? name : QStringLiteral("%1/%2").arg(parent, name);
+}
+
+} // namespace
+
+/**
+ * Cached data of a collection, as stored in its index file.
+ */
+struct IndexedCollection {
+    EDLCollectionInfo info;
+    QStringList rootDirs;
+    QList<UnitStamp> stamps;
+};
+
+class EDLCollectionIndex::Private
+{
+public:
+    Private()
+        : threadCount(QThread::idealThreadCount()),
+          writeIndexFiles(true)
+    {
+    }
+
+    int threadCount;
+    bool writeIndexFiles;
+
+    QStringList paths;
+    QHash<QString, EDLCollectionInfo> loaded;
+    QString lastError;
+
+    QMutex errorMutex;
+};
+
+static bool isCollectionValid(const IndexedCollection &ic, const QString &root)
+{
+    // the collection's root directory also contains the index file itself, so
+    // rewriting the index changes its mtime - we compare its subdirectories instead
+    if (listUnitDirs(root) != ic.rootDirs)
+        return false;
+
+    for (const auto &stamp : ic.stamps) {
+        const auto current = stampForUnit(root, stamp.path);
+        if (current.manifestMTime != stamp.manifestMTime || current.manifestSize != stamp.manifestSize)
+            return false;
+        // the directory mtime tells us about added or removed units and data files
+        if (!stamp.path.isEmpty() && current.dirMTime != stamp.dirMTime)
+            return false;
+    }
+
+    return true;
+}
+
+static QJsonObject datasetInfoToJson(const EDLDatasetInfo &ds)
+{
+    QJsonObject obj;
+    obj.insert("name", ds.name);
+    obj.insert("path", ds.path);
+    obj.insert("generator", ds.generatorId);
+    obj.insert("time_created", ds.timeCreated.toString(Qt::ISODate));
+    obj.insert("media_type", ds.mediaType);
+    obj.insert("file_type", ds.fileType);
+    obj.insert("data_parts", QJsonArray::fromStringList(ds.dataParts));
+    obj.insert("data_size", ds.dataSize);
+    return obj;
+}
+
+static EDLDatasetInfo datasetInfoFromJson(const QJsonObject &obj, const EDLCollectionInfo &col)
+{
+    EDLDatasetInfo ds;
+    ds.name = obj.value("name").toString();
+    ds.path = obj.value("path").toString();
+    ds.generatorId = obj.value("generator").toString();
+    ds.timeCreated = QDateTime::fromString(obj.value("time_created").toString(), Qt::ISODate);
+    ds.mediaType = obj.value("media_type").toString();
+    ds.fileType = obj.value("file_type").toString();
+    for (const auto &v : obj.value("data_parts").toArray())
+        ds.dataParts.append(v.toString());
+    ds.dataSize = obj.value("data_size").toVariant().toLongLong();
+
+    ds.collectionPath = col.path;
+    ds.collectionId = col.collectionId;
+    return ds;
+}
+
+static std::optional<IndexedCollection> readIndexFile(const QString &root)
+{
+    QFile file(QStringLiteral("%1/%2").arg(root, EDL_INDEX_FILENAME));
+    if (!file.open(QIODevice::ReadOnly))
+        return std::nullopt;
+
+    const auto doc = QJsonDocument::fromJson(file.readAll());
+    if (!doc.isObject())
+        return std::nullopt;
+    const auto root_obj = doc.object();
+    if (root_obj.value("version").toInt() != EDL_INDEX_VERSION)
+        return std::nullopt;
+
+    IndexedCollection ic;
+    ic.info.path = root;
+    ic.info.name = root_obj.value("name").toString();
+    ic.info.collectionId = QUuid(root_obj.value("collection_id").toString());
+    ic.info.timeCreated = QDateTime::fromString(root_obj.value("time_created").toString(), Qt::ISODate);
+    ic.info.generatorId = root_obj.value("generator").toString();
+    for (const auto &v : root_obj.value("groups").toArray())
+        ic.info.groups.append(v.toString());
+    for (const auto &v : root_obj.value("datasets").toArray())
+        ic.info.datasets.append(datasetInfoFromJson(v.toObject(), ic.info));
+
+    for (const auto &v : root_obj.value("root_dirs").toArray())
+        ic.rootDirs.append(v.toString());
+    for (const auto &v : root_obj.value("units").toArray()) {
+        const auto obj = v.toObject();
+        UnitStamp stamp;
+        stamp.path = obj.value("path").toString();
+        stamp.dirMTime = obj.value("dir_mtime").toVariant().toLongLong();
+        stamp.manifestMTime = obj.value("manifest_mtime").toVariant().toLongLong();
+        stamp.manifestSize = obj.value("manifest_size").toVariant().toLongLong();
+        ic.stamps.append(stamp);
+    }
+
+    return ic;
+}
+
+static bool writeIndexFile(const IndexedCollection &ic, QString &errorMessage)
+{
+    QJsonObject root_obj;
+    root_obj.insert("version", EDL_INDEX_VERSION);
+    root_obj.insert("name", ic.info.name);
+    root_obj.insert("collection_id", ic.info.collectionId.toString(QUuid::WithoutBraces));
+    root_obj.insert("time_created", ic.info.timeCreated.toString(Qt::ISODate));
+    root_obj.insert("generator", ic.info.generatorId);
+    root_obj.insert("groups", QJsonArray::fromStringList(ic.info.groups));
+
+    QJsonArray datasetsArr;
+    for (const auto &ds : ic.info.datasets)
+        datasetsArr.append(datasetInfoToJson(ds));
+    root_obj.insert("datasets", datasetsArr);
+
+    root_obj.insert("root_dirs", QJsonArray::fromStringList(ic.rootDirs));
+    QJsonArray unitsArr;
+    for (const auto &stamp : ic.stamps) {
+        QJsonObject obj;
+        obj.insert("path", stamp.path);
+        obj.insert("dir_mtime", stamp.dirMTime);
+        obj.insert("manifest_mtime", stamp.manifestMTime);
+        obj.insert("manifest_size", stamp.manifestSize);
+        unitsArr.append(obj);
+    }
+    root_obj.insert("units", unitsArr);
+
+    QSaveFile file(QStringLiteral("%1/%2").arg(ic.info.path, EDL_INDEX_FILENAME));
+    if (!file.open(QIODevice::WriteOnly)) {
+        errorMessage = file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root_obj).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        errorMessage = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+static void readDataSection(const QVariantHash &dataSection, const QString &unitDir, EDLDatasetInfo &ds)
+{
+    ds.mediaType = dataSection.value("media_type").toString();
+    ds.fileType = dataSection.value("file_type").toString();
+
+    for (const auto &partVar : dataSection.value("parts").toList()) {
+        const auto fname = partVar.toHash().value("fname").toString();
+        if (fname.isEmpty())
+            continue;
+        ds.dataParts.append(fname);
+
+        QFileInfo fi(QStringLiteral("%1/%2").arg(unitDir, fname));
+        if (fi.exists())
+            ds.dataSize += fi.size();
+    }
+}
+
+/**
+ * Data files may grow in place without their directory or manifest changing,
+ * so the sizes of a cached collection are always determined anew.
+ */
+static void updateDataSizes(EDLCollectionInfo &col)
+{
+    for (auto &ds : col.datasets) {
+        const auto unitDir = QStringLiteral("%1/%2").arg(col.path, ds.path);
+        ds.dataSize = 0;
+        for (const auto &fname : ds.dataParts) {
+            QFileInfo fi(QStringLiteral("%1/%2").arg(unitDir, fname));
+            if (fi.exists())
+                ds.dataSize += fi.size();
+        }
+    }
+}
+
+/**
+ * Read all manifests of the collection at @root and build a fresh index for it.
+ */
+static std::optional<IndexedCollection> buildIndex(const QString &root, QString &errorMessage)
+{
+    IndexedCollection ic;
+    ic.info.path = root;
+    ic.info.name = QFileInfo(root).fileName();
+
+    // stamp the root before reading anything, so modifications while we read invalidate the index
+    ic.rootDirs = listUnitDirs(root);
+    ic.stamps.append(stampForUnit(root, QString()));
+
+    const auto rootManifest = parseTomlFile(QStringLiteral("%1/manifest.toml").arg(root), errorMessage);
+    if (!errorMessage.isEmpty())
+        return std::nullopt;
+    if (rootManifest.value("type").toString() != QStringLiteral("collection")) {
+        errorMessage = QStringLiteral("Directory '%1' is not an EDL collection.").arg(root);
+        return std::nullopt;
+    }
+
+    ic.info.collectionId = QUuid(rootManifest.value("collection_id").toString());
+    ic.info.timeCreated = rootManifest.value("time_created").toDateTime();
+    ic.info.generatorId = rootManifest.value("generator").toString();
+
+    // walk the tree of groups and datasets
+    QStringList pending;
+    for (const auto &name : ic.rootDirs)
+        pending.append(name);
+    while (!pending.isEmpty()) {
+        const auto relPath = pending.takeFirst();
+        const auto unitDir = QStringLiteral("%1/%2").arg(root, relPath);
+
+        // directories without a manifest are not EDL units, but we still track
+        // them so a manifest appearing later invalidates the index
+        const auto stamp = stampForUnit(root, relPath);
+        ic.stamps.append(stamp);
+        if (stamp.manifestMTime < 0)
+            continue;
+
+        QString unitError;
+        const auto manifest = parseTomlFile(QStringLiteral("%1/manifest.toml").arg(unitDir), unitError);
+        if (!unitError.isEmpty()) {
+            qWarning().noquote() << "EDL:" << "Unable to read manifest of" << unitDir << "-" << unitError;
+            continue;
+        }
+
+        const auto kind = manifest.value("type").toString();
+        if (kind == QStringLiteral("group")) {
+            ic.info.groups.append(relPath);
+            for (const auto &name : listUnitDirs(unitDir))
+                pending.append(joinRelPath(relPath, name));
+        } else if (kind == QStringLiteral("dataset")) {
+            EDLDatasetInfo ds;
+            ds.name = QFileInfo(unitDir).fileName();
+            ds.path = relPath;
+            ds.generatorId = manifest.value("generator").toString();
+            ds.timeCreated = manifest.value("time_created").toDateTime();
+            ds.collectionPath = root;
+            ds.collectionId = ic.info.collectionId;
+            if (manifest.contains("data"))
+                readDataSection(manifest.value("data").toHash(), unitDir, ds);
+            ic.info.datasets.append(ds);
+        }
+    }
+
+    return ic;
+}
+
+EDLCollectionIndex::EDLCollectionIndex()
+    : d(new EDLCollectionIndex::Private)
+{
+}
+
+EDLCollectionIndex::~EDLCollectionIndex() {}
+
+/**
+ * Set the maximum number of threads used to read collections without a valid index.
+ */
+void EDLCollectionIndex::setThreadCount(int count)
+{
+    d->threadCount = std::max(1, count);
+}
+
+/**
+ * Set whether index files should be written to collections after they were read.
+ * This is enabled by default, collections on read-only media will simply not be
+ * cached.
+ */
+void EDLCollectionIndex::setWriteIndexFiles(bool write)
+{
+    d->writeIndexFiles = write;
+}
+
+/**
+ * Register a single collection with this index. The collection is only read
+ * once it is queried.
+ */
+bool EDLCollectionIndex::addCollection(const QString &path)
+{
+    const auto absPath = QFileInfo(path).absoluteFilePath();
+    if (!QFileInfo::exists(QStringLiteral("%1/manifest.toml").arg(absPath))) {
+        d->lastError = QStringLiteral("Directory '%1' does not contain an EDL manifest.").arg(path);
+        return false;
+    }
+    if (!d->paths.contains(absPath))
+        d->paths.append(absPath);
+
+    return true;
+}
+
+/**
+ * Register all collections that are direct children of @dir with this index.
+ * Returns the number of collections that were found.
+ */
+int EDLCollectionIndex::addDirectory(const QString &dir)
+{
+    int count = 0;
+    const auto absDir = QFileInfo(dir).absoluteFilePath();
+    for (const auto &name : listUnitDirs(absDir)) {
+        const auto path = QStringLiteral("%1/%2").arg(absDir, name);
+        if (!QFileInfo::exists(QStringLiteral("%1/manifest.toml").arg(path)))
+            continue;
+        if (!d->paths.contains(path))
+            d->paths.append(path);
+        count++;
+    }
+
+    return count;
+}
+
+QStringList EDLCollectionIndex::collectionPaths() const
+{
+    return d->paths;
+}
+
+void EDLCollectionIndex::loadCollections(const QStringList &paths)
+{
+    QStringList missing;
+    for (const auto &path : paths) {
+        if (!d->loaded.contains(path))
+            missing.append(path);
+    }
+    if (missing.isEmpty())
+        return;
+
+    QVector<std::optional<EDLCollectionInfo>> results(missing.length());
+    std::atomic_int nextIndex(0);
+    auto loadWorker = [&]() {
+        int i;
+        while ((i = nextIndex.fetch_add(1)) < missing.length()) {
+            const auto &root = missing[i];
+
+            auto ic = readIndexFile(root);
+            if (ic.has_value() && isCollectionValid(ic.value(), root)) {
+                updateDataSizes(ic->info);
+                results[i] = ic->info;
+                continue;
+            }
+
+            QString errorMessage;
+            ic = buildIndex(root, errorMessage);
+            if (!ic.has_value()) {
+                QMutexLocker locker(&d->errorMutex);
+                d->lastError = QStringLiteral("Unable to read collection '%1': %2").arg(root, errorMessage);
+                continue;
+            }
+            results[i] = ic->info;
+
+            if (d->writeIndexFiles && !writeIndexFile(ic.value(), errorMessage))
+                qDebug().noquote() << "EDL:" << "Unable to write index for" << root << "-" << errorMessage;
+        }
+    };
+
+    const auto workerCount = std::min(d->threadCount, (int)missing.length());
+    if (workerCount <= 1) {
+        loadWorker();
+    } else {
+        QThreadPool pool;
+        pool.setMaxThreadCount(workerCount - 1);
+        for (int i = 0; i < workerCount - 1; i++)
+            pool.start(new FunctionRunnable(loadWorker));
+
+        // the calling thread reads collections as well
+        loadWorker();
+        pool.waitForDone();
+    }
+
+    for (int i = 0; i < missing.length(); i++) {
+        if (results[i].has_value())
+            d->loaded.insert(missing[i], results[i].value());
+    }
+}
+
+/**
+ * Get information about the collection at @path, reading it if necessary.
+ * The collection does not have to be registered with this index before.
+ */
+std::optional<EDLCollectionInfo> EDLCollectionIndex::collection(const QString &path)
+{
+    const auto absPath = QFileInfo(path).absoluteFilePath();
+    if (!d->paths.contains(absPath) && !addCollection(absPath))
+        return std::nullopt;
+
+    loadCollections(QStringList() << absPath);
+    if (!d->loaded.contains(absPath))
+        return std::nullopt;
+    return d->loaded.value(absPath);
+}
+
+/**
+ * Get information about all registered collections.
+ * Collections which can not be read are skipped.
+ */
+QList<EDLCollectionInfo> EDLCollectionIndex::collections()
+{
+    loadCollections(d->paths);
+
+    QList<EDLCollectionInfo> result;
+    for (const auto &path : d->paths) {
+        if (d->loaded.contains(path))
+            result.append(d->loaded.value(path));
+    }
+
+    return result;
+}
+
+/**
+ * Find all datasets that were created by the generator @generatorId (for datasets
+ * recorded by Syntalos, this is the ID of the module that created them).
+ * If @start or @end are valid, only datasets created within this timespan are returned.
+ * An empty @generatorId matches all datasets.
+ */
+QList<EDLDatasetInfo> EDLCollectionIndex::findDatasets(
+    const QString &generatorId,
+    const QDateTime &start,
+    const QDateTime &end)
+{
+    QList<EDLDatasetInfo> result;
+    for (const auto &col : collections()) {
+        for (const auto &ds : col.datasets) {
+            if (!generatorId.isEmpty() && ds.generatorId != generatorId)
+                continue;
+
+            const auto time = ds.timeCreated.isValid() ? ds.timeCreated : col.timeCreated;
+            if (start.isValid() && time < start)
+                continue;
+            if (end.isValid() && time > end)
+                continue;
+
+            result.append(ds);
+        }
+    }
+
+    return result;
+}
+
+QString EDLCollectionIndex::lastError() const
+{
+    return d->lastError;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QUuid>
+#include <memory>
+#include <optional>
+
+/**
+ * @brief Summary of a dataset in an existing EDL collection
+ */
+class EDLDatasetInfo
+{
+public:
+    explicit EDLDatasetInfo()
+        : dataSize(0)
+    {
+    }
+
+    QString name;
+    QString path;      /// path of the dataset, relative to its collection
+    QString generatorId;
+    QDateTime timeCreated;
+    QString mediaType; /// media type of the primary data, if known
+    QString fileType;  /// file type of the primary data, if known
+    QStringList dataParts;
+    qint64 dataSize; /// size of all primary data parts on disk, in bytes
+
+    QString collectionPath;
+    QUuid collectionId;
+};
+
+/**
+ * @brief Summary of an existing EDL collection
+ */
+class EDLCollectionInfo
+{
+public:
+    explicit EDLCollectionInfo() {}
+
+    QString name;
+    QString path;
+    QUuid collectionId;
+    QDateTime timeCreated;
+    QString generatorId;
+    QStringList groups; /// paths of all groups, relative to the collection
+    QList<EDLDatasetInfo> datasets;
+};
+
+/**
+ * @brief Index of existing EDL collections
+ *
+ * Reads the structure of existing EDL collections without parsing all of their
+ * manifests every time: The contents of each collection are cached in an index file
+ * in the collection's directory, which is only rebuilt if any manifest or directory
+ * of the collection was modified since the index was written.
+ *
+ * Collections are only read once they are requested, and collections without a valid
+ * index are read in parallel.
+ */
+class EDLCollectionIndex
+{
+public:
+    explicit EDLCollectionIndex();
+    ~EDLCollectionIndex();
+
+    void setThreadCount(int count);
+    void setWriteIndexFiles(bool write);
+
+    bool addCollection(const QString &path);
+    int addDirectory(const QString &dir);
+    QStringList collectionPaths() const;
+
+    std::optional<EDLCollectionInfo> collection(const QString &path);
+    QList<EDLCollectionInfo> collections();
+
+    QList<EDLDatasetInfo> findDatasets(
+        const QString &generatorId,
+        const QDateTime &start = QDateTime(),
+        const QDateTime &end = QDateTime());
+
+    QString lastError() const;
+
+private:
+    class Private;
+    Q_DISABLE_COPY(EDLCollectionIndex)
+    std::unique_ptr<Private> d;
+
+    void loadCollections(const QStringList &paths);
+};
@@ -23,11 +23,17 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QMimeDatabase>
+#include <QSaveFile>
 #include <QUuid>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <mutex>
+#include <thread>
 #include <toml++/toml.h>
 
 #include "utils/misc.h"
@@ -43,10 +49,135 @@ static QString edlSanitizeFilename(const QString &name)
     return tmp;
 }
 
+/**
+ * Time the background save worker waits after a unit was scheduled for saving,
+ * so repeated save requests for the same unit are merged into a single write.
+ */
+static constexpr auto EDL_SAVE_BATCH_DELAY = std::chrono::milliseconds(500);
+
+/**
+ * @brief Saves EDL units on a background thread
+ */
+class EDLSaveWorker
+{
+public:
+    static EDLSaveWorker *instance()
+    {
+        static EDLSaveWorker worker;
+        return &worker;
+    }
+
+    ~EDLSaveWorker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        if (m_thread.joinable())
+            m_thread.join();
+    }
+
+    void schedule(EDLUnit *unit)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (std::find(m_queue.begin(), m_queue.end(), unit) != m_queue.end())
+                return;
+            m_queue.push_back(unit);
+            if (!m_thread.joinable())
+                m_thread = std::thread(&EDLSaveWorker::run, this);
+        }
+        m_cond.notify_all();
+    }
+
+    /**
+     * Remove a unit from the queue, and wait for it to be saved if that is happening right now.
+     */
+    void cancel(EDLUnit *unit)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_queue.erase(std::remove(m_queue.begin(), m_queue.end(), unit), m_queue.end());
+        m_idleCond.wait(lock, [&] {
+            return m_current != unit;
+        });
+    }
+
+private:
+    EDLSaveWorker()
+        : m_current(nullptr),
+          m_stop(false)
+    {
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_cond.wait(lock, [&] {
+                return m_stop || !m_queue.empty();
+            });
+            if (m_queue.empty())
+                break;
+
+            // give modules some time to register more changes before we write anything
+            if (!m_stop)
+                m_cond.wait_for(lock, EDL_SAVE_BATCH_DELAY, [&] {
+                    return m_stop;
+                });
+
+            while (!m_queue.empty()) {
+                m_current = m_queue.front();
+                m_queue.pop_front();
+
+                lock.unlock();
+                if (!m_current->save())
+                    qWarning().noquote() << "EDL: Unable to save" << m_current->name() << "in the background:"
+                                         << m_current->lastError();
+                lock.lock();
+
+                m_current = nullptr;
+                m_idleCond.notify_all();
+            }
+        }
+    }
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::condition_variable m_idleCond;
+    std::deque<EDLUnit *> m_queue;
+    EDLUnit *m_current;
+    bool m_stop;
+};
+
+static bool edlWriteFileAtomic(const QString &fname, const QString &data, QString &errorMessage)
+{
+    // write to a temporary file first, and only replace the existing file once all data has been written
+    QSaveFile file(fname);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        errorMessage = file.errorString();
+        return false;
+    }
+
+    file.write(data.toUtf8());
+    if (!file.commit()) {
+        errorMessage = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
 class EDLUnit::Private
 {
 public:
-    Private() {}
+    Private()
+        : manifestDirty(true),
+          attrsDirty(true),
+          saveScheduled(false)
+    {
+    }
     ~Private() {}
 
     EDLUnitKind objectKind;
@@ -67,7 +198,12 @@ public:
 
     QString lastError;
 
+    bool manifestDirty;
+    bool attrsDirty;
+    std::atomic_bool saveScheduled;
+
     std::mutex mutex;
+    std::mutex saveMutex;
 };
 
 EDLUnit::EDLUnit(EDLUnitKind kind, EDLUnit *parent)
@@ -78,7 +214,10 @@ EDLUnit::EDLUnit(EDLUnitKind kind, EDLUnit *parent)
     d->parent = parent;
 }
 
-EDLUnit::~EDLUnit() {}
+EDLUnit::~EDLUnit()
+{
+    cancelScheduledSave();
+}
 
 EDLUnitKind EDLUnit::objectKind() const
 {
@@ -120,6 +259,8 @@ bool EDLUnit::setName(const QString &name)
     d->name = edlSanitizeFilename(name);
     if (d->name.isEmpty())
         d->name = createRandomString(4);
+    d->manifestDirty = true;
+    d->attrsDirty = true;
 
     if (!oldDirPath.isEmpty()) {
         QDir dir;
@@ -141,7 +282,9 @@ QDateTime EDLUnit::timeCreated() const
 
 void EDLUnit::setTimeCreated(const QDateTime &time)
 {
+    const std::lock_guard<std::mutex> lock(d->mutex);
     d->timeCreated = time;
+    d->manifestDirty = true;
 }
 
 QUuid EDLUnit::collectionId() const
@@ -151,7 +294,9 @@ QUuid EDLUnit::collectionId() const
 
 void EDLUnit::setCollectionId(const QUuid &uuid)
 {
+    const std::lock_guard<std::mutex> lock(d->mutex);
     d->collectionId = uuid;
+    d->manifestDirty = true;
 }
 
 /**
@@ -165,7 +310,9 @@ QString EDLUnit::collectionShortTag() const
 
 void EDLUnit::addAuthor(const EDLAuthor &author)
 {
+    const std::lock_guard<std::mutex> lock(d->mutex);
     d->authors.append(author);
+    d->manifestDirty = true;
 }
 
 QList<EDLAuthor> EDLUnit::authors() const
@@ -179,6 +326,8 @@ void EDLUnit::setPath(const QString &path)
     QDir dir(path);
     d->name = dir.dirName();
     d->rootPath = QDir::cleanPath(QStringLiteral("%1/..").arg(path));
+    d->manifestDirty = true;
+    d->attrsDirty = true;
 }
 
 QString EDLUnit::path() const
@@ -195,7 +344,10 @@ QString EDLUnit::rootPath() const
 
 void EDLUnit::setRootPath(const QString &root)
 {
+    const std::lock_guard<std::mutex> lock(d->mutex);
     d->rootPath = root;
+    d->manifestDirty = true;
+    d->attrsDirty = true;
 }
 
 QHash<QString, QVariant> EDLUnit::attributes() const
@@ -208,12 +360,14 @@ void EDLUnit::setAttributes(const QHash<QString, QVariant> &attributes)
 {
     const std::lock_guard<std::mutex> lock(d->mutex);
     d->attrs = attributes;
+    d->attrsDirty = true;
 }
 
 void EDLUnit::insertAttribute(const QString &key, const QVariant &value)
 {
     const std::lock_guard<std::mutex> lock(d->mutex);
     d->attrs.insert(key, value);
+    d->attrsDirty = true;
 }
 
 bool EDLUnit::save()
@@ -227,6 +381,12 @@ bool EDLUnit::save()
     return saveAttributes();
 }
 
+void EDLUnit::scheduleSave()
+{
+    d->saveScheduled = true;
+    EDLSaveWorker::instance()->schedule(this);
+}
+
 QString EDLUnit::lastError() const
 {
     return d->lastError;
@@ -247,8 +407,35 @@ void EDLUnit::setLastError(const QString &message)
     d->lastError = message;
 }
 
+/**
+ * @brief Mark the manifest as changed, so it is written completely on the next save.
+ */
+void EDLUnit::setManifestDirty()
+{
+    const std::lock_guard<std::mutex> lock(d->mutex);
+    d->manifestDirty = true;
+}
+
+bool EDLUnit::isManifestDirty() const
+{
+    const std::lock_guard<std::mutex> lock(d->mutex);
+    return d->manifestDirty;
+}
+
+/**
+ * @brief Remove this unit from the background save queue.
+ *
+ * Must be called by subclasses before they destroy any data that save() needs.
+ */
+void EDLUnit::cancelScheduledSave()
+{
+    if (d->saveScheduled)
+        EDLSaveWorker::instance()->cancel(this);
+}
+
 void EDLUnit::setDataObjects(std::optional<EDLDataFile> dataFile, const QList<EDLDataFile> &auxDataFiles)
 {
+    const std::lock_guard<std::mutex> lock(d->mutex);
     d->dataFile = dataFile;
     d->auxDataFiles = auxDataFiles;
 }
@@ -346,11 +533,6 @@ QString EDLUnit::serializeManifest()
         document.insert("authors", std::move(authorsArr));
     }
 
-    if (d->dataFile.has_value() && !d->dataFile->parts.isEmpty()) {
-        auto dataTab = createManifestFileSection(d->dataFile.value());
-        document.insert("data", std::move(dataTab));
-    }
-
     // register auxilary data files (metadata or extra data accompanying the main data files)
     if (!d->auxDataFiles.isEmpty()) {
         toml::array auxDataArr;
@@ -367,6 +549,13 @@ QString EDLUnit::serializeManifest()
     std::stringstream strData;
     strData << document << "\n";
 
+    // the primary data is always serialized last, so new data parts can be appended to the file
+    if (d->dataFile.has_value() && !d->dataFile->parts.isEmpty()) {
+        toml::table dataDoc;
+        dataDoc.insert("data", createManifestFileSection(d->dataFile.value()));
+        strData << "\n" << dataDoc << "\n";
+    }
+
     return QString::fromStdString(strData.str());
 }
 
@@ -388,51 +577,110 @@ QString EDLUnit::serializeAttributes()
 
 bool EDLUnit::saveManifest()
 {
+    const std::lock_guard<std::mutex> saveLock(d->saveMutex);
+
+    // nothing to do if the manifest on disk is still current
+    if (!isManifestDirty())
+        return true;
+
     QDir dir;
     if (!dir.mkpath(path())) {
         d->lastError = QStringLiteral("Unable to create EDL directory: '%1'").arg(path());
         return false;
     }
 
-    // write the manifest file
-    QFile file(QStringLiteral("%1/manifest.toml").arg(path()));
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        d->lastError = QStringLiteral("Unable to open manifest file for writing (in '%1'): %2")
-                           .arg(path(), file.errorString());
+    // write the manifest file, the dirty flag is reset first so changes made while
+    // we are writing are not lost
+    {
+        const std::lock_guard<std::mutex> lock(d->mutex);
+        d->manifestDirty = false;
+    }
+    QString errorMessage;
+    if (!edlWriteFileAtomic(QStringLiteral("%1/manifest.toml").arg(path()), serializeManifest(), errorMessage)) {
+        setManifestDirty();
+        d->lastError = QStringLiteral("Unable to write manifest file (in '%1'): %2").arg(path(), errorMessage);
         return false;
     }
 
-    QTextStream out(&file);
-    out << serializeManifest();
+    return true;
+}
 
+/**
+ * @brief Append new parts of the primary data file to an existing manifest.
+ *
+ * This avoids serializing the whole manifest again if a dataset only received new data parts
+ * since it was last saved. The parts are expected to be in the unit's data objects already.
+ *
+ * @param parts The new data parts.
+ * @param firstIndex Index of the first new part in the list of all parts.
+ */
+bool EDLUnit::appendManifestDataParts(const QList<EDLDataPart> &parts, int firstIndex)
+{
+    const std::lock_guard<std::mutex> saveLock(d->saveMutex);
+
+    std::stringstream strData;
+    for (int i = 0; i < parts.length(); i++) {
+        auto fpart = parts[i];
+        if (fpart.index < 0)
+            fpart.index = firstIndex + i;
+
+        toml::table fpartTab;
+        fpartTab.insert("index", fpart.index);
+        fpartTab.insert("fname", fpart.fname.toStdString());
+        strData << "\n[[data.parts]]\n" << fpartTab << "\n";
+    }
+
+    // we still replace the whole file atomically, so an interrupted save can never leave a truncated
+    // manifest behind - but we can skip serializing the complete manifest again
+    const auto manifestFname = QStringLiteral("%1/manifest.toml").arg(path());
+    QFile file(manifestFname);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        d->lastError = QStringLiteral("Unable to read manifest file for appending (in '%1'): %2")
+                           .arg(path(), file.errorString());
+        return false;
+    }
+    auto data = QString::fromUtf8(file.readAll());
     file.close();
+    data.append(QString::fromStdString(strData.str()));
+
+    QString errorMessage;
+    if (!edlWriteFileAtomic(manifestFname, data, errorMessage)) {
+        d->lastError = QStringLiteral("Unable to append to manifest file (in '%1'): %2").arg(path(), errorMessage);
+        return false;
+    }
+
     return true;
 }
 
 bool EDLUnit::saveAttributes()
 {
-    // do nothing if we have no user-defined attributes to save
-    if (d->attrs.isEmpty())
-        return true;
+    const std::lock_guard<std::mutex> saveLock(d->saveMutex);
+
+    // do nothing if we have no user-defined attributes to save, or they did not change
+    {
+        const std::lock_guard<std::mutex> lock(d->mutex);
+        if (d->attrs.isEmpty() || !d->attrsDirty)
+            return true;
+        d->attrsDirty = false;
+    }
 
     QDir dir;
     if (!dir.mkpath(path())) {
         d->lastError = QStringLiteral("Unable to create EDL directory: '%1'").arg(path());
+        const std::lock_guard<std::mutex> lock(d->mutex);
+        d->attrsDirty = true;
         return false;
     }
 
     // write the attributes file
-    QFile file(QStringLiteral("%1/attributes.toml").arg(path()));
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        d->lastError = QStringLiteral("Unable to open attributes file for writing (in '%1'): %2")
-                           .arg(path(), file.errorString());
+    QString errorMessage;
+    if (!edlWriteFileAtomic(QStringLiteral("%1/attributes.toml").arg(path()), serializeAttributes(), errorMessage)) {
+        d->lastError = QStringLiteral("Unable to write attributes file (in '%1'): %2").arg(path(), errorMessage);
+        const std::lock_guard<std::mutex> lock(d->mutex);
+        d->attrsDirty = true;
         return false;
     }
 
-    QTextStream out(&file);
-    out << serializeAttributes();
-
-    file.close();
     return true;
 }
 
@@ -443,13 +691,33 @@ QString EDLUnit::generatorId() const
 
 void EDLUnit::setGeneratorId(const QString &idString)
 {
+    const std::lock_guard<std::mutex> lock(d->mutex);
     d->generatorId = idString;
+    d->manifestDirty = true;
+}
+
+/**
+ * @brief Check if a list of data parts starts with all parts of another list.
+ */
+static bool edlPartsHavePrefix(const QList<EDLDataPart> &parts, const QList<EDLDataPart> &prefix)
+{
+    if (prefix.length() > parts.length())
+        return false;
+    for (int i = 0; i < prefix.length(); i++) {
+        if (parts[i].fname != prefix[i].fname || parts[i].index != prefix[i].index)
+            return false;
+    }
+
+    return true;
 }
 
 class EDLDataset::Private
 {
 public:
-    Private() {}
+    Private()
+        : savedPartCount(0)
+    {
+    }
     ~Private() {}
 
     EDLDataFile dataFile;
@@ -457,6 +725,11 @@ public:
 
     QPair<QString, EDLDataFile> dataScanPattern;
     QMap<QString, EDLDataFile> auxDataScanPatterns;
+
+    // number of primary data parts in the manifest on disk
+    int savedPartCount;
+
+    std::recursive_mutex mutex;
 };
 
 EDLDataset::EDLDataset(EDLGroup *parent)
@@ -465,7 +738,10 @@ EDLDataset::EDLDataset(EDLGroup *parent)
 {
 }
 
-EDLDataset::~EDLDataset() {}
+EDLDataset::~EDLDataset()
+{
+    cancelScheduledSave();
+}
 
 bool EDLDataset::save()
 {
@@ -474,68 +750,40 @@ bool EDLDataset::save()
         return false;
     }
 
-    // check if we have to scan for generated files
-    // this is *really* ugly, so hopefully this is just a temporary aid
-    // to help modules (especially ones where we don't easily control the data generation)
-    // to use the EDL scheme.
-    // we protect against badly written modules by not having them accidentally register
-    // files as both primary data and aux data.
-    QSet<QString> auxFiles;
-    if (!d->auxDataScanPatterns.isEmpty()) {
-        QMapIterator<QString, EDLDataFile> adKV(d->auxDataScanPatterns);
-        while (adKV.hasNext()) {
-            adKV.next();
+    const std::lock_guard<std::recursive_mutex> lock(d->mutex);
 
-            const auto files = findFilesByPattern(adKV.key());
-            if (files.isEmpty()) {
-                qWarning().noquote().nospace()
-                    << "Dataset '" << name() << "' expected to find auxiliary data matching pattern `" << adKV.key()
-                    << "`, but no data was found.";
-            } else {
-                for (int i = 0; i < files.size(); ++i) {
-                    auxFiles.insert(files[i]);
-                    if (i == 0)
-                        addAuxDataFile(files[0], adKV.key(), adKV.value().summary);
-                    else
-                        addAuxDataFilePart(files[i], adKV.key());
-                }
-            }
-        }
-    }
+    applyScanPatterns();
+    setDataObjects(d->dataFile, d->auxFiles.values());
 
-    // register actual data found via pattern scan
-    if (!d->dataScanPattern.first.isEmpty()) {
-        d->dataFile.parts.clear();
-        const auto files = findFilesByPattern(d->dataScanPattern.first);
-        if (files.isEmpty()) {
-            qWarning().noquote().nospace() << "Dataset '" << name() << "' expected to find data matching pattern `"
-                                           << d->dataScanPattern.first << "`, but no data was found.";
-        } else {
-            for (int i = 0; i < files.size(); ++i) {
-                if (auxFiles.contains(files[i]))
-                    continue;
-                if (d->dataFile.parts.isEmpty())
-                    setDataFile(files[i], d->dataScanPattern.second.summary);
-                else
-                    addDataFilePart(files[i]);
-            }
-        }
+    // If we only gained new data parts since the last save, we just append them to the manifest.
+    // Once there are two or more parts, all of them have an explicit index, so new ones can simply
+    // be added at the end without touching the existing ones.
+    const int partCount = d->dataFile.parts.length();
+    if (!isManifestDirty() && d->savedPartCount >= 2 && partCount > d->savedPartCount) {
+        if (!appendManifestDataParts(d->dataFile.parts.mid(d->savedPartCount), d->savedPartCount))
+            return false;
+    } else {
+        if (partCount != d->savedPartCount)
+            setManifestDirty();
+        if (!saveManifest())
+            return false;
     }
+    d->savedPartCount = partCount;
 
-    setDataObjects(d->dataFile, d->auxFiles.values());
-    if (!saveManifest())
-        return false;
     return saveAttributes();
 }
 
 bool EDLDataset::isEmpty() const
 {
+    const std::lock_guard<std::recursive_mutex> lock(d->mutex);
     return d->dataFile.parts.isEmpty() && d->auxFiles.isEmpty() && d->dataScanPattern.first.isEmpty()
            && d->auxDataScanPatterns.isEmpty();
 }
 
 QString EDLDataset::setDataFile(const QString &fname, const QString &summary)
 {
+    const std::lock_guard<std::recursive_mutex> lock(d->mutex);
+    setManifestDirty();
     d->dataFile.parts.clear();
     d->dataFile.summary = summary;
     return addDataFilePart(fname);
@@ -548,13 +796,17 @@ QString EDLDataset::addDataFilePart(const QString &fname, int index)
 
     EDLDataPart part(baseName);
     part.index = index;
-    d->dataFile.parts.append(part);
+    {
+        const std::lock_guard<std::recursive_mutex> lock(d->mutex);
+        d->dataFile.parts.append(part);
+    }
 
     return pathForDataBasename(baseName);
 }
 
 EDLDataFile EDLDataset::dataFile() const
 {
+    const std::lock_guard<std::recursive_mutex> lock(d->mutex);
     return d->dataFile;
 }
 
@@ -562,7 +814,10 @@ QString EDLDataset::addAuxDataFile(const QString &fname, const QString &key, con
 {
     EDLDataFile adf;
     adf.summary = summary;
-    d->auxFiles[key] = adf;
+    {
+        const std::lock_guard<std::recursive_mutex> lock(d->mutex);
+        d->auxFiles[key] = adf;
+    }
     return addAuxDataFilePart(fname, key);
 }
 
@@ -571,20 +826,98 @@ QString EDLDataset::addAuxDataFilePart(const QString &fname, const QString &key,
     QFileInfo fi(fname);
     const auto baseName = fi.fileName();
 
-    if (!d->auxFiles.contains(key))
-        d->auxFiles[key] = EDLDataFile();
-
     EDLDataPart part(baseName);
     part.index = index;
-    d->auxFiles[key].parts.append(part);
+    {
+        const std::lock_guard<std::recursive_mutex> lock(d->mutex);
+        if (!d->auxFiles.contains(key))
+            d->auxFiles[key] = EDLDataFile();
+        d->auxFiles[key].parts.append(part);
+    }
+    setManifestDirty();
 
     return pathForDataBasename(baseName);
 }
 
+QString EDLDataset::generatorId() const
+{
+    return EDLUnit::generatorId();
+}
+
+void EDLDataset::setGeneratorId(const QString &idString)
+{
+    EDLUnit::setGeneratorId(idString);
+}
+
+void EDLDataset::applyScanPatterns()
+{
+    const std::lock_guard<std::recursive_mutex> lock(d->mutex);
+
+    // check if we have to scan for generated files
+    // this is *really* ugly, so hopefully this is just a temporary aid
+    // to help modules (especially ones where we don't easily control the data generation)
+    // to use the EDL scheme.
+    // we protect against badly written modules by not having them accidentally register
+    // files as both primary data and aux data.
+    QSet<QString> auxFiles;
+    if (!d->auxDataScanPatterns.isEmpty()) {
+        QMapIterator<QString, EDLDataFile> adKV(d->auxDataScanPatterns);
+        while (adKV.hasNext()) {
+            adKV.next();
+
+            const auto files = findFilesByPattern(adKV.key());
+            if (files.isEmpty()) {
+                qWarning().noquote().nospace()
+                    << "Dataset '" << name() << "' expected to find auxiliary data matching pattern `" << adKV.key()
+                    << "`, but no data was found.";
+            } else {
+                EDLDataFile adf;
+                adf.summary = adKV.value().summary;
+                for (const auto &file : files) {
+                    auxFiles.insert(file);
+                    adf.parts.append(EDLDataPart(file));
+                }
+
+                // only touch the manifest if the scan actually found something new
+                const auto it = d->auxFiles.constFind(adKV.key());
+                if (it == d->auxFiles.constEnd() || it->summary != adf.summary
+                    || it->parts.length() != adf.parts.length() || !edlPartsHavePrefix(adf.parts, it->parts)) {
+                    d->auxFiles[adKV.key()] = adf;
+                    setManifestDirty();
+                }
+            }
+        }
+    }
+
+    // register actual data found via pattern scan
+    if (!d->dataScanPattern.first.isEmpty()) {
+        const auto files = findFilesByPattern(d->dataScanPattern.first);
+        if (files.isEmpty()) {
+            qWarning().noquote().nospace() << "Dataset '" << name() << "' expected to find data matching pattern `"
+                                           << d->dataScanPattern.first << "`, but no data was found.";
+        }
+
+        QList<EDLDataPart> parts;
+        for (const auto &file : files) {
+            if (!auxFiles.contains(file))
+                parts.append(EDLDataPart(file));
+        }
+
+        // Files that were added after the ones we already know about are just new parts, which save()
+        // can append to the manifest on disk. Anything else means the existing part list changed.
+        const auto &summary = d->dataScanPattern.second.summary;
+        if (d->dataFile.summary != summary || !edlPartsHavePrefix(parts, d->dataFile.parts))
+            setManifestDirty();
+        d->dataFile.summary = summary;
+        d->dataFile.parts = parts;
+    }
+}
+
 void EDLDataset::setDataScanPattern(const QString &wildcard, const QString &summary)
 {
     EDLDataFile df;
     df.summary = summary;
+    const std::lock_guard<std::recursive_mutex> lock(d->mutex);
     d->dataScanPattern = qMakePair(wildcard, df);
 }
 
@@ -592,6 +925,7 @@ void EDLDataset::addAuxDataScanPattern(const QString &wildcard, const QString &s
 {
     EDLDataFile adf;
     adf.summary = summary;
+    const std::lock_guard<std::recursive_mutex> lock(d->mutex);
     d->auxDataScanPatterns[wildcard] = adf;
 }
 
@@ -650,7 +984,10 @@ EDLGroup::EDLGroup(EDLGroup *parent)
 {
 }
 
-EDLGroup::~EDLGroup() {}
+EDLGroup::~EDLGroup()
+{
+    cancelScheduledSave();
+}
 
 bool EDLGroup::setName(const QString &name)
 {
@@ -740,16 +1077,26 @@ bool EDLGroup::save()
         return false;
     }
 
-    // save all our subnodes first
-    QMutableListIterator<std::shared_ptr<EDLUnit>> i(d->children);
-    while (i.hasNext()) {
-        auto obj = i.next();
-        if (obj->parent() != this) {
-            qWarning().noquote() << QStringLiteral("Unlinking EDL child '%1' that doesn't believe '%2' is its parent.")
-                                        .arg(obj->name(), name());
-            i.remove();
-            continue;
+    // snapshot our children, so other threads can add new ones while we write to disk
+    QList<std::shared_ptr<EDLUnit>> children;
+    {
+        const std::lock_guard<std::mutex> lock(d->mutex);
+        QMutableListIterator<std::shared_ptr<EDLUnit>> i(d->children);
+        while (i.hasNext()) {
+            auto obj = i.next();
+            if (obj->parent() != this) {
+                qWarning().noquote()
+                    << QStringLiteral("Unlinking EDL child '%1' that doesn't believe '%2' is its parent.")
+                           .arg(obj->name(), name());
+                i.remove();
+                continue;
+            }
+            children.append(obj);
         }
+    }
+
+    // save all our subnodes first
+    for (const auto &obj : children) {
         if (!obj->save()) {
             setLastError(QStringLiteral("Saving of '%1' failed: %2").arg(obj->name(), obj->lastError()));
             return false;
@@ -778,7 +1125,10 @@ EDLCollection::EDLCollection(const QString &name)
     setCollectionId(QUuid::createUuid());
 }
 
-EDLCollection::~EDLCollection() {}
+EDLCollection::~EDLCollection()
+{
+    cancelScheduledSave();
+}
 
 QString EDLCollection::generatorId() const
 {
@@ -127,6 +127,16 @@ public:
 
     virtual bool save();
 
+    /**
+     * @brief Save this unit in the background
+     *
+     * Queues this unit to be saved by a background worker, which batches
+     * multiple requests for the same unit into a single write. Use this instead
+     * of save() on threads which must not wait for disk I/O.
+     * Errors are logged, as there is no caller to report them to.
+     */
+    void scheduleSave();
+
     QString lastError() const;
 
     QString serializeManifest();
@@ -136,6 +146,9 @@ protected:
     void setObjectKind(const EDLUnitKind &kind);
     void setParent(EDLUnit *parent);
     void setLastError(const QString &message);
+    void setManifestDirty();
+    bool isManifestDirty() const;
+    void cancelScheduledSave();
 
     virtual void setRootPath(const QString &root);
 
@@ -145,6 +158,7 @@ protected:
 
     bool saveManifest();
     bool saveAttributes();
+    bool appendManifestDataParts(const QList<EDLDataPart> &parts, int firstIndex);
 
     QString generatorId() const;
     void setGeneratorId(const QString &idString);
@@ -178,6 +192,9 @@ public:
     QString addAuxDataFile(const QString &fname, const QString &key = QString(), const QString &summary = QString());
     QString addAuxDataFilePart(const QString &fname, const QString &key = QString(), int index = -1);
 
+    QString generatorId() const;
+    void setGeneratorId(const QString &idString);
+
     /**
      * @brief Set a pattern to find data files
      * @param wildcard Wildcard to find generated data
@@ -189,6 +206,15 @@ public:
     void setDataScanPattern(const QString &wildcard, const QString &summary = QString());
     void addAuxDataScanPattern(const QString &wildcard, const QString &summary = QString());
 
+    /**
+     * @brief Register all files matching the scan patterns
+     *
+     * This is done implicitly by save(). Call it explicitly if the found
+     * data parts are needed right away, while the dataset itself is saved
+     * in the background via scheduleSave().
+     */
+    void applyScanPatterns();
+
     /**
      * @brief Get absolute path for data with a given basename
      * Retrieve an absolute path for the given basename in this dataset.
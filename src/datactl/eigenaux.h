@@ -21,6 +21,8 @@
 
 #include <Eigen/Dense>
 #include <algorithm>
+#include <cstring>
+#include <sys/types.h>
 #include <QDataStream>
 
 namespace Syntalos
@@ -33,6 +35,7 @@ typedef Eigen::Matrix<double, Eigen::Dynamic, 1> VectorXd;
 
 typedef Eigen::Matrix<qint32, Eigen::Dynamic, Eigen::Dynamic> MatrixXsi;
 typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> MatrixXd;
+typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic> MatrixXf;
 
 template<typename T>
 double vectorMedian(const Eigen::Matrix<T, Eigen::Dynamic, 1> &vec)
@@ -117,4 +120,84 @@ EigenType deserializeEigen(QDataStream &stream)
     return matrix;
 }
 
+/**
+ * Size of the raw memory representation of a vector of timestamps with its
+ * associated data matrix, as written by writeTimestampedMatrix().
+ */
+template<typename VectorType, typename MatrixType>
+ssize_t timestampedMatrixMemorySize(const VectorType &timestamps, const MatrixType &data)
+{
+    return static_cast<ssize_t>(
+        (3 * sizeof(quint64)) + (timestamps.size() * sizeof(typename VectorType::Scalar))
+        + (data.size() * sizeof(typename MatrixType::Scalar)));
+}
+
+/**
+ * Write a vector of timestamps and its data matrix to memory, using a fixed layout:
+ * Three quint64 values (timestamp count, data rows, data columns) are followed by
+ * the raw timestamp array and the raw data array in column-major order.
+ * Unlike serializeEigen(), this copies the matrix data in bulk and uses the host byte order,
+ * so it is only suitable for data exchange on the same machine.
+ */
+template<typename VectorType, typename MatrixType>
+bool writeTimestampedMatrix(void *memory, ssize_t size, const VectorType &timestamps, const MatrixType &data)
+{
+    static_assert(!MatrixType::IsRowMajor, "Data matrix must be stored in column-major order");
+    if (size < timestampedMatrixMemorySize(timestamps, data))
+        return false;
+
+    auto dest = static_cast<unsigned char *>(memory);
+    const quint64 header[3] = {
+        static_cast<quint64>(timestamps.size()),
+        static_cast<quint64>(data.rows()),
+        static_cast<quint64>(data.cols())};
+    std::memcpy(dest, header, sizeof(header));
+    dest += sizeof(header);
+
+    const auto tsBytes = timestamps.size() * sizeof(typename VectorType::Scalar);
+    std::memcpy(dest, timestamps.data(), tsBytes);
+    dest += tsBytes;
+
+    std::memcpy(dest, data.data(), data.size() * sizeof(typename MatrixType::Scalar));
+    return true;
+}
+
+/**
+ * Read a vector of timestamps and its data matrix from memory that was
+ * written by writeTimestampedMatrix().
+ */
+template<typename VectorType, typename MatrixType>
+bool readTimestampedMatrix(const void *memory, size_t size, VectorType &timestamps, MatrixType &data)
+{
+    static_assert(!MatrixType::IsRowMajor, "Data matrix must be stored in column-major order");
+    quint64 header[3];
+    if (size < sizeof(header))
+        return false;
+
+    auto src = static_cast<const unsigned char *>(memory);
+    std::memcpy(header, src, sizeof(header));
+    src += sizeof(header);
+
+    // the header comes from untrusted memory, so check the sizes without risking overflows
+    constexpr auto tsScalarSize = sizeof(typename VectorType::Scalar);
+    constexpr auto dataScalarSize = sizeof(typename MatrixType::Scalar);
+    const size_t payloadSize = size - sizeof(header);
+    if (header[0] > payloadSize / tsScalarSize)
+        return false;
+    const size_t tsBytes = header[0] * tsScalarSize;
+
+    const size_t maxDataElements = (payloadSize - tsBytes) / dataScalarSize;
+    if (header[1] > maxDataElements || (header[1] != 0 && header[2] > maxDataElements / header[1]))
+        return false;
+    const size_t dataBytes = header[1] * header[2] * dataScalarSize;
+
+    timestamps.resize(header[0]);
+    std::memcpy(timestamps.data(), src, tsBytes);
+    src += tsBytes;
+
+    data.resize(header[1], header[2]);
+    std::memcpy(data.data(), src, dataBytes);
+    return true;
+}
+
 } // namespace Syntalos
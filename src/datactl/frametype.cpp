@@ -0,0 +1,375 @@
+/*
+ * Copyright (C) 2019-2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frametype.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sys/mman.h>
+#include <vector>
+
+// huge pages are 2 MiB on all platforms we care about
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+namespace
+{
+
+struct PoolBuffer {
+    uchar *data;
+    size_t size;
+    bool mapped;
+};
+
+std::mutex g_poolRegistryMutex;
+std::vector<FramePool *> g_poolRegistry;
+std::vector<cv::MatAllocator *> g_spareAllocators;
+
+} // namespace
+
+/**
+ * OpenCV allocator that recycles buffers of a fixed size.
+ *
+ * OpenCV calls deallocate() once the last matrix referencing a buffer is
+ * destroyed, which is when we return it to the pool.
+ * Matrices keep a pointer to their allocator even after their data was released,
+ * so allocators are never deleted. Once their pool is gone, they free returned
+ * buffers immediately and are handed to the next pool that is created.
+ */
+class FramePool::PoolAllocator : public cv::MatAllocator
+{
+public:
+    PoolAllocator(const QString &poolName, size_t maxFree, bool hugePages)
+        : orphaned(false),
+          name(poolName),
+          maxFreeBuffers(maxFree),
+          useHugePages(hugePages),
+          type(0),
+          bufferSize(0),
+          hits(0),
+          misses(0),
+          inUse(0),
+          highWater(0)
+    {
+    }
+
+    ~PoolAllocator() override
+    {
+        for (auto buf : freeBuffers)
+            freeBuffer(buf);
+    }
+
+    cv::UMatData *allocate(
+        int dims,
+        const int *sizes,
+        int elemType,
+        void *data0,
+        size_t *step,
+        cv::AccessFlag flags,
+        cv::UMatUsageFlags usageFlags) const override
+    {
+        size_t total = CV_ELEM_SIZE(elemType);
+        for (int i = 0; i < dims; i++)
+            total *= sizes[i];
+
+        // matrices that do not match the pool geometry (e.g. a pooled frame that is resized
+        // in-place by a consumer) are served by the regular OpenCV allocator, so they never
+        // disturb the buffers of the producer
+        auto buf = data0 == nullptr ? acquireBuffer(total) : nullptr;
+        if (buf == nullptr)
+            return cv::Mat::getStdAllocator()->allocate(dims, sizes, elemType, data0, step, flags, usageFlags);
+
+        size_t stepTotal = CV_ELEM_SIZE(elemType);
+        for (int i = dims - 1; i >= 0; i--) {
+            if (step)
+                step[i] = stepTotal;
+            stepTotal *= sizes[i];
+        }
+
+        auto u = new cv::UMatData(this);
+        u->size = total;
+        u->data = u->origdata = buf->data;
+        u->userdata = buf;
+        return u;
+    }
+
+    bool allocate(cv::UMatData *u, cv::AccessFlag, cv::UMatUsageFlags) const override
+    {
+        return u != nullptr;
+    }
+
+    void deallocate(cv::UMatData *u) const override
+    {
+        if (u == nullptr)
+            return;
+        CV_Assert(u->urefcount == 0);
+        CV_Assert(u->refcount == 0);
+
+        auto buf = static_cast<PoolBuffer *>(u->userdata);
+        u->origdata = nullptr;
+        u->userdata = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            inUse--;
+            if (orphaned || buf->size != bufferSize || freeBuffers.size() >= maxFreeBuffers)
+                freeBuffer(buf);
+            else
+                freeBuffers.push_back(buf);
+        }
+        delete u;
+    }
+
+    /**
+     * Take a buffer from the pool, or return nullptr if the requested
+     * size does not match the geometry of the pool.
+     */
+    PoolBuffer *acquireBuffer(size_t size) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (orphaned || bufferSize == 0 || size != bufferSize)
+            return nullptr;
+
+        PoolBuffer *buf;
+        if (freeBuffers.empty()) {
+            buf = newBuffer(size);
+            misses++;
+        } else {
+            buf = freeBuffers.back();
+            freeBuffers.pop_back();
+            hits++;
+        }
+
+        inUse++;
+        if (inUse > highWater)
+            highWater = inUse;
+        return buf;
+    }
+
+    PoolBuffer *newBuffer(size_t size) const
+    {
+        auto buf = new PoolBuffer;
+        buf->size = size;
+        buf->mapped = false;
+        buf->data = nullptr;
+
+        if (useHugePages) {
+            const auto mapSize = ((size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+
+            // try explicitly reserved huge pages first, and fall back to transparent huge pages
+            void *ptr = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (ptr == MAP_FAILED) {
+                ptr = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (ptr != MAP_FAILED)
+                    madvise(ptr, mapSize, MADV_HUGEPAGE);
+            }
+
+            if (ptr != MAP_FAILED) {
+                buf->data = static_cast<uchar *>(ptr);
+                buf->mapped = true;
+                return buf;
+            }
+            qWarning().noquote() << "Unable to map huge page backed frame buffer for pool" << name << "- "
+                                 << std::strerror(errno);
+        }
+
+        buf->data = static_cast<uchar *>(cv::fastMalloc(size));
+        return buf;
+    }
+
+    void freeBuffer(PoolBuffer *buf) const
+    {
+        if (buf->mapped)
+            munmap(buf->data, ((buf->size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE);
+        else
+            cv::fastFree(buf->data);
+        delete buf;
+    }
+
+    /**
+     * Called when the owning pool is destroyed.
+     */
+    void release()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        orphaned = true;
+        for (auto buf : freeBuffers)
+            freeBuffer(buf);
+        freeBuffers.clear();
+    }
+
+    /**
+     * Prepare a previously released allocator for use by a new pool.
+     */
+    void reinit(const QString &poolName, size_t maxFree, bool hugePages)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        orphaned = false;
+        name = poolName;
+        maxFreeBuffers = maxFree;
+        useHugePages = hugePages;
+        size = cv::Size();
+        type = 0;
+        bufferSize = 0;
+        hits = 0;
+        misses = 0;
+        highWater = inUse;
+    }
+
+    mutable std::mutex mutex;
+    mutable std::vector<PoolBuffer *> freeBuffers;
+    mutable bool orphaned;
+
+    QString name;
+    size_t maxFreeBuffers;
+    bool useHugePages;
+    cv::Size size;
+    int type;
+
+    mutable size_t bufferSize;
+    mutable uint64_t hits;
+    mutable uint64_t misses;
+    mutable size_t inUse;
+    mutable size_t highWater;
+};
+
+FramePool::FramePool(const QString &name, size_t maxFreeBuffers, bool useHugePages)
+{
+    std::lock_guard<std::mutex> lock(g_poolRegistryMutex);
+    if (g_spareAllocators.empty()) {
+        m_alloc = new PoolAllocator(name, maxFreeBuffers, useHugePages);
+    } else {
+        m_alloc = static_cast<PoolAllocator *>(g_spareAllocators.back());
+        g_spareAllocators.pop_back();
+        m_alloc->reinit(name, maxFreeBuffers, useHugePages);
+    }
+    g_poolRegistry.push_back(this);
+}
+
+FramePool::~FramePool()
+{
+    m_alloc->release();
+
+    std::lock_guard<std::mutex> lock(g_poolRegistryMutex);
+    g_poolRegistry.erase(std::remove(g_poolRegistry.begin(), g_poolRegistry.end(), this), g_poolRegistry.end());
+    g_spareAllocators.push_back(m_alloc);
+}
+
+void FramePool::setGeometry(const cv::Size &size, int type)
+{
+    std::lock_guard<std::mutex> lock(m_alloc->mutex);
+    if (m_alloc->size == size && m_alloc->type == type)
+        return;
+
+    m_alloc->size = size;
+    m_alloc->type = type;
+    m_alloc->bufferSize = static_cast<size_t>(size.area()) * CV_ELEM_SIZE(type);
+    for (auto buf : m_alloc->freeBuffers)
+        m_alloc->freeBuffer(buf);
+    m_alloc->freeBuffers.clear();
+}
+
+QString FramePool::name() const
+{
+    std::lock_guard<std::mutex> lock(m_alloc->mutex);
+    return m_alloc->name;
+}
+
+void FramePool::setName(const QString &name)
+{
+    std::lock_guard<std::mutex> lock(m_alloc->mutex);
+    m_alloc->name = name;
+}
+
+cv::Mat FramePool::mat(const cv::Size &size, int type)
+{
+    setGeometry(size, type);
+
+    cv::Mat mat;
+    mat.allocator = m_alloc;
+    mat.create(size, type);
+    return mat;
+}
+
+cv::Mat FramePool::mat()
+{
+    cv::Size size;
+    int type;
+    {
+        std::lock_guard<std::mutex> lock(m_alloc->mutex);
+        size = m_alloc->size;
+        type = m_alloc->type;
+    }
+
+    cv::Mat mat;
+    mat.allocator = m_alloc;
+    mat.create(size, type);
+    return mat;
+}
+
+void FramePool::preallocate(size_t count)
+{
+    std::lock_guard<std::mutex> lock(m_alloc->mutex);
+    if (m_alloc->bufferSize == 0)
+        return;
+    while (m_alloc->freeBuffers.size() < std::min(count, m_alloc->maxFreeBuffers))
+        m_alloc->freeBuffers.push_back(m_alloc->newBuffer(m_alloc->bufferSize));
+}
+
+FramePoolStats FramePool::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_alloc->mutex);
+    FramePoolStats stats;
+    stats.name = m_alloc->name;
+    stats.size = m_alloc->size;
+    stats.type = m_alloc->type;
+    stats.bufferSize = m_alloc->bufferSize;
+    stats.hugePages = m_alloc->useHugePages;
+    stats.hits = m_alloc->hits;
+    stats.misses = m_alloc->misses;
+    stats.inUse = m_alloc->inUse;
+    stats.highWater = m_alloc->highWater;
+    stats.freeBuffers = m_alloc->freeBuffers.size();
+    return stats;
+}
+
+void FramePool::resetStats()
+{
+    std::lock_guard<std::mutex> lock(m_alloc->mutex);
+    m_alloc->hits = 0;
+    m_alloc->misses = 0;
+    m_alloc->highWater = m_alloc->inUse;
+}
+
+QList<FramePoolStats> FramePool::allStats()
+{
+    std::lock_guard<std::mutex> lock(g_poolRegistryMutex);
+    QList<FramePoolStats> result;
+    for (const auto pool : g_poolRegistry)
+        result.append(pool->stats());
+    return result;
+}
+
+void FramePool::resetAllStats()
+{
+    std::lock_guard<std::mutex> lock(g_poolRegistryMutex);
+    for (const auto pool : g_poolRegistry)
+        pool->resetStats();
+}
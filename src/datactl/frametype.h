@@ -19,6 +19,8 @@
 
 #pragma once
 #include "datatypes.h"
+#include <QList>
+#include <QString>
 #include <opencv2/core.hpp>
 
 /**
@@ -156,3 +158,95 @@ struct Frame : BaseDataType {
         return frame;
     }
 };
+
+/**
+ * @brief Usage statistics of a FramePool
+ */
+struct FramePoolStats {
+    QString name;
+    cv::Size size;
+    int type{0};
+    size_t bufferSize{0};
+    bool hugePages{false};
+
+    uint64_t hits{0};      /// Number of buffers that were served from the pool
+    uint64_t misses{0};    /// Number of buffers that had to be newly allocated
+    size_t inUse{0};       /// Number of buffers currently in use by frames
+    size_t highWater{0};   /// Maximum number of buffers that were in use at the same time
+    size_t freeBuffers{0}; /// Number of buffers currently waiting to be reused
+};
+
+/**
+ * @brief Pool of reusable image buffers for frame producers
+ *
+ * Allocating a new image buffer for every frame of a high-resolution, high-framerate
+ * video stream is expensive, as the buffers are typically too large to be recycled by
+ * the system memory allocator and have to be mapped (and page-faulted) every time.
+ *
+ * A FramePool hands out cv::Mat instances of a fixed geometry, whose memory returns to
+ * the pool once the last reference to the matrix (e.g. the last copy of a Frame holding it)
+ * is destroyed. Matrices are reference-counted by OpenCV as usual, so they can be passed
+ * through streams like any other matrix.
+ * Buffers may outlive the pool that created them, they are freed when they are released.
+ * If a pooled matrix is reallocated with a different geometry (e.g. when it is resized
+ * in-place by a consumer), the new data is allocated regularly and the pool is left untouched.
+ */
+class FramePool
+{
+public:
+    /**
+     * @param name Human-readable name of this pool, shown in diagnostic messages.
+     * @param maxFreeBuffers Maximum number of unused buffers to keep around for reuse.
+     * @param useHugePages Back buffers with huge pages, if possible.
+     */
+    explicit FramePool(const QString &name = QString(), size_t maxFreeBuffers = 16, bool useHugePages = false);
+    ~FramePool();
+
+    /**
+     * @brief Set the geometry of buffers handed out by this pool
+     *
+     * If the geometry changed, all currently unused buffers are released.
+     * Buffers with the old geometry that are still in use will be freed instead of
+     * being recycled.
+     */
+    void setGeometry(const cv::Size &size, int type);
+
+    QString name() const;
+    void setName(const QString &name);
+
+    /**
+     * @brief Obtain a matrix backed by a pooled buffer
+     *
+     * Changes the pool geometry if size or type don't match the current geometry.
+     * The matrix contents are undefined.
+     */
+    cv::Mat mat(const cv::Size &size, int type);
+
+    /**
+     * @brief Obtain a matrix with the current pool geometry
+     */
+    cv::Mat mat();
+
+    /**
+     * @brief Allocate buffers up front, so the first frames don't have to be allocated
+     */
+    void preallocate(size_t count);
+
+    FramePoolStats stats() const;
+    void resetStats();
+
+    /**
+     * @brief Statistics of all pools currently in existence
+     */
+    static QList<FramePoolStats> allStats();
+
+    /**
+     * @brief Reset the statistics of all pools currently in existence
+     */
+    static void resetAllStats();
+
+private:
+    Q_DISABLE_COPY(FramePool)
+    class PoolAllocator;
+    PoolAllocator *m_alloc;
+};
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2019-2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "signalconv.h"
+
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SY_SIGNALCONV_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace Syntalos
+{
+
+// The Intan conversion factor was always applied as single-precision literal,
+// so we must use the same value to produce identical results.
+static constexpr double RAW_TO_MICROVOLTS = 0.195F;
+static constexpr double RAW_OFFSET = 32768.0;
+
+// Size of the blocks the raw data is transposed in. A tile of frames stays in L1 cache
+// while all channels are extracted from it, so the raw buffer is only streamed once.
+static constexpr size_t TILE_FRAMES = 16;
+static constexpr size_t TILE_CHANNELS = 128;
+
+using ConvertColumnFn = void (*)(const int32_t *src, double *dst, size_t count);
+using ConvertTilesFn = void (*)(const uint16_t *, size_t, size_t, const int *, double *const *, size_t);
+
+static inline void convertTileColumnDefault(const int32_t *src, double *dst, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const auto offset = _mm_set1_pd(RAW_OFFSET);
+    const auto scale = _mm_set1_pd(RAW_TO_MICROVOLTS);
+    for (; i + 2 <= count; i += 2) {
+        const auto v = _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i)));
+        _mm_storeu_pd(dst + i, _mm_mul_pd(_mm_sub_pd(v, offset), scale));
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = (static_cast<double>(src[i]) - RAW_OFFSET) * RAW_TO_MICROVOLTS;
+}
+
+template<ConvertColumnFn convertColumn>
+static inline void convertTiles(
+    const uint16_t *rawBuf,
+    size_t numSamples,
+    size_t rawStride,
+    const int *rawIndices,
+    double *const *columns,
+    size_t numChannels)
+{
+    alignas(32) int32_t tile[TILE_CHANNELS * TILE_FRAMES];
+
+    for (size_t frame = 0; frame < numSamples; frame += TILE_FRAMES) {
+        const size_t count = std::min(TILE_FRAMES, numSamples - frame);
+        const uint16_t *frameBuf = rawBuf + frame * rawStride;
+
+        for (size_t chStart = 0; chStart < numChannels; chStart += TILE_CHANNELS) {
+            const size_t chCount = std::min(TILE_CHANNELS, numChannels - chStart);
+            const int *indices = rawIndices + chStart;
+
+            // transpose the tile, reading the raw frames sequentially
+            for (size_t i = 0; i < count; ++i) {
+                const uint16_t *src = frameBuf + i * rawStride;
+                for (size_t ch = 0; ch < chCount; ++ch)
+                    tile[ch * TILE_FRAMES + i] = src[indices[ch]];
+            }
+
+            // convert each channel into its contiguous output column
+            for (size_t ch = 0; ch < chCount; ++ch)
+                convertColumn(tile + ch * TILE_FRAMES, columns[chStart + ch] + frame, count);
+        }
+    }
+}
+
+#ifdef SY_SIGNALCONV_X86_DISPATCH
+// AVX2 variants, only used if the CPU we are running on supports them.
+// FMA is deliberately not enabled, so results stay identical to the default path.
+__attribute__((target("avx2"))) static void convertTileColumnAvx2(const int32_t *src, double *dst, size_t count)
+{
+    size_t i = 0;
+    const auto offset = _mm256_set1_pd(RAW_OFFSET);
+    const auto scale = _mm256_set1_pd(RAW_TO_MICROVOLTS);
+    for (; i + 4 <= count; i += 4) {
+        const auto v = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)));
+        _mm256_storeu_pd(dst + i, _mm256_mul_pd(_mm256_sub_pd(v, offset), scale));
+    }
+    for (; i < count; ++i)
+        dst[i] = (static_cast<double>(src[i]) - RAW_OFFSET) * RAW_TO_MICROVOLTS;
+}
+
+__attribute__((target("avx2"))) static void convertTilesAvx2(
+    const uint16_t *rawBuf,
+    size_t numSamples,
+    size_t rawStride,
+    const int *rawIndices,
+    double *const *columns,
+    size_t numChannels)
+{
+    convertTiles<convertTileColumnAvx2>(rawBuf, numSamples, rawStride, rawIndices, columns, numChannels);
+}
+#endif
+
+static ConvertTilesFn selectConvertTiles()
+{
+#ifdef SY_SIGNALCONV_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return convertTilesAvx2;
+#endif
+    return convertTiles<convertTileColumnDefault>;
+}
+
+void convertInterleavedRawToMicrovolts(
+    const uint16_t *rawBuf,
+    size_t numSamples,
+    size_t rawStride,
+    const int *rawIndices,
+    double *const *columns,
+    size_t numChannels)
+{
+    // the CPU features never change at runtime, so we only check them once
+    static const ConvertTilesFn convertFn = selectConvertTiles();
+    convertFn(rawBuf, numSamples, rawStride, rawIndices, columns, numChannels);
+}
+
+} // namespace Syntalos
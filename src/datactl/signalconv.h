@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2019-2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Syntalos
+{
+
+/**
+ * @brief Convert interleaved raw Intan amplifier samples to microvolts
+ *
+ * Reads @p numSamples frames of @p rawStride interleaved unsigned 16-bit samples from
+ * @p rawBuf in a single pass, and writes the samples of the selected channels as
+ * 0.195 * (raw - 32768) to one contiguous output column per channel.
+ * The result is bit-identical to converting every sample individually in double precision.
+ *
+ * @param rawBuf Interleaved raw samples, frame by frame.
+ * @param numSamples Number of frames in @p rawBuf.
+ * @param rawStride Number of channels per frame.
+ * @param rawIndices Index of each selected channel within a frame.
+ * @param columns Output buffer of each selected channel, must hold @p numSamples values.
+ * @param numChannels Number of selected channels.
+ */
+void convertInterleavedRawToMicrovolts(
+    const uint16_t *rawBuf,
+    size_t numSamples,
+    size_t rawStride,
+    const int *rawIndices,
+    double *const *columns,
+    size_t numChannels);
+
+} // namespace Syntalos
@@ -24,6 +24,7 @@
 #include <iostream>
 #include <algorithm>
 
+#include "datatypes.h"
 #include "utils/misc.h"
 
 namespace Syntalos
@@ -50,6 +51,13 @@ const QString Syntalos::timeSyncStrategyToHString(const TimeSyncStrategy &strate
     }
 }
 
+ClockOffsetEstimator Syntalos::clockOffsetEstimatorFromString(const QString &str)
+{
+    if (str == QStringLiteral("drift-model"))
+        return ClockOffsetEstimator::DRIFT_MODEL;
+    return ClockOffsetEstimator::WINDOW_MEDIAN;
+}
+
 const QString Syntalos::timeSyncStrategiesToHString(const TimeSyncStrategies &strategies)
 {
     QStringList sl;
@@ -71,6 +79,232 @@ const QString Syntalos::timeSyncStrategiesToHString(const TimeSyncStrategies &st
     return sl.join(" and ");
 }
 
+const QString Syntalos::clockOffsetEstimatorToString(const ClockOffsetEstimator &estimator)
+{
+    switch (estimator) {
+    case ClockOffsetEstimator::WINDOW_MEDIAN:
+        return QStringLiteral("window-median");
+    case ClockOffsetEstimator::DRIFT_MODEL:
+        return QStringLiteral("drift-model");
+    default:
+        return QStringLiteral("invalid");
+    }
+}
+
+// ---------------
+// ClockDriftModel
+// ---------------
+
+/**
+ * Number of consecutive rejected measurements after which we assume the offset
+ * has really changed, instead of the measurements being outliers.
+ */
+static constexpr uint DRIFT_MODEL_MAX_REJECTED = 8;
+
+ClockDriftModel::ClockDriftModel(double driftNoise)
+    : m_driftNoise(driftNoise)
+{
+    reset(0, 0, 1, 1);
+}
+
+/**
+ * @brief Reset the model to a calibrated offset with unknown drift.
+ *
+ * @param timeSec Time of the calibrated offset, in seconds
+ * @param offsetUsec The calibrated offset
+ * @param offsetVar Variance of the calibrated offset
+ * @param measurementVar Variance of individual offset measurements
+ */
+void ClockDriftModel::reset(double timeSec, double offsetUsec, double offsetVar, double measurementVar)
+{
+    m_measurementVar = std::max(measurementVar, 1.0);
+    m_time = timeSec;
+    m_offset = offsetUsec;
+    m_drift = 0;
+    m_p00 = std::max(offsetVar, 1.0);
+    m_p01 = 0;
+    m_p11 = 100.0 * 100.0; // we expect clocks to drift by well below 100ppm
+    m_rejectedCount = 0;
+}
+
+/**
+ * @brief Add a new offset measurement to the model.
+ *
+ * @return false if the measurement was rejected as outlier.
+ */
+bool ClockDriftModel::update(double timeSec, double offsetUsec)
+{
+    // predict the state at the new time
+    const auto dt = std::max(timeSec - m_time, 0.0);
+    const auto q = m_driftNoise;
+    const auto offset = m_offset + (m_drift * dt);
+    auto p00 = m_p00 + (2 * dt * m_p01) + (dt * dt * m_p11) + (q * dt * dt * dt / 3.0);
+    const auto p01 = m_p01 + (dt * m_p11) + (q * dt * dt / 2.0);
+    const auto p11 = m_p11 + (q * dt);
+
+    m_time = timeSec;
+    m_offset = offset;
+    m_p00 = p00;
+    m_p01 = p01;
+    m_p11 = p11;
+
+    const auto innovation = offsetUsec - offset;
+    if ((innovation * innovation) > 16.0 * (p00 + m_measurementVar)) {
+        // not within 4 SD of our expectation, so this is likely a fluke - unless
+        // it keeps happening, in which case the offset really has changed.
+        m_rejectedCount++;
+        if (m_rejectedCount < DRIFT_MODEL_MAX_REJECTED)
+            return false;
+        p00 += innovation * innovation;
+    }
+    m_rejectedCount = 0;
+
+    const auto s = p00 + m_measurementVar;
+    const auto k0 = p00 / s;
+    const auto k1 = p01 / s;
+    m_offset += k0 * innovation;
+    m_drift += k1 * innovation;
+    m_p00 = (1 - k0) * p00;
+    m_p01 = (1 - k0) * p01;
+    m_p11 = p11 - (k1 * p01);
+
+    return true;
+}
+
+double ClockDriftModel::offset() const
+{
+    return m_offset;
+}
+
+double ClockDriftModel::drift() const
+{
+    return m_drift;
+}
+
+double ClockDriftModel::offsetAt(double timeSec) const
+{
+    return m_offset + (m_drift * (timeSec - m_time));
+}
+
+double ClockDriftModel::offsetVariance() const
+{
+    return m_p00;
+}
+
+double ClockDriftModel::driftVariance() const
+{
+    return m_p11;
+}
+
+double ClockDriftModel::offsetDriftCovariance() const
+{
+    return m_p01;
+}
+
+double ClockDriftModel::measurementVariance() const
+{
+    return m_measurementVar;
+}
+
+double ClockDriftModel::driftNoise() const
+{
+    return m_driftNoise;
+}
+
+double ClockDriftModel::lastTime() const
+{
+    return m_time;
+}
+
+// -------------------
+// SyncTelemetryBuffer
+// -------------------
+
+SyncTelemetryBuffer::SyncTelemetryBuffer(size_t capacity, int synchronizerIndex)
+    : m_syncIndex(synchronizerIndex),
+      m_head(0),
+      m_tail(0),
+      m_droppedCount(0)
+{
+    // round up to a power of two, so we can wrap around with a simple mask
+    size_t size = 2;
+    while (size < capacity)
+        size <<= 1;
+    m_records.resize(size);
+    m_mask = size - 1;
+}
+
+/**
+ * @brief Add a new telemetry record.
+ *
+ * This must only be called from a single thread at a time, and never blocks.
+ *
+ * @return false if the record was dropped because the buffer is full.
+ */
+bool SyncTelemetryBuffer::append(
+    const microseconds_t &timestamp,
+    double offsetUsec,
+    double filteredOffsetUsec,
+    double correctionUsec)
+{
+    const auto head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) > m_mask) {
+        m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    auto &rec = m_records[head & m_mask];
+    rec.timestamp = timestamp.count();
+    rec.offset = offsetUsec;
+    rec.filteredOffset = filteredOffsetUsec;
+    rec.correction = correctionUsec;
+    m_head.store(head + 1, std::memory_order_release);
+
+    return true;
+}
+
+/**
+ * @brief Move all pending records into a signal block.
+ *
+ * The block receives the master timestamps of the records and four data columns,
+ * containing the offset, filtered offset and applied correction in µs, followed
+ * by the index of the synchronizer that produced the record.
+ * This must only be called from a single thread at a time.
+ *
+ * @return The number of records taken, the block is left untouched if there were none.
+ */
+size_t SyncTelemetryBuffer::takeAll(FloatSignalBlock &block)
+{
+    const auto tail = m_tail.load(std::memory_order_relaxed);
+    const auto count = m_head.load(std::memory_order_acquire) - tail;
+    if (count == 0)
+        return 0;
+
+    block.timestamps.resize(count);
+    block.data.resize(count, 4);
+    for (size_t i = 0; i < count; i++) {
+        const auto &rec = m_records[(tail + i) & m_mask];
+        block.timestamps[i] = rec.timestamp;
+        block.data(i, 0) = rec.offset;
+        block.data(i, 1) = rec.filteredOffset;
+        block.data(i, 2) = rec.correction;
+        block.data(i, 3) = m_syncIndex;
+    }
+    m_tail.store(tail + count, std::memory_order_release);
+
+    return count;
+}
+
+size_t SyncTelemetryBuffer::droppedCount() const
+{
+    return m_droppedCount.load(std::memory_order_relaxed);
+}
+
+int SyncTelemetryBuffer::synchronizerIndex() const
+{
+    return m_syncIndex;
+}
+
 // -----------------------
 // FreqCounterSynchronizer
 // -----------------------
@@ -87,7 +321,6 @@ FreqCounterSynchronizer::FreqCounterSynchronizer(
       m_syTimer(masterTimer),
       m_toleranceUsec(SECONDARY_CLOCK_TOLERANCE.count()),
       m_calibrationMaxBlockN(500),
-      m_calibrationIdx(0),
       m_haveExpectedOffset(false),
       m_freq(frequencyHz),
       m_lastValidMasterTimestamp(0),
@@ -117,6 +350,11 @@ void FreqCounterSynchronizer::setNotifyCallbacks(
         m_detailsChangeNotifyFn(m_id, m_strategies, std::chrono::microseconds(m_toleranceUsec));
 }
 
+void FreqCounterSynchronizer::setTelemetryBuffer(std::shared_ptr<SyncTelemetryBuffer> buffer)
+{
+    m_telemetry = buffer;
+}
+
 int FreqCounterSynchronizer::indexOffset() const
 {
     return m_indexOffset;
@@ -192,6 +430,8 @@ bool FreqCounterSynchronizer::start()
     if (m_strategies.testFlag(TimeSyncStrategy::WRITE_TSYNCFILE)) {
         m_tswriter->setSyncMode(TSyncFileMode::SYNCPOINTS);
         m_tswriter->setTimeDataTypes(TSyncFileDataType::INT64, TSyncFileDataType::INT64);
+        // we are usually called from acquisition threads, which should never wait for disk I/O
+        m_tswriter->setAsyncWriting(true);
         if (!m_tswriter->open(m_modName, m_collectionId, microseconds_t(m_toleranceUsec))) {
             qCCritical(logTimeSync).noquote().nospace()
                 << "Unable to open timesync file for " << m_modName << "[" << m_id << "]: " << m_tswriter->lastError();
@@ -202,9 +442,8 @@ bool FreqCounterSynchronizer::start()
     m_lastOffsetWithinTolerance = false;
     m_timeCorrectionOffset = microseconds_t(0);
     m_haveExpectedOffset = false;
-    m_calibrationIdx = 0;
     m_expectedOffsetCalCount = 0;
-    m_tsOffsetsUsec = VectorXsl::Zero(m_calibrationMaxBlockN);
+    m_tsOffsetStats.reset(m_calibrationMaxBlockN);
     m_lastTimeIndex = 0;
     m_indexOffset = 0;
     m_offsetChangeWaitBlocks = 0;
@@ -241,34 +480,42 @@ void FreqCounterSynchronizer::stop()
     m_tswriter->close();
 }
 
-void FreqCounterSynchronizer::processTimestamps(
+template<typename T>
+void FreqCounterSynchronizer::processTimestampsInternal(
     const microseconds_t &blocksRecvTimestamp,
     int blockIndex,
     int blockCount,
-    VectorXul &idxTimestamps)
+    const T *idxIn,
+    quint64 *idxOut,
+    size_t count)
 {
     // basic input value sanity checks
     assert(blockCount >= 1);
     assert(blockIndex >= 0);
     assert(blockIndex < blockCount);
+    assert(count >= 1);
 
     // get last index value of vector before we made any adjustments to it
-    const auto secondaryLastIdxUnadjusted = idxTimestamps[idxTimestamps.rows() - 1];
+    const quint64 secondaryLastIdxUnadjusted = idxIn[count - 1];
     m_lastSecondaryIdxUnandjusted = secondaryLastIdxUnadjusted;
 
-    // adjust timestamp based on our current offset
-    if (m_applyIndexOffset && (m_indexOffset != 0))
-        idxTimestamps -= VectorXul::Ones(idxTimestamps.rows()) * m_indexOffset;
+    // widen and adjust timestamps based on our current offset in one go
+    // (idxIn and idxOut may be the same buffer, so we must not read idxIn anymore after this)
+    const quint64 idxOffset = m_applyIndexOffset ? static_cast<quint64>(m_indexOffset) : 0;
+    if (idxOffset != 0 || static_cast<const void *>(idxIn) != static_cast<const void *>(idxOut)) {
+        for (size_t i = 0; i < count; ++i)
+            idxOut[i] = static_cast<quint64>(idxIn[i]) - idxOffset;
+    }
 
     // timestamp when (as far and well as we can guess...) the current block was actually acquired, in microseconds
     // and based on the master clock timestamp generated upon data receival.
     const microseconds_t masterAssumedAcqTS =
-        blocksRecvTimestamp - microseconds_t(std::lround(m_timePerPointUs * ((blockCount - 1) * idxTimestamps.rows())))
-        + microseconds_t(std::lround(m_timePerPointUs * (blockIndex * idxTimestamps.rows())));
+        blocksRecvTimestamp
+        - microseconds_t(std::lround(m_timePerPointUs * (static_cast<double>(blockCount - 1 - blockIndex) * count)));
     m_lastMasterAssumedAcqTS = masterAssumedAcqTS;
 
     // value of the last entry of the current block
-    const auto secondaryLastIdx = idxTimestamps[idxTimestamps.rows() - 1];
+    const auto secondaryLastIdx = idxOut[count - 1];
 
     // Timestamp, in microseconds, when according to the device frequency the last datapoint of this block was acquired
     // since we assume a zero-indexed time series, we need to add one to the secondary index
@@ -283,15 +530,21 @@ void FreqCounterSynchronizer::processTimestamps(
     // calculate time offset
     const int64_t curOffsetUsec = (secondaryLastTS - masterAssumedAcqTS).count();
 
-    // add new datapoint to our "memory" vector
-    m_tsOffsetsUsec[m_calibrationIdx++] = curOffsetUsec;
-    if (m_calibrationIdx >= m_calibrationMaxBlockN)
-        m_calibrationIdx = 0;
+    // add new datapoint to our "memory" window
+    m_tsOffsetStats.push(curOffsetUsec);
 
     // calculate offsets and offset expectation delta
-    const int64_t avgOffsetUsec = m_tsOffsetsUsec.mean();
+    const int64_t avgOffsetUsec = m_tsOffsetStats.mean();
     const int64_t avgOffsetDeviationUsec = avgOffsetUsec - m_expectedOffset.count();
 
+    // record what we measured and which correction was applied to this block
+    if (m_telemetry && m_haveExpectedOffset)
+        m_telemetry->append(
+            masterAssumedAcqTS,
+            curOffsetUsec - m_expectedOffset.count(),
+            avgOffsetDeviationUsec,
+            m_applyIndexOffset ? m_indexOffset * m_timePerPointUs : 0);
+
     // we do nothing more until we have enough measurements to estimate the "natural" timer offset
     // of the secondary clock and master clock
     if (!m_haveExpectedOffset) {
@@ -304,8 +557,8 @@ void FreqCounterSynchronizer::processTimestamps(
         if (m_expectedOffsetCalCount < (m_calibrationMaxBlockN * 2))
             return;
 
-        m_expectedSD = sqrt(vectorVariance(m_tsOffsetsUsec));
-        m_expectedOffset = microseconds_t(std::lround(vectorMedian(m_tsOffsetsUsec)));
+        m_expectedSD = sqrt(m_tsOffsetStats.variance());
+        m_expectedOffset = microseconds_t(std::lround(m_tsOffsetStats.median()));
 
         qCDebug(logTimeSync).noquote().nospace()
             << QTime::currentTime().toString() << "[" << m_id << "] "
@@ -365,7 +618,7 @@ void FreqCounterSynchronizer::processTimestamps(
     const double offsetDiffToAvg = abs(avgOffsetUsec - curOffsetUsec);
     if (offsetDiffToAvg > m_expectedSD) {
         // "sane value threshold" is 1.5x the standard deviation of the offsets
-        const int64_t offsetsSDThr = 1.5 * sqrt(vectorVariance(m_tsOffsetsUsec, avgOffsetUsec, true));
+        const int64_t offsetsSDThr = 1.5 * sqrt(m_tsOffsetStats.variance(avgOffsetUsec, true));
         if (offsetDiffToAvg > offsetsSDThr) {
             // the current offset diff to the moving average offset is not within standard deviation range.
             // This means the data point we just added is likely a fluke, potentially due to a context switch
@@ -429,8 +682,11 @@ void FreqCounterSynchronizer::processTimestamps(
         }
 
         // already apply offset as gradient to the current vector, if we are permitted to make that change
-        if (initialOffset && m_applyIndexOffset)
-            idxTimestamps -= VectorXul::LinSpaced(idxTimestamps.rows(), 0, m_indexOffset);
+        // (mapping the buffer keeps Eigen's integer gradient, without allocating a temporary vector)
+        if (initialOffset && m_applyIndexOffset) {
+            Eigen::Map<VectorXul> idxVec(idxOut, static_cast<Eigen::Index>(count));
+            idxVec -= VectorXul::LinSpaced(idxVec.rows(), 0, m_indexOffset);
+        }
     }
 
     // we're out of sync, record that fact to the tsync file if we are writing one
@@ -445,6 +701,38 @@ void FreqCounterSynchronizer::processTimestamps(
     m_lastTimeIndex = secondaryLastIdx;
 }
 
+void FreqCounterSynchronizer::processTimestamps(
+    const microseconds_t &blocksRecvTimestamp,
+    int blockIndex,
+    int blockCount,
+    VectorXul &idxTimestamps)
+{
+    processTimestampsInternal<quint64>(
+        blocksRecvTimestamp, blockIndex, blockCount, idxTimestamps.data(), idxTimestamps.data(), idxTimestamps.rows());
+}
+
+void FreqCounterSynchronizer::processTimestamps(
+    const microseconds_t &blocksRecvTimestamp,
+    int blockIndex,
+    int blockCount,
+    quint64 *idxTimestamps,
+    size_t count)
+{
+    processTimestampsInternal<quint64>(
+        blocksRecvTimestamp, blockIndex, blockCount, idxTimestamps, idxTimestamps, count);
+}
+
+void FreqCounterSynchronizer::processTimestamps(
+    const microseconds_t &blocksRecvTimestamp,
+    int blockIndex,
+    int blockCount,
+    const uint32_t *idxTimestamps,
+    quint64 *result,
+    size_t count)
+{
+    processTimestampsInternal<uint32_t>(blocksRecvTimestamp, blockIndex, blockCount, idxTimestamps, result, count);
+}
+
 // --------------------------
 // SecondaryClockSynchronizer
 // --------------------------
@@ -460,8 +748,8 @@ SecondaryClockSynchronizer::SecondaryClockSynchronizer(
       m_syTimer(masterTimer),
       m_toleranceUsec(SECONDARY_CLOCK_TOLERANCE.count()),
       m_calibrationMaxN(400),
-      m_calibrationIdx(0),
       m_haveExpectedOffset(false),
+      m_estimator(ClockOffsetEstimator::WINDOW_MEDIAN),
       m_tswriter(new TimeSyncFileWriter)
 {
     if (m_id.isEmpty())
@@ -531,6 +819,31 @@ void SecondaryClockSynchronizer::setExpectedClockFrequencyHz(double frequency)
     emitSyncDetailsChanged();
 }
 
+void SecondaryClockSynchronizer::setOffsetEstimator(ClockOffsetEstimator estimator)
+{
+    if (m_haveExpectedOffset) {
+        qCWarning(logTimeSync).noquote() << "Rejected offset estimator change on active Clock Synchronizer for"
+                                         << m_modName;
+        return;
+    }
+    m_estimator = estimator;
+}
+
+void SecondaryClockSynchronizer::setTelemetryBuffer(std::shared_ptr<SyncTelemetryBuffer> buffer)
+{
+    m_telemetry = buffer;
+}
+
+ClockOffsetEstimator SecondaryClockSynchronizer::offsetEstimator() const
+{
+    return m_estimator;
+}
+
+const ClockDriftModel &SecondaryClockSynchronizer::driftModel() const
+{
+    return m_driftModel;
+}
+
 void SecondaryClockSynchronizer::setTimeSyncBasename(const QString &fname, const QUuid &collectionId)
 {
     m_collectionId = collectionId;
@@ -579,7 +892,21 @@ bool SecondaryClockSynchronizer::start()
     if (m_strategies.testFlag(TimeSyncStrategy::WRITE_TSYNCFILE)) {
         m_tswriter->setSyncMode(TSyncFileMode::SYNCPOINTS);
         m_tswriter->setTimeDataTypes(TSyncFileDataType::INT64, TSyncFileDataType::INT64);
-        if (!m_tswriter->open(m_modName, m_collectionId, microseconds_t(m_toleranceUsec))) {
+        // we are usually called from acquisition threads, which should never wait for disk I/O
+        m_tswriter->setAsyncWriting(true);
+
+        // record how the sync points were determined, so they can be interpreted correctly later
+        QVariantHash userData;
+        userData.insert(QStringLiteral("clock_offset_estimator"), clockOffsetEstimatorToString(m_estimator));
+        userData.insert(QStringLiteral("calibration_points"), m_calibrationMaxN);
+        if (m_estimator == ClockOffsetEstimator::DRIFT_MODEL) {
+            userData.insert(QStringLiteral("drift_model_process_noise"), m_driftModel.driftNoise());
+
+            // leave room for the final model state, which we only know once we are stopped
+            m_tswriter->setUserDataReserve(512);
+        }
+
+        if (!m_tswriter->open(m_modName, m_collectionId, microseconds_t(m_toleranceUsec), userData)) {
             qCCritical(logTimeSync).noquote().nospace()
                 << "Unable to open timesync file for " << m_modName << "[" << m_id << "]: " << m_tswriter->lastError();
             return false;
@@ -594,13 +921,15 @@ bool SecondaryClockSynchronizer::start()
     m_lastOffsetWithinTolerance = false;
     m_clockCorrectionOffset = microseconds_t(0);
     m_haveExpectedOffset = false;
-    m_calibrationIdx = 0;
     m_expectedOffsetCalCount = 0;
     m_expectedOffset = microseconds_t(0);
-    m_clockOffsetsUsec = VectorXsl::Zero(m_calibrationMaxN);
+    m_clockOffsetStats.reset(m_calibrationMaxN);
     m_lastMasterTS = m_syTimer->timeSinceStartMsec();
     m_lastSecondaryAcqTS = microseconds_t(0);
     m_clockUpdateWaitPoints = 0;
+    m_tsyncLastTimeSec = 0;
+    m_tsyncLastOffset = 0;
+    m_tsyncLastDrift = 0;
 
     return true;
 }
@@ -609,8 +938,38 @@ void SecondaryClockSynchronizer::stop()
 {
     // write the last acquired timestamp pair, to simplify data post processing
     if (m_strategies.testFlag(TimeSyncStrategy::WRITE_TSYNCFILE)) {
-        if (m_lastSecondaryAcqTS.count() != 0)
+        if (m_haveExpectedOffset && m_estimator == ClockOffsetEstimator::DRIFT_MODEL) {
+            const auto lastOffset = m_driftModel.offsetAt(m_lastSecondaryAcqTS.count() / 1000.0 / 1000.0);
+            m_tswriter->writeTimes(
+                m_lastSecondaryAcqTS, m_lastSecondaryAcqTS - microseconds_t(std::lround(lastOffset)));
+        } else if (m_lastSecondaryAcqTS.count() != 0) {
             m_tswriter->writeTimes(m_lastSecondaryAcqTS, m_lastMasterTS);
+        }
+    }
+
+    if (m_haveExpectedOffset && m_estimator == ClockOffsetEstimator::DRIFT_MODEL) {
+        qCDebug(logTimeSync).noquote().nospace()
+            << "[" << m_id << "] "
+            << "Final drift model state: offset " << m_driftModel.offset() << "µs, "
+            << "drift " << m_driftModel.drift() << "ppm, "
+            << "offset SD " << sqrt(m_driftModel.offsetVariance());
+
+        // persist the fitted model, so the sync points can be interpreted without re-fitting it
+        if (m_strategies.testFlag(TimeSyncStrategy::WRITE_TSYNCFILE)) {
+            QVariantHash modelData;
+            modelData.insert(QStringLiteral("drift_model_time_sec"), m_driftModel.lastTime());
+            modelData.insert(QStringLiteral("drift_model_offset_us"), m_driftModel.offset());
+            modelData.insert(QStringLiteral("drift_model_drift_ppm"), m_driftModel.drift());
+            // covariance of the state as [var(offset), cov(offset, drift), var(drift)]
+            modelData.insert(
+                QStringLiteral("drift_model_covariance"),
+                QVariantList() << m_driftModel.offsetVariance() << m_driftModel.offsetDriftCovariance()
+                               << m_driftModel.driftVariance());
+            if (!m_tswriter->updateUserData(modelData))
+                qCWarning(logTimeSync).noquote().nospace()
+                    << "Unable to store final drift model state for " << m_modName << "[" << m_id
+                    << "]: " << m_tswriter->lastError();
+        }
     }
 
     m_tswriter->close();
@@ -619,17 +978,40 @@ void SecondaryClockSynchronizer::stop()
 void SecondaryClockSynchronizer::processTimestamp(
     microseconds_t &masterTimestamp,
     const microseconds_t &secondaryAcqTimestamp)
+{
+    if (!m_telemetry) {
+        processTimestampInternal(masterTimestamp, secondaryAcqTimestamp);
+        return;
+    }
+
+    const auto recvMasterTimestamp = masterTimestamp;
+    processTimestampInternal(masterTimestamp, secondaryAcqTimestamp);
+    if (!m_haveExpectedOffset)
+        return;
+
+    // record what we measured and the correction we made to the timestamp
+    const double expectedOffsetUsec = m_expectedOffset.count();
+    const double filteredOffsetUsec = m_estimator == ClockOffsetEstimator::DRIFT_MODEL ? m_driftModel.offset()
+                                                                                        : m_clockOffsetStats.mean();
+    m_telemetry->append(
+        recvMasterTimestamp,
+        (secondaryAcqTimestamp - recvMasterTimestamp).count() - expectedOffsetUsec,
+        filteredOffsetUsec - expectedOffsetUsec,
+        (recvMasterTimestamp - masterTimestamp).count());
+}
+
+void SecondaryClockSynchronizer::processTimestampInternal(
+    microseconds_t &masterTimestamp,
+    const microseconds_t &secondaryAcqTimestamp)
 {
     const int64_t curOffsetUsec = (secondaryAcqTimestamp - masterTimestamp).count();
 
     // calculate offsets without the new datapoint included
-    const int64_t avgOffsetUsec = m_clockOffsetsUsec.mean();
+    const int64_t avgOffsetUsec = m_clockOffsetStats.mean();
     const int64_t avgOffsetDeviationUsec = avgOffsetUsec - m_expectedOffset.count();
 
-    // add new datapoint to our "memory" vector
-    m_clockOffsetsUsec[m_calibrationIdx++] = curOffsetUsec;
-    if (m_calibrationIdx >= m_calibrationMaxN)
-        m_calibrationIdx = 0;
+    // add new datapoint to our "memory" window
+    m_clockOffsetStats.push(curOffsetUsec);
 
     // update delay-after-adjustment counter
     if (m_clockUpdateWaitPoints > 0)
@@ -644,11 +1026,25 @@ void SecondaryClockSynchronizer::processTimestamp(
         // few values in the vector stem from the initialization phase of Syntalos and may have
         // a higher variance than actually expected during normal operation (as in the startup
         // phase, the system load is high and lots of external devices are starting up)
-        if (m_expectedOffsetCalCount < (m_calibrationMaxN * 2))
+        // The drift model refines its offset estimate continuously, so it only needs a single window.
+        const auto calibrationN = m_estimator == ClockOffsetEstimator::DRIFT_MODEL ? m_calibrationMaxN
+                                                                                    : m_calibrationMaxN * 2;
+        if (m_expectedOffsetCalCount < calibrationN)
             return;
 
-        m_expectedSD = sqrt(vectorVariance(m_clockOffsetsUsec));
-        m_expectedOffset = microseconds_t(std::lround(vectorMedian(m_clockOffsetsUsec)));
+        m_expectedSD = sqrt(m_clockOffsetStats.variance());
+        m_expectedOffset = microseconds_t(std::lround(m_clockOffsetStats.median()));
+        if (m_estimator == ClockOffsetEstimator::DRIFT_MODEL) {
+            const auto measurementVar = m_expectedSD * m_expectedSD;
+            m_driftModel.reset(
+                secondaryAcqTimestamp.count() / 1000.0 / 1000.0,
+                m_expectedOffset.count(),
+                measurementVar / m_calibrationMaxN,
+                measurementVar);
+            m_tsyncLastTimeSec = 0;
+            m_tsyncLastOffset = m_expectedOffset.count();
+            m_tsyncLastDrift = 0;
+        }
 
         qCDebug(logTimeSync).noquote().nospace()
             << QTime::currentTime().toString() << "[" << m_id << "] "
@@ -667,9 +1063,14 @@ void SecondaryClockSynchronizer::processTimestamp(
         return;
     }
 
+    if (m_estimator == ClockOffsetEstimator::DRIFT_MODEL) {
+        processTimestampDriftModel(masterTimestamp, secondaryAcqTimestamp);
+        return;
+    }
+
     const double offsetDiffToAvg = abs(avgOffsetUsec - curOffsetUsec);
     if (offsetDiffToAvg > m_expectedSD) {
-        const double offsetsSDThr = 2 * sqrt(vectorVariance(m_clockOffsetsUsec, avgOffsetUsec, true));
+        const double offsetsSDThr = 2 * sqrt(m_clockOffsetStats.variance(avgOffsetUsec, true));
         if (offsetDiffToAvg > offsetsSDThr) {
             // the current offset diff to the moving average offset is not within the defined, standard-deviation-based
             // range. This means the data point we just added is likely a fluke, potentially due to a context switch
@@ -806,6 +1207,60 @@ void SecondaryClockSynchronizer::processTimestamp(
     m_lastMasterTS = masterTimestamp;
 }
 
+void SecondaryClockSynchronizer::processTimestampDriftModel(
+    microseconds_t &masterTimestamp,
+    const microseconds_t &secondaryAcqTimestamp)
+{
+    // the secondary clock does not suffer from transmission jitter, so we use it as time base for the model
+    const double secondaryTimeSec = secondaryAcqTimestamp.count() / 1000.0 / 1000.0;
+    const bool accepted = m_driftModel.update(secondaryTimeSec, (secondaryAcqTimestamp - masterTimestamp).count());
+
+    const double modelOffsetUsec = m_driftModel.offset();
+    const int64_t offsetDeviationUsec = std::lround(modelOffsetUsec - m_expectedOffset.count());
+    m_clockCorrectionOffset = microseconds_t(offsetDeviationUsec);
+
+    // notify about the current offset immediately if we crossed the tolerance boundary, and every 30sec otherwise
+    const bool withinTolerance = abs(offsetDeviationUsec) < m_toleranceUsec;
+    if ((withinTolerance != m_lastOffsetWithinTolerance)
+        || (masterTimestamp.count() > (m_lastOffsetEmission.count() + (30 * 1000 * 1000)))) {
+        if (m_offsetChangeNotifyFn)
+            m_offsetChangeNotifyFn(m_id, microseconds_t(offsetDeviationUsec));
+        m_lastOffsetEmission = masterTimestamp;
+    }
+    m_lastOffsetWithinTolerance = withinTolerance;
+
+    // the predicted master time for the current secondary time
+    const auto masterTimestampModel = secondaryAcqTimestamp - microseconds_t(std::lround(modelOffsetUsec));
+    if (!accepted) {
+        // correct flukes unconditionally, just like we do when not using the drift model
+        masterTimestamp = masterTimestampModel;
+    } else {
+        if (m_strategies.testFlag(TimeSyncStrategy::SHIFT_TIMESTAMPS_BWD) && offsetDeviationUsec > 0)
+            masterTimestamp = masterTimestampModel;
+        if (m_strategies.testFlag(TimeSyncStrategy::SHIFT_TIMESTAMPS_FWD) && offsetDeviationUsec < 0)
+            masterTimestamp = masterTimestampModel;
+    }
+
+    // prevent any time-travel into the past
+    if (masterTimestamp < m_lastMasterTS)
+        masterTimestamp = m_lastMasterTS + microseconds_t(1);
+
+    // Only write a new sync point if linear interpolation from the previous one would deviate
+    // too much from the model. Between these points, the model is (nearly) linear anyway.
+    if (m_strategies.testFlag(TimeSyncStrategy::WRITE_TSYNCFILE)) {
+        const auto lineOffset = m_tsyncLastOffset + m_tsyncLastDrift * (secondaryTimeSec - m_tsyncLastTimeSec);
+        if (std::abs(modelOffsetUsec - lineOffset) > (m_toleranceUsec / 4.0)) {
+            m_tswriter->writeTimes(secondaryAcqTimestamp, masterTimestampModel);
+            m_tsyncLastTimeSec = secondaryTimeSec;
+            m_tsyncLastOffset = modelOffsetUsec;
+            m_tsyncLastDrift = m_driftModel.drift();
+        }
+    }
+
+    m_lastSecondaryAcqTS = secondaryAcqTimestamp;
+    m_lastMasterTS = masterTimestamp;
+}
+
 void SecondaryClockSynchronizer::emitSyncDetailsChanged()
 {
     if (m_detailsChangeNotifyFn)
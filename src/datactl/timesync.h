@@ -24,18 +24,22 @@
 #include <QMetaType>
 #include <QString>
 #include <QUuid>
+#include <atomic>
 #include <fstream>
 #include <memory>
 
 #include "datactl/eigenaux.h"
 #include "datactl/syclock.h"
 #include "datactl/tsyncfile.h"
+#include "datactl/windowstats.h"
 
 class QFile;
 
 namespace Syntalos
 {
 
+struct FloatSignalBlock;
+
 Q_DECLARE_LOGGING_CATEGORY(logTimeSync)
 
 /**
@@ -75,6 +79,17 @@ Q_DECLARE_OPERATORS_FOR_FLAGS(TimeSyncStrategies)
 const QString timeSyncStrategyToHString(const TimeSyncStrategy &strategy);
 const QString timeSyncStrategiesToHString(const TimeSyncStrategies &strategies);
 
+/**
+ * @brief Method used to estimate the offset of a secondary clock to the master clock
+ */
+enum class ClockOffsetEstimator {
+    WINDOW_MEDIAN = 0, /// Compare the moving average offset against a fixed expected offset, adjust in steps
+    DRIFT_MODEL = 1    /// Continuously estimate offset and drift, and correct every timestamp smoothly
+};
+
+const QString clockOffsetEstimatorToString(const ClockOffsetEstimator &estimator);
+ClockOffsetEstimator clockOffsetEstimatorFromString(const QString &str);
+
 } // namespace Syntalos
 
 Q_DECLARE_METATYPE(Syntalos::TimeSyncStrategies);
@@ -93,6 +108,82 @@ using SyncDetailsChangeNotifyFn =
  */
 using OffsetChangeNotifyFn = std::function<void(const QString &id, const microseconds_t &currentOffset)>;
 
+/**
+ * @brief Lock-free buffer for synchronizer telemetry
+ *
+ * A synchronizer appends one record per processed measurement from its acquisition
+ * thread, while a single other thread collects all pending records in batches.
+ * If the buffer is full, new records are dropped instead of blocking the producer.
+ * The synchronizer index identifies the synchronizer within its module, if the
+ * records of multiple synchronizers end up in the same stream.
+ */
+class SyncTelemetryBuffer
+{
+public:
+    explicit SyncTelemetryBuffer(size_t capacity = 4096, int synchronizerIndex = 0);
+
+    bool append(const microseconds_t &timestamp, double offsetUsec, double filteredOffsetUsec, double correctionUsec);
+    size_t takeAll(FloatSignalBlock &block);
+    size_t droppedCount() const;
+    int synchronizerIndex() const;
+
+private:
+    Q_DISABLE_COPY(SyncTelemetryBuffer)
+
+    struct Record {
+        int64_t timestamp;
+        double offset;
+        double filteredOffset;
+        double correction;
+    };
+
+    std::vector<Record> m_records;
+    size_t m_mask;
+    int m_syncIndex;
+    std::atomic<size_t> m_head;
+    std::atomic<size_t> m_tail;
+    std::atomic<size_t> m_droppedCount;
+};
+
+/**
+ * @brief Kalman filter estimating offset and linear drift between two clocks
+ *
+ * The filter state is the offset of a secondary clock to the master clock in µs,
+ * and the rate at which this offset changes in µs/s (which equals the drift in ppm).
+ * The drift itself is modelled as a slow random walk, to follow changes caused by
+ * e.g. temperature. Measurements that are very unlikely given the current estimate
+ * are rejected as outliers, unless they persist.
+ */
+class ClockDriftModel
+{
+public:
+    explicit ClockDriftModel(double driftNoise = 0.01);
+
+    void reset(double timeSec, double offsetUsec, double offsetVar, double measurementVar);
+    bool update(double timeSec, double offsetUsec);
+
+    double offset() const;
+    double drift() const;
+    double offsetAt(double timeSec) const;
+    double offsetVariance() const;
+    double driftVariance() const;
+    double offsetDriftCovariance() const;
+    double measurementVariance() const;
+    double driftNoise() const;
+    double lastTime() const;
+
+private:
+    double m_driftNoise;
+    double m_measurementVar;
+    double m_time;
+    double m_offset;
+    double m_drift;
+    double m_p00;
+    double m_p01;
+    double m_p11;
+    uint m_rejectedCount;
+};
+
 /**
  * @brief Synchronizer for a monotonic counter, given a frequency
  *
@@ -120,6 +211,15 @@ public:
         const SyncDetailsChangeNotifyFn &detailsChangeNotifyFn,
         const OffsetChangeNotifyFn &offsetChangeNotifyFn);
 
+    /**
+     * @brief Set a buffer to record telemetry for every processed block in.
+     *
+     * Each record contains the master timestamp of the block, the instantaneous
+     * and the averaged deviation from the expected offset, and the correction
+     * that was applied to the block.
+     */
+    void setTelemetryBuffer(std::shared_ptr<SyncTelemetryBuffer> buffer);
+
     void setCalibrationBlocksCount(int count);
     void setStrategies(const TimeSyncStrategies &strategies);
     void setTolerance(const std::chrono::microseconds &tolerance);
@@ -139,9 +239,46 @@ public:
         int blockCount,
         VectorXul &idxTimestamps);
 
+    /**
+     * @brief Adjust a block of index timestamps in-place.
+     *
+     * Same as the VectorXul variant, but operates on a caller-supplied buffer
+     * and never allocates memory.
+     */
+    void processTimestamps(
+        const microseconds_t &blocksRecvTimestamp,
+        int blockIndex,
+        int blockCount,
+        quint64 *idxTimestamps,
+        size_t count);
+
+    /**
+     * @brief Widen and adjust a block of 32-bit index timestamps.
+     *
+     * Converts @p idxTimestamps to 64-bit values, applies the current index offset
+     * and writes the result to @p result in a single pass.
+     * @p result must have space for @p count values.
+     */
+    void processTimestamps(
+        const microseconds_t &blocksRecvTimestamp,
+        int blockIndex,
+        int blockCount,
+        const uint32_t *idxTimestamps,
+        quint64 *result,
+        size_t count);
+
 private:
     Q_DISABLE_COPY(FreqCounterSynchronizer)
 
+    template<typename T>
+    void processTimestampsInternal(
+        const microseconds_t &blocksRecvTimestamp,
+        int blockIndex,
+        int blockCount,
+        const T *idxIn,
+        quint64 *idxOut,
+        size_t count);
+
     QString m_modName;
     QUuid m_collectionId;
     QString m_id;
@@ -156,8 +293,7 @@ private:
     bool m_lastOffsetWithinTolerance;
 
     uint m_calibrationMaxBlockN;
-    uint m_calibrationIdx;
-    VectorXsl m_tsOffsetsUsec;
+    SlidingWindowStats m_tsOffsetStats;
 
     bool m_haveExpectedOffset;
     uint m_expectedOffsetCalCount;
@@ -177,6 +313,7 @@ private:
     microseconds_t m_lastMasterAssumedAcqTS;
     microseconds_t m_lastValidMasterTimestamp;
 
+    std::shared_ptr<SyncTelemetryBuffer> m_telemetry;
     std::unique_ptr<TimeSyncFileWriter> m_tswriter;
 };
 
@@ -202,6 +339,15 @@ public:
         const SyncDetailsChangeNotifyFn &detailsChangeNotifyFn,
         const OffsetChangeNotifyFn &offsetChangeNotifyFn);
 
+    /**
+     * @brief Set a buffer to record telemetry for every processed timestamp in.
+     *
+     * Each record contains the master timestamp as received, the instantaneous
+     * and the filtered deviation from the expected offset, and the correction
+     * that was applied to the timestamp.
+     */
+    void setTelemetryBuffer(std::shared_ptr<SyncTelemetryBuffer> buffer);
+
     /**
      * @brief An adjustment offset to pring the secondary clock back to speed.
      *
@@ -220,6 +366,18 @@ public:
      */
     void setExpectedClockFrequencyHz(double frequency);
 
+    /**
+     * @brief Select how the clock offset is estimated.
+     *
+     * With the drift model, calibration only needs a single window of points, and
+     * timestamps are corrected continuously instead of in steps once the deviation
+     * exceeds the tolerance. TSync files then only receive a new point once the
+     * corrections can no longer be linearly interpolated within tolerance.
+     */
+    void setOffsetEstimator(ClockOffsetEstimator estimator);
+    ClockOffsetEstimator offsetEstimator() const;
+    const ClockDriftModel &driftModel() const;
+
     void setStrategies(const TimeSyncStrategies &strategies);
     void setTolerance(const microseconds_t &tolerance);
     void setTimeSyncBasename(const QString &fname, const QUuid &collectionId);
@@ -235,6 +393,8 @@ private:
     Q_DISABLE_COPY(SecondaryClockSynchronizer)
 
     void emitSyncDetailsChanged();
+    void processTimestampInternal(microseconds_t &masterTimestamp, const microseconds_t &secondaryAcqTimestamp);
+    void processTimestampDriftModel(microseconds_t &masterTimestamp, const microseconds_t &secondaryAcqTimestamp);
 
     QString m_modName;
     QUuid m_collectionId;
@@ -250,8 +410,7 @@ private:
     bool m_lastOffsetWithinTolerance;
 
     uint m_calibrationMaxN;
-    uint m_calibrationIdx;
-    VectorXsl m_clockOffsetsUsec;
+    SlidingWindowStats m_clockOffsetStats;
 
     bool m_haveExpectedOffset;
     uint m_expectedOffsetCalCount;
@@ -263,6 +422,13 @@ private:
     microseconds_t m_lastSecondaryAcqTS;
     uint m_clockUpdateWaitPoints;
 
+    ClockOffsetEstimator m_estimator;
+    ClockDriftModel m_driftModel;
+    double m_tsyncLastTimeSec;
+    double m_tsyncLastOffset;
+    double m_tsyncLastDrift;
+
+    std::shared_ptr<SyncTelemetryBuffer> m_telemetry;
     std::unique_ptr<TimeSyncFileWriter> m_tswriter;
 };
 
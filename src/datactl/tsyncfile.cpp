@@ -24,6 +24,18 @@
 #include <QFile>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QtEndian>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
 
 #include "utils/misc.h"
 
@@ -38,7 +50,10 @@ using namespace Syntalos;
 #define TSYNC_FILE_MAGIC 0xF223434E5953548A
 
 #define TSYNC_FILE_VERSION_MAJOR 1
-#define TSYNC_FILE_VERSION_MINOR 2
+#define TSYNC_FILE_VERSION_MINOR 3
+
+// files with raw-encoded data are still written in this version, so older tools can read them
+#define TSYNC_FILE_VERSION_MINOR_RAW 2
 
 #define TSYNC_FILE_BLOCK_TERM 0x1126000000000000
 
@@ -90,13 +105,313 @@ QString Syntalos::tsyncFileModeToString(const TSyncFileMode &mode)
     }
 }
 
+QString Syntalos::tsyncFileEncodingToString(const TSyncFileEncoding &encoding)
+{
+    switch (encoding) {
+    case TSyncFileEncoding::RAW:
+        return QStringLiteral("raw");
+    case TSyncFileEncoding::DELTA:
+        return QStringLiteral("delta");
+    default:
+        return QStringLiteral("INVALID");
+    }
+}
+
+static int tsyncDataTypeSize(TSyncFileDataType dtype)
+{
+    switch (dtype) {
+    case TSyncFileDataType::INT16:
+    case TSyncFileDataType::UINT16:
+        return 2;
+    case TSyncFileDataType::INT32:
+    case TSyncFileDataType::UINT32:
+        return 4;
+    case TSyncFileDataType::INT64:
+    case TSyncFileDataType::UINT64:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Sign- or zero-extend a raw time value after converting it to the given data type,
+ * so it has the value a reader of the file will see.
+ */
+static inline quint64 normalizeTimeValue(TSyncFileDataType dtype, quint64 raw)
+{
+    switch (dtype) {
+    case TSyncFileDataType::INT16:
+        return static_cast<quint64>(static_cast<qint64>(static_cast<qint16>(raw)));
+    case TSyncFileDataType::INT32:
+        return static_cast<quint64>(static_cast<qint64>(static_cast<qint32>(raw)));
+    case TSyncFileDataType::UINT16:
+        return static_cast<quint16>(raw);
+    case TSyncFileDataType::UINT32:
+        return static_cast<quint32>(raw);
+    default:
+        return raw;
+    }
+}
+
+/**
+ * Delta-encoded data blocks start with the number of entries and the payload size
+ * as two 32-bit integers. The payload contains the zigzag-varint encoded values of the
+ * first entry, followed by the differences between consecutive deltas for every further
+ * entry, so time series advancing at a constant rate only need a single byte per value.
+ * The payload is padded to keep the file 8-byte aligned.
+ */
+static constexpr size_t DELTA_BLOCK_HEADER_SIZE = 2 * sizeof(quint32);
+
+static inline void appendVarint(uchar *&dest, qint64 value)
+{
+    auto zz = (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+    while (zz >= 0x80) {
+        *dest++ = static_cast<uchar>(zz | 0x80);
+        zz >>= 7;
+    }
+    *dest++ = static_cast<uchar>(zz);
+}
+
+static inline bool readVarint(const uchar *&src, const uchar *end, qint64 &value)
+{
+    quint64 zz = 0;
+    for (int shift = 0; shift < 64 && src < end; shift += 7) {
+        const auto byte = *src++;
+        zz |= static_cast<quint64>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            value = static_cast<qint64>(zz >> 1) ^ -static_cast<qint64>(zz & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Decode the payload of a delta-encoded block into @p result, which must have space for @p count entries.
+ */
+static bool decodeDeltaBlock(const uchar *data, size_t size, size_t count, std::pair<long long, long long> *result)
+{
+    const uchar *end = data + size;
+    qint64 prev[2] = {0, 0};
+    qint64 prevDelta[2] = {0, 0};
+    for (size_t i = 0; i < count; i++) {
+        qint64 values[2];
+        for (int c = 0; c < 2; c++) {
+            qint64 v;
+            if (!readVarint(data, end, v))
+                return false;
+            if (i == 0) {
+                values[c] = v;
+            } else {
+                // calculate with unsigned values, wrapping around is expected for UINT64 data
+                const auto delta = static_cast<qint64>(static_cast<quint64>(prevDelta[c]) + static_cast<quint64>(v));
+                values[c] = static_cast<qint64>(static_cast<quint64>(prev[c]) + static_cast<quint64>(delta));
+                prevDelta[c] = delta;
+            }
+            prev[c] = values[c];
+        }
+        result[i] = std::make_pair(values[0], values[1]);
+    }
+
+    return true;
+}
+
 // ------------------
 // TimeSyncFileWriter
 // ------------------
 
+/**
+ * Queue and background thread for asynchronous writing of time entries.
+ *
+ * The thread calling writeTimes() is the only producer, and the background
+ * thread the only consumer of a fixed-size ring buffer, so adding an entry
+ * only needs two atomic operations in the common case. The producer wakes the consumer
+ * once a data block is complete, which then checksums and writes the whole block.
+ */
+class TimeSyncFileWriter::AsyncWriter
+{
+public:
+    explicit AsyncWriter(TimeSyncFileWriter *owner)
+        : m_owner(owner),
+          m_blockSize(std::max(owner->m_blockSize, 1)),
+          m_head(0),
+          m_tail(0),
+          m_tailCache(0),
+          m_consumerWaiting(false),
+          m_producerWaiting(false),
+          m_flushTarget(0),
+          m_flushedPos(0),
+          m_stop(false)
+    {
+        // we need a power of two, and enough space to queue a few blocks while one is written
+        const auto minCapacity = std::max<size_t>(m_blockSize * 4, 16384);
+        m_capacity = 1;
+        while (m_capacity < minCapacity)
+            m_capacity <<= 1;
+        m_mask = m_capacity - 1;
+        m_ring = std::make_unique<RawEntry[]>(m_capacity);
+
+        m_thread = std::thread(&AsyncWriter::run, this);
+    }
+
+    ~AsyncWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+            m_consumerCond.notify_all();
+        }
+        m_thread.join();
+    }
+
+    void push(quint64 time1, quint64 time2)
+    {
+        const auto pos = m_head.load(std::memory_order_relaxed);
+        if (pos - m_tailCache >= m_capacity) {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            if (pos - m_tailCache >= m_capacity)
+                waitForSpace(pos);
+        }
+
+        m_ring[pos & m_mask] = RawEntry{time1, time2};
+        m_head.store(pos + 1, std::memory_order_seq_cst);
+
+        // blocks always start at multiples of the block size, so this is where one was completed
+        if ((pos + 1) % m_blockSize == 0 && m_consumerWaiting.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_consumerCond.notify_all();
+        }
+    }
+
+    /**
+     * Wait until all entries queued so far were written and the file was flushed.
+     */
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        const auto target = m_head.load(std::memory_order_relaxed);
+        m_flushTarget = std::max(m_flushTarget, target);
+        m_consumerCond.notify_all();
+        m_producerCond.wait(lock, [&] {
+            return m_flushedPos >= target;
+        });
+    }
+
+private:
+    TimeSyncFileWriter *m_owner;
+    size_t m_blockSize;
+    size_t m_capacity;
+    size_t m_mask;
+    std::unique_ptr<RawEntry[]> m_ring;
+
+    alignas(64) std::atomic<uint64_t> m_head;
+    alignas(64) std::atomic<uint64_t> m_tail;
+
+    // only accessed by the producer: last known read position of the consumer
+    uint64_t m_tailCache;
+
+    std::mutex m_mutex;
+    std::condition_variable m_consumerCond;
+    std::condition_variable m_producerCond;
+    std::atomic_bool m_consumerWaiting;
+    std::atomic_bool m_producerWaiting;
+    uint64_t m_flushTarget;
+    uint64_t m_flushedPos;
+    bool m_stop;
+    std::thread m_thread;
+
+    void waitForSpace(uint64_t pos)
+    {
+        qCDebug(logTSyncFile).noquote() << "Write queue for" << m_owner->m_file->fileName()
+                                        << "is full, waiting for data to be written.";
+        while (pos - m_tailCache >= m_capacity) {
+            m_producerWaiting.store(true, std::memory_order_seq_cst);
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_consumerCond.notify_all();
+                if (pos - m_tail.load(std::memory_order_seq_cst) >= m_capacity)
+                    m_producerCond.wait_for(lock, std::chrono::milliseconds(10));
+            }
+            m_producerWaiting.store(false, std::memory_order_relaxed);
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+        }
+    }
+
+    /**
+     * Number of entries that complete the currently open block.
+     */
+    uint64_t entriesToBlockEnd() const
+    {
+        return m_owner->m_blockSize > 0 ? m_owner->m_blockSize - m_owner->m_bIndex : 1;
+    }
+
+    void run()
+    {
+        std::vector<uchar> buffer;
+        while (true) {
+            bool stop;
+            bool flush;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_consumerWaiting.store(true, std::memory_order_seq_cst);
+                m_consumerCond.wait_for(lock, std::chrono::milliseconds(250), [&] {
+                    return m_stop || m_flushTarget > m_flushedPos
+                           || m_head.load(std::memory_order_seq_cst) - m_tail.load(std::memory_order_relaxed)
+                                  >= entriesToBlockEnd();
+                });
+                m_consumerWaiting.store(false, std::memory_order_relaxed);
+                stop = m_stop;
+                flush = m_flushTarget > m_flushedPos;
+            }
+
+            const auto head = m_head.load(std::memory_order_acquire);
+            const auto tail = m_tail.load(std::memory_order_relaxed);
+            auto end = head;
+            if (!stop && !flush) {
+                // only write complete blocks, unless we are asked to write everything
+                const auto toBlockEnd = entriesToBlockEnd();
+                if (head - tail < toBlockEnd)
+                    end = tail;
+                else
+                    end = tail + toBlockEnd + ((head - tail - toBlockEnd) / m_blockSize) * m_blockSize;
+            }
+
+            if (end > tail) {
+                const auto first = tail & m_mask;
+                const auto count = end - tail;
+                const auto firstChunk = std::min<uint64_t>(count, m_capacity - first);
+                m_owner->writeRawEntries(&m_ring[first], firstChunk, buffer);
+                if (count > firstChunk)
+                    m_owner->writeRawEntries(&m_ring[0], count - firstChunk, buffer);
+
+                m_tail.store(end, std::memory_order_seq_cst);
+                if (m_producerWaiting.load(std::memory_order_seq_cst)) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_producerCond.notify_all();
+                }
+            }
+
+            if (flush) {
+                m_owner->m_file->flush();
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_flushedPos = end;
+                m_producerCond.notify_all();
+            }
+
+            if (stop)
+                break;
+        }
+    }
+};
+
 TimeSyncFileWriter::TimeSyncFileWriter()
     : m_file(new QFile()),
-      m_bIndex(0)
+      m_bIndex(0),
+      m_userDataReserve(0),
+      m_userDataChanged(false),
+      m_encoding(TSyncFileEncoding::RAW),
+      m_asyncEnabled(false)
 {
     m_xxh3State = XXH3_createState();
 
@@ -139,8 +454,22 @@ void TimeSyncFileWriter::setTimeDataTypes(TSyncFileDataType time1DType, TSyncFil
     m_time2DType = time2DType;
 }
 
+/**
+ * Select how time values are stored in the file.
+ *
+ * Delta encoding typically reduces the file size by a factor of 5-10
+ * for continuous time mappings, but files using it can not be read by
+ * older versions of Syntalos. In this mode, data is only written to disk
+ * once a block is complete, or the file is closed.
+ */
+void TimeSyncFileWriter::setEncoding(TSyncFileEncoding encoding)
+{
+    m_encoding = encoding;
+}
+
 void TimeSyncFileWriter::setFileName(const QString &fname)
 {
+    m_async.reset();
     if (m_file->isOpen())
         m_file->close();
 
@@ -172,6 +501,68 @@ void TimeSyncFileWriter::setCreationTimeOverride(const QDateTime &dt)
     m_creationTimeOverride = dt;
 }
 
+bool TimeSyncFileWriter::asyncWriting() const
+{
+    return m_asyncEnabled;
+}
+
+/**
+ * Write time entries on a background thread.
+ *
+ * writeTimes() will then only queue the entries, and only blocks if the queue
+ * is full because the disk can not keep up. flush() and close() wait for all queued
+ * entries to be written, the resulting file is identical to one written synchronously.
+ * This setting takes effect when the file is opened next.
+ */
+void TimeSyncFileWriter::setAsyncWriting(bool enabled)
+{
+    m_asyncEnabled = enabled;
+}
+
+/**
+ * Reserve space for the user data in the file header.
+ *
+ * This permits values to be added to the user data with updateUserData()
+ * while the file is written, e.g. to store results that are only known at
+ * the end of a run. This setting takes effect when the file is opened next.
+ */
+void TimeSyncFileWriter::setUserDataReserve(int bytes)
+{
+    m_userDataReserve = bytes;
+}
+
+/**
+ * Add or replace values in the user data of an open file.
+ *
+ * The header is rewritten with the new values when the file is closed.
+ * This fails if the encoded user data does not fit into the space that
+ * was reserved with setUserDataReserve().
+ */
+bool TimeSyncFileWriter::updateUserData(const QVariantHash &userData)
+{
+    if (!m_file->isOpen()) {
+        m_lastError = QStringLiteral("Can not update user data of a file that is not open.");
+        return false;
+    }
+
+    auto udata = m_userData;
+    for (auto it = userData.constBegin(); it != userData.constEnd(); ++it)
+        udata.insert(it.key(), it.value());
+
+    auto userDataJson = QJsonDocument(QJsonObject::fromVariantHash(udata)).toJson(QJsonDocument::Compact);
+    if (userDataJson.size() > m_userDataJson.size()) {
+        m_lastError = QStringLiteral("Not enough space reserved in the file header to update its user data.");
+        return false;
+    }
+
+    // pad with whitespace, so the header keeps its exact size
+    userDataJson.append(QByteArray(m_userDataJson.size() - userDataJson.size(), ' '));
+    m_userData = udata;
+    m_userDataJson = userDataJson;
+    m_userDataChanged = true;
+    return true;
+}
+
 template<class T>
 void TimeSyncFileWriter::csWriteValue(const T &data)
 {
@@ -191,9 +582,15 @@ void TimeSyncFileWriter::csWriteValue<QByteArray>(const QByteArray &data)
 
 bool TimeSyncFileWriter::open(const QString &modName, const QUuid &collectionId, const QVariantHash &userData)
 {
+    m_async.reset();
     if (m_file->isOpen())
         m_file->close();
 
+    if (tsyncDataTypeSize(m_time1DType) == 0 || tsyncDataTypeSize(m_time2DType) == 0) {
+        m_lastError = QStringLiteral("Invalid time data types were set.");
+        return false;
+    }
+
     if (!m_file->open(QIODevice::WriteOnly)) {
         m_lastError = m_file->errorString();
         return false;
@@ -204,53 +601,27 @@ bool TimeSyncFileWriter::open(const QString &modName, const QUuid &collectionId,
         m_blockSize = 128;
 
     m_bIndex = 0;
-    XXH3_64bits_reset(m_xxh3State);
+    m_deltaEntries.clear();
     m_stream.setDevice(m_file);
 
     // user-defined metadata
-    QJsonDocument jdoc(QJsonObject::fromVariantHash(userData));
-    const QString userDataJson(jdoc.toJson(QJsonDocument::Compact));
-
-    // write file header
-    QDateTime currentTime = m_creationTimeOverride;
-    if (!currentTime.isValid())
-        currentTime = QDateTime::currentDateTime();
+    m_userData = userData;
+    m_userDataJson = QJsonDocument(QJsonObject::fromVariantHash(userData)).toJson(QJsonDocument::Compact);
+    if (m_userDataJson.size() < m_userDataReserve)
+        m_userDataJson.append(QByteArray(m_userDataReserve - m_userDataJson.size(), ' '));
+    m_userDataChanged = false;
+
+    m_modName = modName;
+    m_collectionId = collectionId;
+    m_creationTime = m_creationTimeOverride;
+    if (!m_creationTime.isValid())
+        m_creationTime = QDateTime::currentDateTime();
     m_creationTimeOverride = QDateTime();
 
-    m_stream << (quint64)TSYNC_FILE_MAGIC;
-
-    csWriteValue<quint16>(TSYNC_FILE_VERSION_MAJOR);
-    csWriteValue<quint16>(TSYNC_FILE_VERSION_MINOR);
+    writeHeader();
 
-    csWriteValue<qint64>(currentTime.toTime_t());
-
-    csWriteValue(modName.toUtf8());
-    csWriteValue(collectionId.toString(QUuid::WithoutBraces).toUtf8());
-    csWriteValue(userDataJson.toUtf8()); // custom JSON values
-
-    csWriteValue<quint16>((quint16)m_tsMode);
-    csWriteValue<qint32>(m_blockSize);
-
-    csWriteValue(m_timeNames.first.toUtf8());
-    csWriteValue<quint16>((quint16)m_timeUnits.first);
-    csWriteValue<quint16>((quint16)m_time1DType);
-
-    csWriteValue(m_timeNames.second.toUtf8());
-    csWriteValue<quint16>((quint16)m_timeUnits.second);
-    csWriteValue<quint16>((quint16)m_time2DType);
-
-    m_file->flush();
-    const auto headerBytes = m_file->size();
-    if (headerBytes <= 0)
-        qFatal("Could not determine amount of bytes written for tsync file header.");
-    const int padding = (headerBytes * -1) & (8 - 1); // 8-byte align header
-    for (int i = 0; i < padding; i++)
-        csWriteValue<quint8>(0);
-
-    // write end of header and header CRC-32
-    writeBlockTerminator(false);
-
-    m_file->flush();
+    if (m_asyncEnabled)
+        m_async = std::make_unique<AsyncWriter>(this);
     return true;
 }
 
@@ -267,16 +638,31 @@ bool TimeSyncFileWriter::open(
 
 void TimeSyncFileWriter::flush()
 {
-    if (m_file->isOpen())
+    if (m_async)
+        m_async->flush();
+    else if (m_file->isOpen())
         m_file->flush();
 }
 
 void TimeSyncFileWriter::close()
 {
+    // write all queued entries and stop the writer thread
+    m_async.reset();
+
     if (m_file->isOpen()) {
         // terminate the last open block, if we have one
         writeBlockTerminator();
 
+        // the updated user data has the same size, so we can just replace the header
+        if (m_userDataChanged) {
+            m_file->flush();
+            if (m_file->seek(0))
+                writeHeader();
+            else
+                qWarning().noquote() << "Unable to update tsync file header:" << m_file->errorString();
+            m_userDataChanged = false;
+        }
+
         // finish writing file to disk
         m_file->flush();
         m_file->close();
@@ -303,10 +689,57 @@ void TimeSyncFileWriter::writeTimes(const uint64_t &time1, const uint64_t &time2
     writeTimeEntry(time1, time2);
 }
 
+void TimeSyncFileWriter::writeHeader()
+{
+    XXH3_64bits_reset(m_xxh3State);
+    m_stream << (quint64)TSYNC_FILE_MAGIC;
+
+    csWriteValue<quint16>(TSYNC_FILE_VERSION_MAJOR);
+    if (m_encoding == TSyncFileEncoding::RAW)
+        csWriteValue<quint16>(TSYNC_FILE_VERSION_MINOR_RAW);
+    else
+        csWriteValue<quint16>(TSYNC_FILE_VERSION_MINOR);
+
+    csWriteValue<qint64>(m_creationTime.toTime_t());
+
+    csWriteValue(m_modName.toUtf8());
+    csWriteValue(m_collectionId.toString(QUuid::WithoutBraces).toUtf8());
+    csWriteValue(m_userDataJson); // custom JSON values
+
+    csWriteValue<quint16>((quint16)m_tsMode);
+    csWriteValue<qint32>(m_blockSize);
+
+    csWriteValue(m_timeNames.first.toUtf8());
+    csWriteValue<quint16>((quint16)m_timeUnits.first);
+    csWriteValue<quint16>((quint16)m_time1DType);
+
+    csWriteValue(m_timeNames.second.toUtf8());
+    csWriteValue<quint16>((quint16)m_timeUnits.second);
+    csWriteValue<quint16>((quint16)m_time2DType);
+
+    if (m_encoding != TSyncFileEncoding::RAW)
+        csWriteValue<quint16>((quint16)m_encoding);
+
+    m_file->flush();
+    const auto headerBytes = m_file->pos();
+    if (headerBytes <= 0)
+        qFatal("Could not determine amount of bytes written for tsync file header.");
+    const int padding = (headerBytes * -1) & (8 - 1); // 8-byte align header
+    for (int i = 0; i < padding; i++)
+        csWriteValue<quint8>(0);
+
+    // write end of header and header CRC-32
+    writeBlockTerminator(false);
+
+    m_file->flush();
+}
+
 void TimeSyncFileWriter::writeBlockTerminator(bool check)
 {
     if (check && (m_bIndex == 0))
         return;
+    if (!m_deltaEntries.empty())
+        writeDeltaBlockData();
     m_stream << (quint64)TSYNC_FILE_BLOCK_TERM;
     m_stream << (quint64)XXH3_64bits_digest(m_xxh3State);
     XXH3_64bits_reset(m_xxh3State);
@@ -319,6 +752,19 @@ void TimeSyncFileWriter::writeTimeEntry(const T1 &time1, const T2 &time2)
     static_assert(std::is_arithmetic<T1>::value, "T1 must be an arithmetic type.");
     static_assert(std::is_arithmetic<T2>::value, "T2 must be an arithmetic type.");
 
+    if (m_async) {
+        // integer conversion is modular, so converting to the final type on the writer thread
+        // yields the same values as converting them here
+        m_async->push(static_cast<quint64>(time1), static_cast<quint64>(time2));
+        return;
+    }
+    if (m_encoding == TSyncFileEncoding::DELTA) {
+        appendDeltaEntry(
+            normalizeTimeValue(m_time1DType, static_cast<quint64>(time1)),
+            normalizeTimeValue(m_time2DType, static_cast<quint64>(time2)));
+        return;
+    }
+
     switch (m_time1DType) {
     case TSyncFileDataType::INT16:
         csWriteValue<qint16>(time1);
@@ -372,9 +818,190 @@ void TimeSyncFileWriter::writeTimeEntry(const T1 &time1, const T2 &time2)
         writeBlockTerminator();
 }
 
+template<class T>
+static inline void appendRawValue(uchar *&dest, quint64 raw)
+{
+    const auto value = static_cast<T>(raw);
+    qToLittleEndian<T>(value, dest);
+    dest += sizeof(T);
+}
+
+static inline void appendRawValue(uchar *&dest, TSyncFileDataType dtype, quint64 raw)
+{
+    switch (dtype) {
+    case TSyncFileDataType::INT16:
+        appendRawValue<qint16>(dest, raw);
+        break;
+    case TSyncFileDataType::INT32:
+        appendRawValue<qint32>(dest, raw);
+        break;
+    case TSyncFileDataType::INT64:
+        appendRawValue<qint64>(dest, raw);
+        break;
+    case TSyncFileDataType::UINT16:
+        appendRawValue<quint16>(dest, raw);
+        break;
+    case TSyncFileDataType::UINT32:
+        appendRawValue<quint32>(dest, raw);
+        break;
+    case TSyncFileDataType::UINT64:
+        appendRawValue<quint64>(dest, raw);
+        break;
+    default:
+        qFatal("Tried to write unknown datatype to timesync file: %i", (int)dtype);
+        break;
+    }
+}
+
+/**
+ * Write queued entries in as few write and checksum operations as possible.
+ * Only called from the writer thread in asynchronous mode.
+ */
+void TimeSyncFileWriter::writeRawEntries(const RawEntry *entries, size_t count, std::vector<uchar> &buffer)
+{
+    if (m_encoding == TSyncFileEncoding::DELTA) {
+        for (size_t i = 0; i < count; i++)
+            appendDeltaEntry(
+                normalizeTimeValue(m_time1DType, entries[i].time1),
+                normalizeTimeValue(m_time2DType, entries[i].time2));
+        return;
+    }
+
+    const size_t entrySize = tsyncDataTypeSize(m_time1DType) + tsyncDataTypeSize(m_time2DType);
+    size_t i = 0;
+    while (i < count) {
+        const size_t toBlockEnd = m_blockSize > 0 ? m_blockSize - m_bIndex : 1;
+        const auto n = std::min(count - i, toBlockEnd);
+        if (buffer.size() < n * entrySize)
+            buffer.resize(n * entrySize);
+
+        auto dest = buffer.data();
+        for (size_t j = i; j < i + n; j++) {
+            appendRawValue(dest, m_time1DType, entries[j].time1);
+            appendRawValue(dest, m_time2DType, entries[j].time2);
+        }
+
+        // the checksum is calculated over the values in host byte order, which is little-endian
+        // on all platforms we support, so we can just hash the data as it is written to disk
+        XXH3_64bits_update(m_xxh3State, buffer.data(), n * entrySize);
+        if (m_file->write(reinterpret_cast<const char *>(buffer.data()), n * entrySize) < 0)
+            qCWarning(logTSyncFile).noquote() << "Unable to write time data:" << m_file->errorString();
+
+        m_bIndex += n;
+        if (m_bIndex >= m_blockSize)
+            writeBlockTerminator();
+        i += n;
+    }
+}
+
+void TimeSyncFileWriter::appendDeltaEntry(quint64 time1, quint64 time2)
+{
+    m_deltaEntries.push_back(RawEntry{time1, time2});
+    m_bIndex++;
+    if (m_bIndex >= m_blockSize)
+        writeBlockTerminator();
+}
+
+void TimeSyncFileWriter::writeDeltaBlockData()
+{
+    // a varint never needs more than 10 bytes
+    const auto maxSize = DELTA_BLOCK_HEADER_SIZE + m_deltaEntries.size() * 2 * 10 + 8;
+    if (m_deltaBuffer.size() < maxSize)
+        m_deltaBuffer.resize(maxSize);
+
+    auto dest = m_deltaBuffer.data() + DELTA_BLOCK_HEADER_SIZE;
+    qint64 prev[2] = {0, 0};
+    qint64 prevDelta[2] = {0, 0};
+    for (size_t i = 0; i < m_deltaEntries.size(); i++) {
+        const qint64 values[2] = {
+            static_cast<qint64>(m_deltaEntries[i].time1), static_cast<qint64>(m_deltaEntries[i].time2)};
+        for (int c = 0; c < 2; c++) {
+            if (i == 0) {
+                appendVarint(dest, values[c]);
+            } else {
+                const auto delta = static_cast<qint64>(static_cast<quint64>(values[c]) - static_cast<quint64>(prev[c]));
+                appendVarint(dest, static_cast<qint64>(static_cast<quint64>(delta) - static_cast<quint64>(prevDelta[c])));
+                prevDelta[c] = delta;
+            }
+            prev[c] = values[c];
+        }
+    }
+
+    // pad the block to keep 8-byte alignment
+    while ((dest - m_deltaBuffer.data()) % 8 != 0)
+        *dest++ = 0;
+
+    const size_t blockBytes = dest - m_deltaBuffer.data();
+    qToLittleEndian<quint32>(m_deltaEntries.size(), m_deltaBuffer.data());
+    qToLittleEndian<quint32>(blockBytes - DELTA_BLOCK_HEADER_SIZE, m_deltaBuffer.data() + sizeof(quint32));
+
+    XXH3_64bits_update(m_xxh3State, m_deltaBuffer.data(), blockBytes);
+    if (m_file->write(reinterpret_cast<const char *>(m_deltaBuffer.data()), blockBytes) < 0)
+        qCWarning(logTSyncFile).noquote() << "Unable to write time data:" << m_file->errorString();
+
+    m_deltaEntries.clear();
+}
+
+namespace
+{
+
+class FunctionRunnable : public QRunnable
+{
+public:
+    explicit FunctionRunnable(std::function<void()> func)
+        : m_func(std::move(func))
+    {
+    }
+
+    void run() override
+    {
+        m_func();
+    }
+
+private:
+    std::function<void()> m_func;
+};
+
+} // namespace
+
 TimeSyncFileReader::TimeSyncFileReader()
-    : m_lastError(QString())
+    : m_lastError(QString()),
+      m_verifyChecksums(true),
+      m_creationTime(0),
+      m_tsMode(TSyncFileMode::CONTINUOUS),
+      m_blockSize(0),
+      m_encoding(TSyncFileEncoding::RAW),
+      m_mapData(nullptr),
+      m_time1Size(0),
+      m_time2Size(0),
+      m_entryCount(0),
+      m_cachedBlockIdx(std::numeric_limits<size_t>::max())
+{
+}
+
+TimeSyncFileReader::~TimeSyncFileReader()
 {
+    close();
+}
+
+static inline long long readMappedValue(const uchar *data, TSyncFileDataType dtype)
+{
+    switch (dtype) {
+    case TSyncFileDataType::INT16:
+        return qFromLittleEndian<qint16>(data);
+    case TSyncFileDataType::INT32:
+        return qFromLittleEndian<qint32>(data);
+    case TSyncFileDataType::INT64:
+        return qFromLittleEndian<qint64>(data);
+    case TSyncFileDataType::UINT16:
+        return qFromLittleEndian<quint16>(data);
+    case TSyncFileDataType::UINT32:
+        return qFromLittleEndian<quint32>(data);
+    case TSyncFileDataType::UINT64:
+        return qFromLittleEndian<quint64>(data);
+    default:
+        return 0;
+    }
 }
 
 template<class T>
@@ -384,7 +1011,8 @@ inline T csReadValue(QDataStream &in, XXH3_state_t *state)
 
     T value;
     in >> value;
-    XXH3_64bits_update(state, (const uint8_t *)&value, sizeof(value));
+    if (state != nullptr)
+        XXH3_64bits_update(state, (const uint8_t *)&value, sizeof(value));
     return value;
 }
 
@@ -397,14 +1025,8 @@ inline QByteArray csReadValue(QDataStream &in, XXH3_state_t *state)
     return value;
 }
 
-bool TimeSyncFileReader::open(const QString &fname)
+bool TimeSyncFileReader::readHeader(QFile &file, QDataStream &in)
 {
-    QFile file(fname);
-    if (!file.open(QIODevice::ReadOnly)) {
-        m_lastError = file.errorString();
-        return false;
-    }
-    QDataStream in(&file);
     in.setVersion(QDataStream::Qt_5_12);
     in.setByteOrder(QDataStream::LittleEndian);
 
@@ -421,7 +1043,8 @@ bool TimeSyncFileReader::open(const QString &fname)
 
     const auto formatVMajor = csReadValue<quint16>(in, csState);
     const auto formatVMinor = csReadValue<quint16>(in, csState);
-    if ((formatVMajor != TSYNC_FILE_VERSION_MAJOR) || (formatVMinor < TSYNC_FILE_VERSION_MINOR)) {
+    if ((formatVMajor != TSYNC_FILE_VERSION_MAJOR) || (formatVMinor < TSYNC_FILE_VERSION_MINOR_RAW)
+        || (formatVMinor > TSYNC_FILE_VERSION_MINOR)) {
         m_lastError = QStringLiteral(
                           "Unable to read data: This file is using an incompatible (probably newer) version of the "
                           "format which we can not read (%1.%2 vs %3.%4).")
@@ -472,6 +1095,18 @@ bool TimeSyncFileReader::open(const QString &fname)
     const auto timeDType2 = static_cast<TSyncFileDataType>(timeDType2_i);
     m_timeDTypes = qMakePair(timeDType1, timeDType2);
 
+    // data encoding, only present since format version 1.3
+    m_encoding = TSyncFileEncoding::RAW;
+    if (formatVMinor >= 3) {
+        m_encoding = static_cast<TSyncFileEncoding>(csReadValue<quint16>(in, csState));
+        if (m_encoding != TSyncFileEncoding::RAW && m_encoding != TSyncFileEncoding::DELTA) {
+            m_lastError = QStringLiteral("Unable to read data: The file uses an unknown data encoding (%1).")
+                              .arg((int)m_encoding);
+            XXH3_freeState(csState);
+            return false;
+        }
+    }
+
     // skip potential alignment bytes
     const int padding = (file.pos() * -1) & (8 - 1); // files use 8-byte alignment
     for (int i = 0; i < padding; i++)
@@ -494,6 +1129,31 @@ bool TimeSyncFileReader::open(const QString &fname)
         return false;
     }
 
+    XXH3_freeState(csState);
+    return true;
+}
+
+bool TimeSyncFileReader::open(const QString &fname)
+{
+    close();
+
+    QFile file(fname);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_lastError = file.errorString();
+        return false;
+    }
+    QDataStream in(&file);
+    if (!readHeader(file, in))
+        return false;
+    if (m_encoding == TSyncFileEncoding::DELTA)
+        return readDeltaBlocks(file, in);
+
+    const auto timeDType1 = m_timeDTypes.first;
+    const auto timeDType2 = m_timeDTypes.second;
+    quint64 blockTerm;
+    XXH3_state_t *csState = XXH3_createState();
+    XXH3_state_t *dataCsState = m_verifyChecksums ? csState : nullptr;
+
     // read the time data
     m_times.clear();
     int bIndex = 0;
@@ -512,7 +1172,7 @@ bool TimeSyncFileReader::open(const QString &fname)
                 XXH3_freeState(csState);
                 return false;
             }
-            if (expectedCRC != XXH3_64bits_digest(csState))
+            if (m_verifyChecksums && expectedCRC != XXH3_64bits_digest(csState))
                 qCWarning(logTSyncFile).noquote()
                     << "CRC check failed for last tsync data block: Data is likely corrupted.";
             break;
@@ -523,22 +1183,22 @@ bool TimeSyncFileReader::open(const QString &fname)
 
         switch (timeDType1) {
         case TSyncFileDataType::INT16:
-            timeVal1 = csReadValue<qint16>(in, csState);
+            timeVal1 = csReadValue<qint16>(in, dataCsState);
             break;
         case TSyncFileDataType::INT32:
-            timeVal1 = csReadValue<qint32>(in, csState);
+            timeVal1 = csReadValue<qint32>(in, dataCsState);
             break;
         case TSyncFileDataType::INT64:
-            timeVal1 = csReadValue<qint64>(in, csState);
+            timeVal1 = csReadValue<qint64>(in, dataCsState);
             break;
         case TSyncFileDataType::UINT16:
-            timeVal1 = csReadValue<quint16>(in, csState);
+            timeVal1 = csReadValue<quint16>(in, dataCsState);
             break;
         case TSyncFileDataType::UINT32:
-            timeVal1 = csReadValue<quint32>(in, csState);
+            timeVal1 = csReadValue<quint32>(in, dataCsState);
             break;
         case TSyncFileDataType::UINT64:
-            timeVal1 = csReadValue<quint64>(in, csState);
+            timeVal1 = csReadValue<quint64>(in, dataCsState);
             break;
         default:
             qFatal("Tried to read unknown datatype from timesync file for time1: %i", (int)timeDType1);
@@ -547,22 +1207,22 @@ bool TimeSyncFileReader::open(const QString &fname)
 
         switch (timeDType2) {
         case TSyncFileDataType::INT16:
-            timeVal2 = csReadValue<qint16>(in, csState);
+            timeVal2 = csReadValue<qint16>(in, dataCsState);
             break;
         case TSyncFileDataType::INT32:
-            timeVal2 = csReadValue<qint32>(in, csState);
+            timeVal2 = csReadValue<qint32>(in, dataCsState);
             break;
         case TSyncFileDataType::INT64:
-            timeVal2 = csReadValue<qint64>(in, csState);
+            timeVal2 = csReadValue<qint64>(in, dataCsState);
             break;
         case TSyncFileDataType::UINT16:
-            timeVal2 = csReadValue<quint16>(in, csState);
+            timeVal2 = csReadValue<quint16>(in, dataCsState);
             break;
         case TSyncFileDataType::UINT32:
-            timeVal2 = csReadValue<quint32>(in, csState);
+            timeVal2 = csReadValue<quint32>(in, dataCsState);
             break;
         case TSyncFileDataType::UINT64:
-            timeVal2 = csReadValue<quint64>(in, csState);
+            timeVal2 = csReadValue<quint64>(in, dataCsState);
             break;
         default:
             qFatal("Tried to read unknown datatype from timesync file for time2: %i", (int)timeDType2);
@@ -581,7 +1241,7 @@ bool TimeSyncFileReader::open(const QString &fname)
                 XXH3_freeState(csState);
                 return false;
             }
-            if (expectedCRC != XXH3_64bits_digest(csState))
+            if (m_verifyChecksums && expectedCRC != XXH3_64bits_digest(csState))
                 qCWarning(logTSyncFile).noquote() << "CRC check failed for tsync data block: Data is likely corrupted.";
 
             XXH3_64bits_reset(csState);
@@ -593,6 +1253,170 @@ bool TimeSyncFileReader::open(const QString &fname)
     return true;
 }
 
+bool TimeSyncFileReader::readDeltaBlocks(QFile &file, QDataStream &in)
+{
+    const qint64 termSize = 2 * sizeof(quint64);
+    XXH3_state_t *csState = XXH3_createState();
+    QByteArray payload;
+
+    m_times.clear();
+    while (!in.atEnd()) {
+        if (file.size() - file.pos() < (qint64)DELTA_BLOCK_HEADER_SIZE + termSize) {
+            m_lastError = QStringLiteral(
+                "Unable to read all tsync data: File was likely truncated (its last block is not complete).");
+            XXH3_freeState(csState);
+            return false;
+        }
+
+        XXH3_64bits_reset(csState);
+        const auto count = csReadValue<quint32>(in, csState);
+        const auto payloadSize = csReadValue<quint32>(in, csState);
+        if (file.size() - file.pos() < (qint64)payloadSize + termSize) {
+            m_lastError = QStringLiteral(
+                "Unable to read all tsync data: File was likely truncated (its last block is not complete).");
+            XXH3_freeState(csState);
+            return false;
+        }
+
+        payload.resize(payloadSize);
+        in.readRawData(payload.data(), payloadSize);
+        if (m_verifyChecksums)
+            XXH3_64bits_update(csState, payload.constData(), payloadSize);
+
+        quint64 blockTerm;
+        quint64 expectedCRC;
+        in >> blockTerm >> expectedCRC;
+        if (blockTerm != TSYNC_FILE_BLOCK_TERM) {
+            m_lastError = QStringLiteral("Unable to read all tsync data: Block separator was invalid.");
+            XXH3_freeState(csState);
+            return false;
+        }
+        if (m_verifyChecksums && expectedCRC != XXH3_64bits_digest(csState))
+            qCWarning(logTSyncFile).noquote() << "CRC check failed for tsync data block: Data is likely corrupted.";
+
+        const auto firstEntry = m_times.size();
+        m_times.resize(firstEntry + count);
+        if (!decodeDeltaBlock(
+                reinterpret_cast<const uchar *>(payload.constData()), payloadSize, count, m_times.data() + firstEntry)) {
+            m_lastError = QStringLiteral("Unable to read all tsync data: A data block could not be decoded.");
+            XXH3_freeState(csState);
+            return false;
+        }
+    }
+
+    XXH3_freeState(csState);
+    return true;
+}
+
+/**
+ * Load all time values of a file using multiple threads.
+ *
+ * The file is memory-mapped, and its blocks are split into ranges which are
+ * verified and decoded in parallel. The result is the same as with open(), but
+ * large files, especially ones on network storage, are read a lot faster.
+ * @param threadCount Maximum number of threads to use, or 0 to use one per CPU core.
+ */
+bool TimeSyncFileReader::openParallel(const QString &fname, int threadCount)
+{
+    if (!openMapped(fname)) {
+        // files without fixed-size blocks can not be split, so we have to read them sequentially
+        if (m_blockSize <= 0)
+            return open(fname);
+        return false;
+    }
+
+    if (threadCount <= 0)
+        threadCount = QThread::idealThreadCount();
+
+    const auto blockCount = m_blocks.size();
+    std::vector<std::pair<long long, long long>> times(m_entryCount);
+    std::atomic_bool decodeFailed(false);
+    const auto decodeRange = [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            if (!decodeBlock(i, times.data() + m_blocks[i].firstEntry, m_verifyChecksums)) {
+                decodeFailed = true;
+                return;
+            }
+        }
+    };
+
+    // all blocks have the same size, so we simply give every thread an equal share,
+    // but with a minimum amount of work so small files are not split up needlessly
+    const size_t blocksPerTask = std::max<size_t>(16, (blockCount + threadCount - 1) / threadCount);
+    if (threadCount == 1 || blockCount <= blocksPerTask) {
+        decodeRange(0, blockCount);
+    } else {
+        QThreadPool pool;
+        pool.setMaxThreadCount(std::max(threadCount - 1, 1));
+        for (size_t first = blocksPerTask; first < blockCount; first += blocksPerTask) {
+            const auto last = std::min(first + blocksPerTask, blockCount);
+            pool.start(new FunctionRunnable([&decodeRange, first, last]() {
+                decodeRange(first, last);
+            }));
+        }
+
+        // the calling thread handles the first range
+        decodeRange(0, blocksPerTask);
+        pool.waitForDone();
+    }
+
+    releaseMapping();
+    if (decodeFailed) {
+        m_lastError = QStringLiteral("Unable to read all tsync data: A data block could not be decoded.");
+        return false;
+    }
+
+    m_times = std::move(times);
+    return true;
+}
+
+/**
+ * Decode all entries of a block of the mapped file into @p dest, optionally verifying
+ * its checksum first. Checksum mismatches are only reported, like when reading a file sequentially.
+ * @return False if the block could not be decoded.
+ */
+bool TimeSyncFileReader::decodeBlock(size_t blockIdx, std::pair<long long, long long> *dest, bool verify) const
+{
+    const auto &block = m_blocks[blockIdx];
+    if (verify) {
+        // the header of delta-encoded blocks is part of the checksummed data
+        const auto csStart = m_encoding == TSyncFileEncoding::DELTA ? block.offset - DELTA_BLOCK_HEADER_SIZE
+                                                                    : block.offset;
+        const auto csEnd = block.offset + block.dataSize;
+        const auto expectedCRC = qFromLittleEndian<quint64>(m_mapData + csEnd + sizeof(quint64));
+        if (expectedCRC != XXH3_64bits(m_mapData + csStart, csEnd - csStart))
+            qCWarning(logTSyncFile).noquote() << "CRC check failed for tsync data block: Data is likely corrupted.";
+    }
+
+    if (m_encoding == TSyncFileEncoding::DELTA)
+        return decodeDeltaBlock(m_mapData + block.offset, block.dataSize, block.count, dest);
+
+    const auto entrySize = m_time1Size + m_time2Size;
+    auto data = m_mapData + block.offset;
+    for (int i = 0; i < block.count; i++) {
+        dest[i] = std::make_pair(
+            readMappedValue(data, m_timeDTypes.first), readMappedValue(data + m_time1Size, m_timeDTypes.second));
+        data += entrySize;
+    }
+
+    return true;
+}
+
+bool TimeSyncFileReader::verifyChecksums() const
+{
+    return m_verifyChecksums;
+}
+
+/**
+ * Set whether block checksums are verified when loading a file.
+ * Verification can be skipped for trusted files to speed up reading.
+ * The header checksum is always verified.
+ */
+void TimeSyncFileReader::setVerifyChecksums(bool verify)
+{
+    m_verifyChecksums = verify;
+}
+
 QString TimeSyncFileReader::lastError() const
 {
     return m_lastError;
@@ -643,7 +1467,365 @@ QPair<TSyncFileDataType, TSyncFileDataType> TimeSyncFileReader::timeDTypes() con
     return m_timeDTypes;
 }
 
-std::vector<std::pair<long long, long long>> TimeSyncFileReader::times() const
+TSyncFileEncoding TimeSyncFileReader::encoding() const
+{
+    return m_encoding;
+}
+
+/**
+ * Get all time pairs of a file that was loaded with open().
+ * The returned list is empty if the file was memory-mapped, use
+ * entryCount() and entry() to access the time values in that case.
+ */
+const std::vector<std::pair<long long, long long>> &TimeSyncFileReader::times() const
 {
     return m_times;
 }
+
+/**
+ * Memory-map a tsync file for random access.
+ *
+ * Instead of loading all time values, the file is mapped into memory and only
+ * an index of its data blocks is created, which makes opening even very large files
+ * fast and cheap. Block checksums are not verified in this mode.
+ */
+bool TimeSyncFileReader::openMapped(const QString &fname)
+{
+    close();
+
+    m_mapFile = std::make_unique<QFile>(fname);
+    if (!m_mapFile->open(QIODevice::ReadOnly)) {
+        m_lastError = m_mapFile->errorString();
+        m_mapFile.reset();
+        return false;
+    }
+
+    QDataStream in(m_mapFile.get());
+    if (!readHeader(*m_mapFile, in)) {
+        close();
+        return false;
+    }
+    const auto dataStart = m_mapFile->pos();
+
+    m_time1Size = tsyncDataTypeSize(m_timeDTypes.first);
+    m_time2Size = tsyncDataTypeSize(m_timeDTypes.second);
+    if (m_time1Size == 0 || m_time2Size == 0) {
+        m_lastError = QStringLiteral("Unable to read data: The file contains time values of an unknown data type.");
+        close();
+        return false;
+    }
+    if (m_blockSize <= 0) {
+        m_lastError = QStringLiteral("Unable to map data: The file has an invalid block size (%1).").arg(m_blockSize);
+        close();
+        return false;
+    }
+
+    m_mapData = m_mapFile->map(0, m_mapFile->size());
+    if (m_mapData == nullptr) {
+        m_lastError = QStringLiteral("Unable to map file into memory: %1").arg(m_mapFile->errorString());
+        close();
+        return false;
+    }
+
+    const auto indexBuilt = m_encoding == TSyncFileEncoding::DELTA ? buildDeltaBlockIndex(dataStart)
+                                                                     : buildBlockIndex(dataStart);
+    if (!indexBuilt) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool TimeSyncFileReader::buildBlockIndex(qint64 dataStart)
+{
+    const qint64 fileSize = m_mapFile->size();
+    const qint64 entrySize = m_time1Size + m_time2Size;
+    const qint64 fullBlockBytes = entrySize * m_blockSize;
+    const qint64 termSize = 2 * sizeof(quint64);
+
+    m_blocks.clear();
+    m_entryCount = 0;
+
+    // every block except for the last one contains exactly m_blockSize entries,
+    // followed by a terminator and the block checksum
+    qint64 pos = dataStart;
+    while (pos < fileSize) {
+        const auto remaining = fileSize - pos;
+
+        BlockInfo block;
+        block.offset = pos;
+        block.firstEntry = m_entryCount;
+        if (remaining >= fullBlockBytes + termSize) {
+            if (qFromLittleEndian<quint64>(m_mapData + pos + fullBlockBytes) != TSYNC_FILE_BLOCK_TERM) {
+                m_lastError = QStringLiteral("Unable to read all tsync data: Block separator was invalid.");
+                return false;
+            }
+            block.count = m_blockSize;
+        } else {
+            const auto dataBytes = remaining - termSize;
+            if (dataBytes <= 0 || (dataBytes % entrySize) != 0
+                || qFromLittleEndian<quint64>(m_mapData + fileSize - termSize) != TSYNC_FILE_BLOCK_TERM) {
+                m_lastError = QStringLiteral(
+                    "Unable to read all tsync data: File was likely truncated (its last block is not complete).");
+                return false;
+            }
+            block.count = dataBytes / entrySize;
+        }
+        block.dataSize = block.count * entrySize;
+
+        block.firstTime1 = readMappedValue(m_mapData + pos, m_timeDTypes.first);
+        block.firstTime2 = readMappedValue(m_mapData + pos + m_time1Size, m_timeDTypes.second);
+        m_blocks.push_back(block);
+
+        m_entryCount += block.count;
+        pos += block.count * entrySize + termSize;
+    }
+
+    return true;
+}
+
+bool TimeSyncFileReader::buildDeltaBlockIndex(qint64 dataStart)
+{
+    const qint64 fileSize = m_mapFile->size();
+    const qint64 termSize = 2 * sizeof(quint64);
+
+    m_blocks.clear();
+    m_entryCount = 0;
+
+    qint64 pos = dataStart;
+    while (pos < fileSize) {
+        BlockInfo block;
+        bool valid = fileSize - pos >= (qint64)DELTA_BLOCK_HEADER_SIZE + termSize;
+        qint64 payloadSize = 0;
+        if (valid) {
+            block.count = qFromLittleEndian<quint32>(m_mapData + pos);
+            payloadSize = qFromLittleEndian<quint32>(m_mapData + pos + sizeof(quint32));
+            block.offset = pos + DELTA_BLOCK_HEADER_SIZE;
+            block.dataSize = payloadSize;
+            block.firstEntry = m_entryCount;
+            valid = block.offset + payloadSize + termSize <= fileSize;
+        }
+        if (!valid) {
+            m_lastError = QStringLiteral(
+                "Unable to read all tsync data: File was likely truncated (its last block is not complete).");
+            return false;
+        }
+
+        // only the last block may contain fewer entries, which we rely on for fast lookups
+        if (qFromLittleEndian<quint64>(m_mapData + block.offset + payloadSize) != TSYNC_FILE_BLOCK_TERM
+            || block.count > m_blockSize || (!m_blocks.empty() && m_blocks.back().count != m_blockSize)) {
+            m_lastError = QStringLiteral("Unable to read all tsync data: Block separator was invalid.");
+            return false;
+        }
+
+        std::pair<long long, long long> first(0, 0);
+        if (block.count > 0 && !decodeDeltaBlock(m_mapData + block.offset, payloadSize, 1, &first)) {
+            m_lastError = QStringLiteral("Unable to read all tsync data: A data block could not be decoded.");
+            return false;
+        }
+        block.firstTime1 = first.first;
+        block.firstTime2 = first.second;
+        m_blocks.push_back(block);
+
+        m_entryCount += block.count;
+        pos = block.offset + payloadSize + termSize;
+    }
+
+    return true;
+}
+
+/**
+ * Close the file and release all data, including the memory mapping.
+ */
+void TimeSyncFileReader::close()
+{
+    releaseMapping();
+    m_times.clear();
+    m_times.shrink_to_fit();
+}
+
+void TimeSyncFileReader::releaseMapping()
+{
+    if (m_mapFile) {
+        if (m_mapData != nullptr)
+            m_mapFile->unmap(const_cast<uchar *>(m_mapData));
+        m_mapFile->close();
+        m_mapFile.reset();
+    }
+    m_mapData = nullptr;
+    m_blocks.clear();
+    m_entryCount = 0;
+
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    m_cachedBlockIdx = std::numeric_limits<size_t>::max();
+    m_cachedBlock.clear();
+}
+
+bool TimeSyncFileReader::isMapped() const
+{
+    return m_mapData != nullptr;
+}
+
+size_t TimeSyncFileReader::entryCount() const
+{
+    if (m_mapData != nullptr)
+        return m_entryCount;
+    return m_times.size();
+}
+
+std::pair<long long, long long> TimeSyncFileReader::entry(size_t index) const
+{
+    if (m_mapData == nullptr)
+        return m_times[index];
+
+    // all blocks but the last one are full, so we can find the block directly
+    const auto blockIdx = index / m_blockSize;
+    const auto &block = m_blocks[blockIdx];
+    if (m_encoding == TSyncFileEncoding::DELTA) {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        if (m_cachedBlockIdx != blockIdx) {
+            m_cachedBlock.assign(block.count, std::make_pair(0LL, 0LL));
+            if (!decodeBlock(blockIdx, m_cachedBlock.data(), false))
+                qCWarning(logTSyncFile).noquote() << "Unable to decode tsync data block" << blockIdx
+                                                  << ": Data is likely corrupted.";
+            m_cachedBlockIdx = blockIdx;
+        }
+        return m_cachedBlock[index - block.firstEntry];
+    }
+
+    const auto data = m_mapData + block.offset + (index - block.firstEntry) * (m_time1Size + m_time2Size);
+    return std::make_pair(
+        readMappedValue(data, m_timeDTypes.first), readMappedValue(data + m_time1Size, m_timeDTypes.second));
+}
+
+/**
+ * Find the index of the entry that starts the segment containing the given time
+ * in the selected column, so that the time lies between the entry and its successor.
+ * Times outside of the recorded range map to the first or last segment.
+ */
+size_t TimeSyncFileReader::findSegment(int column, long long time) const
+{
+    const auto count = entryCount();
+    const auto timeAt = [&](size_t index) {
+        const auto e = entry(index);
+        return column == 0 ? e.first : e.second;
+    };
+
+    size_t lo = 0;
+    size_t hi = count;
+    if (m_mapData != nullptr) {
+        // narrow down the search range using the block index
+        auto it = std::upper_bound(m_blocks.begin(), m_blocks.end(), time, [column](long long t, const BlockInfo &b) {
+            return t < (column == 0 ? b.firstTime1 : b.firstTime2);
+        });
+        if (it != m_blocks.begin())
+            lo = std::prev(it)->firstEntry;
+        if (it != m_blocks.end())
+            hi = it->firstEntry + 1;
+    }
+
+    // find the first entry with a time greater than the requested one
+    while (lo < hi) {
+        const auto mid = lo + (hi - lo) / 2;
+        if (timeAt(mid) <= time)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo == 0)
+        return 0;
+    return std::min(lo - 1, count - 2);
+}
+
+void TimeSyncFileReader::mapTimes(int column, const long long *times, double *result, size_t count) const
+{
+    const auto n = entryCount();
+    if (n < 2) {
+        // we can not interpolate, so we return the only value we have (if any)
+        double value = std::numeric_limits<double>::quiet_NaN();
+        if (n == 1)
+            value = column == 0 ? entry(0).second : entry(0).first;
+        std::fill(result, result + count, value);
+        return;
+    }
+
+    size_t segment = std::numeric_limits<size_t>::max();
+    long long x0 = 0, x1 = 0;
+    double y0 = 0, slope = 0;
+    const auto loadSegment = [&](size_t seg) {
+        const auto a = entry(seg);
+        const auto b = entry(seg + 1);
+        segment = seg;
+        x0 = column == 0 ? a.first : a.second;
+        x1 = column == 0 ? b.first : b.second;
+        y0 = column == 0 ? a.second : a.first;
+        const double y1 = column == 0 ? b.second : b.first;
+        slope = (x1 == x0) ? 0 : (y1 - y0) / static_cast<double>(x1 - x0);
+    };
+
+    for (size_t i = 0; i < count; ++i) {
+        const auto t = times[i];
+
+        // timestamp arrays are usually sorted, so we first try the current and the next
+        // segment before searching the whole file
+        if (segment == std::numeric_limits<size_t>::max()) {
+            loadSegment(findSegment(column, t));
+        } else if ((t < x0 && segment > 0) || (t >= x1 && segment + 2 < n)) {
+            if (t >= x1 && segment + 2 < n) {
+                const auto e = entry(segment + 2);
+                if (t < (column == 0 ? e.first : e.second))
+                    loadSegment(segment + 1);
+                else
+                    loadSegment(findSegment(column, t));
+            } else {
+                loadSegment(findSegment(column, t));
+            }
+        }
+
+        result[i] = y0 + static_cast<double>(t - x0) * slope;
+    }
+}
+
+/**
+ * Convert a value of the first time column to the second time column.
+ *
+ * The value is linearly interpolated between the two closest entries,
+ * or extrapolated from the first or last two entries if it is outside of the
+ * recorded range. Both time columns must be monotonically increasing.
+ */
+double TimeSyncFileReader::mapTime1ToTime2(long long time1) const
+{
+    double result;
+    mapTimes(0, &time1, &result, 1);
+    return result;
+}
+
+/**
+ * Convert a value of the second time column to the first time column.
+ * See mapTime1ToTime2() for details.
+ */
+double TimeSyncFileReader::mapTime2ToTime1(long long time2) const
+{
+    double result;
+    mapTimes(1, &time2, &result, 1);
+    return result;
+}
+
+/**
+ * Convert an array of values of the first time column to the second time column.
+ * This is much faster than converting values individually if the values are sorted.
+ */
+void TimeSyncFileReader::mapTime1ToTime2(const long long *times, double *result, size_t count) const
+{
+    mapTimes(0, times, result, count);
+}
+
+/**
+ * Convert an array of values of the second time column to the first time column.
+ */
+void TimeSyncFileReader::mapTime2ToTime1(const long long *times, double *result, size_t count) const
+{
+    mapTimes(1, times, result, count);
+}
@@ -24,6 +24,8 @@
 #include <QLoggingCategory>
 #include <QUuid>
 #include <memory>
+#include <mutex>
+#include <vector>
 #include <xxhash.h>
 
 #include "syclock.h"
@@ -68,9 +70,18 @@ enum class TSyncFileDataType {
     UINT64 = 8
 };
 
+/**
+ * @brief Encoding of the time values in the data blocks of a TSync file.
+ */
+enum class TSyncFileEncoding {
+    RAW = 0,  /// Every time value is stored with the full width of its data type
+    DELTA = 1 /// Blocks store their first time pair, followed by zigzag-varint encoded deltas
+};
+
 QString tsyncFileTimeUnitToString(const TSyncFileTimeUnit &tsftunit);
 QString tsyncFileDataTypeToString(const TSyncFileDataType &dtype);
 QString tsyncFileModeToString(const TSyncFileMode &mode);
+QString tsyncFileEncodingToString(const TSyncFileEncoding &encoding);
 
 /**
  * @brief Write a timestamp synchronization file
@@ -80,6 +91,11 @@ QString tsyncFileModeToString(const TSyncFileMode &mode);
  * format data is stored in does not support timestamp adjustments, or
  * as additional set of datapoints to ensure timestamps are really
  * synchronized.
+ *
+ * By default, all data is written on the thread calling writeTimes().
+ * If asynchronous writing is enabled, time entries are only queued by the caller
+ * and a background thread checksums and writes them block by block, so slow disk
+ * I/O does not stall time-critical threads.
  */
 class TimeSyncFileWriter
 {
@@ -92,6 +108,7 @@ public:
     void setTimeNames(const QString &time1Name, const QString &time2Name);
     void setTimeUnits(TSyncFileTimeUnit time1Unit, TSyncFileTimeUnit time2Unit);
     void setTimeDataTypes(TSyncFileDataType time1DType, TSyncFileDataType time2DType);
+    void setEncoding(TSyncFileEncoding encoding);
 
     QString fileName() const;
     void setFileName(const QString &fname);
@@ -101,6 +118,12 @@ public:
 
     void setCreationTimeOverride(const QDateTime &dt);
 
+    bool asyncWriting() const;
+    void setAsyncWriting(bool enabled);
+
+    void setUserDataReserve(int bytes);
+    bool updateUserData(const QVariantHash &userData);
+
     bool open(const QString &modName, const QUuid &collectionId, const QVariantHash &userData = QVariantHash());
     bool open(
         const QString &modName,
@@ -116,6 +139,12 @@ public:
     void writeTimes(const uint64_t &time1, const uint64_t &time2);
 
 private:
+    class AsyncWriter;
+    struct RawEntry {
+        quint64 time1;
+        quint64 time2;
+    };
+
     QFile *m_file;
     QDataStream m_stream;
     TSyncFileMode m_tsMode;
@@ -125,16 +154,34 @@ private:
     QString m_lastError;
     QDateTime m_creationTimeOverride;
 
+    QString m_modName;
+    QUuid m_collectionId;
+    QDateTime m_creationTime;
+    QVariantHash m_userData;
+    int m_userDataReserve;
+    QByteArray m_userDataJson;
+    bool m_userDataChanged;
+
     QPair<QString, QString> m_timeNames;
     QPair<TSyncFileTimeUnit, TSyncFileTimeUnit> m_timeUnits;
     TSyncFileDataType m_time1DType;
     TSyncFileDataType m_time2DType;
+    TSyncFileEncoding m_encoding;
+    std::vector<RawEntry> m_deltaEntries;
+    std::vector<uchar> m_deltaBuffer;
+
+    bool m_asyncEnabled;
+    std::unique_ptr<AsyncWriter> m_async;
 
+    void writeHeader();
     void writeBlockTerminator(bool check = true);
     template<class T>
     void csWriteValue(const T &data);
     template<class T1, class T2>
     void writeTimeEntry(const T1 &time1, const T2 &time2);
+    void writeRawEntries(const RawEntry *entries, size_t count, std::vector<uchar> &buffer);
+    void appendDeltaEntry(quint64 time1, quint64 time2);
+    void writeDeltaBlockData();
 };
 
 /**
@@ -143,15 +190,29 @@ private:
  * Simple helper class to read the contents of a .tsync file,
  * for adjustments of the source timestamps or simply conversion
  * into a non-binary format.
+ *
+ * Files can either be loaded completely into memory with open() or
+ * openParallel(), or be memory-mapped with openMapped(), which is preferable
+ * for large files where only some time values or conversions between the two
+ * time columns are needed.
+ * Once a file is opened, the const accessors may be called from multiple threads.
  */
 class TimeSyncFileReader
 {
 public:
     explicit TimeSyncFileReader();
+    ~TimeSyncFileReader();
 
     bool open(const QString &fname);
+    bool openParallel(const QString &fname, int threadCount = 0);
+    bool openMapped(const QString &fname);
+    void close();
+    bool isMapped() const;
     QString lastError() const;
 
+    bool verifyChecksums() const;
+    void setVerifyChecksums(bool verify);
+
     QString moduleName() const;
     QUuid collectionId() const;
     time_t creationTime() const;
@@ -163,11 +224,39 @@ public:
     QPair<QString, QString> timeNames() const;
     QPair<TSyncFileTimeUnit, TSyncFileTimeUnit> timeUnits() const;
     QPair<TSyncFileDataType, TSyncFileDataType> timeDTypes() const;
+    TSyncFileEncoding encoding() const;
+
+    const std::vector<std::pair<long long, long long>> &times() const;
 
-    std::vector<std::pair<long long, long long>> times() const;
+    size_t entryCount() const;
+    std::pair<long long, long long> entry(size_t index) const;
+
+    double mapTime1ToTime2(long long time1) const;
+    double mapTime2ToTime1(long long time2) const;
+    void mapTime1ToTime2(const long long *times, double *result, size_t count) const;
+    void mapTime2ToTime1(const long long *times, double *result, size_t count) const;
 
 private:
+    struct BlockInfo {
+        qint64 offset;     /// position of the block's data in the file
+        qint64 dataSize;   /// size of the block's data, excluding terminator and checksum
+        size_t firstEntry; /// index of the block's first entry
+        int count;         /// number of entries in this block
+        long long firstTime1;
+        long long firstTime2;
+    };
+
+    bool readHeader(QFile &file, QDataStream &in);
+    bool readDeltaBlocks(QFile &file, QDataStream &in);
+    bool buildBlockIndex(qint64 dataStart);
+    bool buildDeltaBlockIndex(qint64 dataStart);
+    bool decodeBlock(size_t blockIdx, std::pair<long long, long long> *dest, bool verify) const;
+    void releaseMapping();
+    size_t findSegment(int column, long long time) const;
+    void mapTimes(int column, const long long *times, double *result, size_t count) const;
+
     QString m_lastError;
+    bool m_verifyChecksums;
     QString m_moduleName;
     qint64 m_creationTime;
     QUuid m_collectionId;
@@ -181,6 +270,21 @@ private:
     QPair<QString, QString> m_timeNames;
     QPair<TSyncFileTimeUnit, TSyncFileTimeUnit> m_timeUnits;
     QPair<TSyncFileDataType, TSyncFileDataType> m_timeDTypes;
+    TSyncFileEncoding m_encoding;
+
+    // memory-mapped mode
+    std::unique_ptr<QFile> m_mapFile;
+    const uchar *m_mapData;
+    int m_time1Size;
+    int m_time2Size;
+    size_t m_entryCount;
+    std::vector<BlockInfo> m_blocks;
+
+    // last decoded block of a memory-mapped, delta-encoded file, guarded by m_cacheMutex
+    // so that the const lookup functions remain safe to call from multiple threads
+    mutable std::mutex m_cacheMutex;
+    mutable size_t m_cachedBlockIdx;
+    mutable std::vector<std::pair<long long, long long>> m_cachedBlock;
 };
 
 } // namespace Syntalos
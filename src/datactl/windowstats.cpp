@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2019-2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "windowstats.h"
+
+#include <cassert>
+#include <utility>
+
+using namespace Syntalos;
+
+SlidingWindowStats::SlidingWindowStats(size_t windowSize, int64_t initialValue)
+{
+    reset(windowSize, initialValue);
+}
+
+void SlidingWindowStats::reset(size_t windowSize, int64_t initialValue)
+{
+    assert(windowSize > 0);
+    m_size = windowSize;
+    m_next = 0;
+    m_values.assign(m_size, initialValue);
+    m_slotHalf.resize(m_size);
+    m_slotPos.resize(m_size);
+
+    // all values are equal, so any split into two halves forms valid heaps
+    const auto lowerCount = (m_size + 1) / 2;
+    m_heaps[LOWER].resize(lowerCount);
+    m_heaps[UPPER].resize(m_size - lowerCount);
+    for (size_t slot = 0; slot < m_size; slot++) {
+        if (slot < lowerCount)
+            heapSet(LOWER, slot, slot);
+        else
+            heapSet(UPPER, slot - lowerCount, slot);
+    }
+
+    m_sum = static_cast<__int128>(initialValue) * m_size;
+    m_sumSq = static_cast<__int128>(initialValue) * initialValue * m_size;
+}
+
+/**
+ * Replace the oldest value in the window with @p value.
+ */
+void SlidingWindowStats::push(int64_t value)
+{
+    const auto slot = m_next;
+    m_next = (m_next + 1) % m_size;
+
+    const auto oldValue = m_values[slot];
+    m_values[slot] = value;
+    m_sum += static_cast<__int128>(value) - oldValue;
+    m_sumSq += static_cast<__int128>(value) * value - static_cast<__int128>(oldValue) * oldValue;
+
+    const auto half = m_slotHalf[slot];
+    siftUp(half, m_slotPos[slot]);
+    siftDown(half, m_slotPos[slot]);
+
+    // if the new value crossed the median, the roots of both heaps are out of order,
+    // and exchanging them restores the ordering of the two halves
+    if (m_heaps[UPPER].empty())
+        return;
+    const auto lowerRoot = m_heaps[LOWER][0];
+    const auto upperRoot = m_heaps[UPPER][0];
+    if (m_values[lowerRoot] > m_values[upperRoot]) {
+        heapSet(LOWER, 0, upperRoot);
+        heapSet(UPPER, 0, lowerRoot);
+        siftDown(LOWER, 0);
+        siftDown(UPPER, 0);
+    }
+}
+
+size_t SlidingWindowStats::size() const
+{
+    return m_size;
+}
+
+int64_t SlidingWindowStats::sum() const
+{
+    return static_cast<int64_t>(m_sum);
+}
+
+/**
+ * Mean of the window, rounded towards zero like the mean of an integer Eigen vector.
+ */
+int64_t SlidingWindowStats::mean() const
+{
+    return static_cast<int64_t>(m_sum / static_cast<__int128>(m_size));
+}
+
+double SlidingWindowStats::variance(bool unbiased) const
+{
+    return variance(static_cast<double>(mean()), unbiased);
+}
+
+double SlidingWindowStats::variance(double mean, bool unbiased) const
+{
+    // calculate the sum of squared deviations relative to the integer part of the mean exactly,
+    // so we do not suffer from cancellation even for large values with a small spread
+    const auto meanInt = static_cast<int64_t>(mean);
+    const auto meanFrac = mean - static_cast<double>(meanInt);
+    const auto n = static_cast<__int128>(m_size);
+    const auto devSum = m_sum - n * meanInt;
+    const auto devSumSq = m_sumSq - 2 * static_cast<__int128>(meanInt) * m_sum + n * meanInt * meanInt;
+
+    const auto sqSum = static_cast<double>(devSumSq) - 2 * meanFrac * static_cast<double>(devSum)
+                       + static_cast<double>(m_size) * meanFrac * meanFrac;
+    return sqSum / (unbiased ? m_size - 1.0 : static_cast<double>(m_size));
+}
+
+double SlidingWindowStats::median() const
+{
+    const auto lowerMax = m_values[m_heaps[LOWER][0]];
+    if (m_heaps[LOWER].size() > m_heaps[UPPER].size())
+        return lowerMax;
+    return ((long long)lowerMax + (long long)m_values[m_heaps[UPPER][0]]) / 2.0;
+}
+
+bool SlidingWindowStats::before(Half half, size_t slotA, size_t slotB) const
+{
+    return half == LOWER ? m_values[slotA] > m_values[slotB] : m_values[slotA] < m_values[slotB];
+}
+
+void SlidingWindowStats::heapSet(Half half, size_t pos, size_t slot)
+{
+    m_heaps[half][pos] = slot;
+    m_slotHalf[slot] = half;
+    m_slotPos[slot] = pos;
+}
+
+void SlidingWindowStats::siftUp(Half half, size_t pos)
+{
+    auto &heap = m_heaps[half];
+    const auto slot = heap[pos];
+    while (pos > 0) {
+        const auto parent = (pos - 1) / 2;
+        if (!before(half, slot, heap[parent]))
+            break;
+        heapSet(half, pos, heap[parent]);
+        pos = parent;
+    }
+    heapSet(half, pos, slot);
+}
+
+void SlidingWindowStats::siftDown(Half half, size_t pos)
+{
+    auto &heap = m_heaps[half];
+    const auto count = heap.size();
+    const auto slot = heap[pos];
+    while (true) {
+        auto child = 2 * pos + 1;
+        if (child >= count)
+            break;
+        if (child + 1 < count && before(half, heap[child + 1], heap[child]))
+            child++;
+        if (!before(half, heap[child], slot))
+            break;
+        heapSet(half, pos, heap[child]);
+        pos = child;
+    }
+    heapSet(half, pos, slot);
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2019-2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Syntalos
+{
+
+/**
+ * @brief Incrementally updated statistics of a sliding window of integer values
+ *
+ * The window always contains a fixed number of values, which are all set to an
+ * initial value on reset. Every new value replaces the oldest one in the window.
+ *
+ * Mean and variance are calculated from exact running sums, and the median is kept
+ * up to date in two indexed heaps holding the lower and upper half of the window,
+ * so adding a value costs O(log n) and querying any statistic is O(1).
+ * No memory is allocated except when the window is reset.
+ *
+ * The results are identical to computing the mean, vectorVariance() and
+ * vectorMedian() of a vector holding the window values.
+ */
+class SlidingWindowStats
+{
+public:
+    explicit SlidingWindowStats(size_t windowSize = 1, int64_t initialValue = 0);
+
+    void reset(size_t windowSize, int64_t initialValue = 0);
+    void push(int64_t value);
+
+    size_t size() const;
+    int64_t sum() const;
+    int64_t mean() const;
+    double variance(bool unbiased = true) const;
+    double variance(double mean, bool unbiased = true) const;
+    double median() const;
+
+private:
+    enum Half : uint8_t {
+        LOWER, /// max-heap of the lower half, contains the extra value for odd window sizes
+        UPPER  /// min-heap of the upper half
+    };
+
+    bool before(Half half, size_t slotA, size_t slotB) const;
+    void heapSet(Half half, size_t pos, size_t slot);
+    void siftUp(Half half, size_t pos);
+    void siftDown(Half half, size_t pos);
+
+    size_t m_size;
+    size_t m_next;
+    std::vector<int64_t> m_values;
+
+    // heaps store slot indices, and every slot knows its heap and position within it
+    std::vector<size_t> m_heaps[2];
+    std::vector<Half> m_slotHalf;
+    std::vector<size_t> m_slotPos;
+
+    __int128 m_sum;
+    __int128 m_sumSq;
+};
+
+} // namespace Syntalos
@@ -43,16 +43,20 @@
 #include <iceoryx_posh/runtime/posh_runtime.hpp>
 #include <iceoryx_hoofs/error_handling/error_handling.hpp>
 
+#include "affinityplanner.h"
 #include "cpuaffinity.h"
 #include "globalconfig.h"
 #include "meminfo.h"
+#include "moduleeventscheduler.h"
 #include "moduleeventthread.h"
 #include "modulelibrary.h"
 #include "mlinkmodule.h"
 #include "rtkit.h"
 #include "sysinfo.h"
+#include "tracing.h"
 #include "datactl/syclock.h"
 #include "datactl/edlstorage.h"
+#include "datactl/frametype.h"
 #include "utils/misc.h"
 #include "utils/tomlutils.h"
 
@@ -67,6 +71,12 @@ static_assert(
 
 using namespace Syntalos;
 
+/**
+ * Percentage of available system memory below which a run is stopped
+ * in an emergency, if memory continues to shrink.
+ */
+static constexpr double EMERGENCY_STOP_MEM_PERCENT = 1.6;
+
 static int engineUsbHotplugDispatchCB(
     struct libusb_context *ctx,
     struct libusb_device *dev,
@@ -208,7 +218,11 @@ private:
                     << "Module thread for '" << self->m_mod->name() << "' set to realtime mode.";
         }
 
-        self->m_mod->runThread(self->m_waitCond);
+        {
+            // this span covers the whole lifetime of the thread, modules trace their loop iterations themselves
+            SY_TRACE_SCOPE(Tracing::isEnabled() ? Tracing::internName(self->m_mod->name()) : nullptr);
+            self->m_mod->runThread(self->m_waitCond);
+        }
 
         if (self->m_threadBackend != BackendQThread)
             pthread_exit(nullptr);
@@ -226,20 +240,29 @@ public:
         VariantStreamSubscription *sub;
         VarStreamInputPort *port;
         ConnectionHeatLevel heat;
+        size_t droppedCount;
+        size_t lastPendingBytes;
+        double growthBytesPerSec;
+        uint growthStreak;
     };
 
     std::vector<SubscriptionBufferWatchData> monitoredSubscriptions;
+    QList<AbstractModule *> activeModules;
     QString exportDirPath;
 
     bool diskSpaceWarningEmitted;
     bool memoryWarningEmitted;
     bool subBufferWarningEmitted;
+    ConnectionHeatLevel subBufferWarningLevel;
+    int subBufferWarningEtaBucket;
+    symaster_timepoint lastBufferCheckTime;
     double prevMemAvailablePercent;
     bool emergencyOOMStop;
 
     QTimer diskSpaceCheckTimer;
     QTimer memCheckTimer;
     QTimer subBufferCheckTimer;
+    QTimer syncTelemetryTimer;
 };
 
 class Engine::Private
@@ -288,6 +311,7 @@ public:
     bool saveInternal;
     std::shared_ptr<EDLGroup> edlInternalData;
     QHash<QString, std::shared_ptr<TimeSyncFileWriter>> internalTSyncWriters;
+    TraceCollector traceCollector;
 
     QScopedPointer<EngineResourceMonitorData> monitoring;
     int runCount;
@@ -330,6 +354,9 @@ Engine::Engine(QWidget *parentWidget)
     // try to register simultaneously
     qRegisterMetaType<TimeSyncStrategies>();
 
+    // for connection heat details passed to the UI
+    qRegisterMetaType<ConnectionHeatInfo>();
+
     // register dispatch callback for USB hotplug events
     d->usbEventsTimer = new QTimer;
     d->usbEventsTimer->setInterval(10);
@@ -1231,6 +1258,24 @@ bool Engine::runEphemeral()
     return ret;
 }
 
+/**
+ * Estimate how much data a stream of the given type transfers, relative to other streams.
+ * Modules connected by heavy streams are placed on CPU cores sharing a cache.
+ */
+static double streamBandwidthWeight(int dataTypeId)
+{
+    switch (dataTypeId) {
+    case BaseDataType::Frame:
+        return 10;
+    case BaseDataType::IntSignalBlock:
+    case BaseDataType::FloatSignalBlock:
+    case BaseDataType::Float32SignalBlock:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
 QHash<AbstractModule *, std::vector<uint>> Engine::setupCoreAffinityConfig(
     const QList<AbstractModule *> &threadedModules)
 {
@@ -1238,55 +1283,46 @@ QHash<AbstractModule *, std::vector<uint>> Engine::setupCoreAffinityConfig(
     QHash<AbstractModule *, std::vector<uint>> modCPUMap;
     d->mainThreadCoreAffinity.clear();
 
-    auto availableCores = get_online_cores_count() - 1; // all cores minus the one our main thread is running on
+    const auto explicitAffinities = d->gconf->explicitCoreAffinities();
+    CoreAffinityPlanner planner(CpuTopology::fromSysfs());
+    planner.setPinMainThread(explicitAffinities);
 
-    // give modules which explicitly want to be tied to a CPU core their CPU affinity
-    // setting, independent of whether the "explicitCoreAffinities" use setting is set
+    // modules which explicitly want to be tied to a CPU core get their CPU affinity setting,
+    // independent of whether the "explicitCoreAffinities" use setting is set.
+    // If the user wants explicit affinities, all other modules get a core too, unless they
+    // explicitly don't want that and override the user's selection
+    QList<AbstractModule *> plannedModules;
     for (auto &mod : threadedModules) {
-        if (!mod->features().testFlag(ModuleFeature::REQUEST_CPU_AFFINITY))
+        const auto requested = mod->features().testFlag(ModuleFeature::REQUEST_CPU_AFFINITY);
+        if (!requested
+            && (!explicitAffinities || mod->features().testFlag(ModuleFeature::PROHIBIT_CPU_AFFINITY)))
             continue;
-        if (availableCores > 0) {
-            modCPUMap[mod] = std::vector<uint>{(uint)availableCores};
-            availableCores--;
-        } else
-            break;
+        planner.addThread(mod->name(), mod->features().testFlag(ModuleFeature::REALTIME), requested);
+        plannedModules.append(mod);
     }
 
-    // we are done here if the "explicit core affinities" setting wasn't set by the user
-    if (!d->gconf->explicitCoreAffinities())
-        return modCPUMap;
-
-    // tie main thread to first CPU by default
-    d->mainThreadCoreAffinity.push_back(0);
-
-    // we try to give each thread to a dedicated core, to (ideally) prevent
-    // the scheduler from moving them around between CPUs too much once they go idle
-
-    // all modules which explicitly requested an own core already got one, so
-    // now give a CPU core to all other modules, unless they explicitly don't
-    // want that and override the user's selection
-    for (auto &mod : threadedModules) {
-        if (mod->features().testFlag(ModuleFeature::PROHIBIT_CPU_AFFINITY))
-            continue;
-        if (availableCores > 0) {
-            modCPUMap[mod] = std::vector<uint>{(uint)availableCores};
-            availableCores--;
-        } else
-            break;
+    // tell the planner which modules exchange a lot of data
+    for (int i = 0; i < plannedModules.size(); i++) {
+        for (const auto &iport : plannedModules[i]->inPorts()) {
+            if (!iport->hasSubscription())
+                continue;
+            const auto producerIdx = plannedModules.indexOf(iport->outPort()->owner());
+            if (producerIdx < 0)
+                continue;
+            planner.addLink(producerIdx, i, streamBandwidthWeight(iport->outPort()->dataTypeId()));
+        }
     }
 
-    // give the remaining cores to other modules
-    std::vector<uint> remainingCores;
-    for (uint i = availableCores; i > 0; i--)
-        remainingCores.push_back(i);
-
-    if (!remainingCores.empty()) {
-        // give remaining cores to main thread
-        // NOTE: A lot of threads & tasks will still fork off the main thread,
-        // so this is well-invested
-        remainingCores.push_back(0);
-        d->mainThreadCoreAffinity = remainingCores;
+    const auto plan = planner.plan();
+    for (int i = 0; i < plannedModules.size(); i++) {
+        if (!plan.threadCpus[i].empty())
+            modCPUMap[plannedModules[i]] = plan.threadCpus[i];
     }
+    d->mainThreadCoreAffinity = plan.mainThreadCpus;
+
+    // keep the plan with the run's diagnostic data, to make placement issues traceable
+    if (d->saveInternal && d->edlInternalData)
+        d->edlInternalData->insertAttribute(QStringLiteral("core_affinity_plan"), plan.description);
 
     return modCPUMap;
 }
@@ -1324,8 +1360,8 @@ void Engine::onMemoryMonitorEvent()
 {
     const auto memInfo = read_meminfo();
 
-    if (memInfo.memAvailablePercent < d->monitoring->prevMemAvailablePercent && memInfo.memAvailablePercent < 1.6
-        && d->monitoring->emergencyOOMStop) {
+    if (memInfo.memAvailablePercent < d->monitoring->prevMemAvailablePercent
+        && memInfo.memAvailablePercent < EMERGENCY_STOP_MEM_PERCENT && d->monitoring->emergencyOOMStop) {
         qCInfo(logEngine).noquote()
             << "Less than 2% of system memory available and shrinking, commencing emergency stop.";
         receiveModuleError(QStringLiteral(
@@ -1357,57 +1393,138 @@ void Engine::onMemoryMonitorEvent()
     d->monitoring->prevMemAvailablePercent = memInfo.memAvailablePercent;
 }
 
+static QString formatDurationSec(double seconds)
+{
+    if (seconds < 90)
+        return QStringLiteral("%1 sec").arg(qRound(seconds));
+    if (seconds < 90 * 60)
+        return QStringLiteral("%1 min").arg(qRound(seconds / 60));
+    return QStringLiteral("%1 h").arg(seconds / 3600, 0, 'f', 1);
+}
+
+/**
+ * Coarse class of a memory exhaustion estimate, so that warnings are only updated
+ * if the estimate changed significantly. Returns -1 if no estimate is available.
+ */
+static int memoryExhaustionBucket(double seconds)
+{
+    if (seconds < 0)
+        return -1;
+    static const double bucketLimitsSec[] = {60, 2 * 60, 5 * 60, 10 * 60, 30 * 60, 60 * 60, 3 * 60 * 60};
+    int bucket = 0;
+    for (const auto limit : bucketLimitsSec) {
+        if (seconds < limit)
+            break;
+        bucket++;
+    }
+    return bucket;
+}
+
 void Engine::onBufferMonitorEvent()
 {
-    bool issueFound = false;
+    auto maxHeatLevel = ConnectionHeatLevel::NONE;
     bool subBufferWarningEmitted = d->monitoring->subBufferWarningEmitted;
 
+    const auto timeNow = currentTimePoint();
+    const double elapsedSec = timeDiffUsec(timeNow, d->monitoring->lastBufferCheckTime).count() / 1000.0 / 1000.0;
+    d->monitoring->lastBufferCheckTime = timeNow;
+
+    // memory that buffers can still fill up before we would have to stop the run in an emergency
+    const auto memInfo = read_meminfo();
+    const double memHeadroomBytes = std::max(
+        (memInfo.memAvailableMiB * 1024.0 * 1024.0)
+            - (memInfo.memTotalKiB * 1024.0 * EMERGENCY_STOP_MEM_PERCENT / 100.0),
+        0.0);
+    double totalGrowthBytesPerSec = 0;
+
     for (auto &msd : d->monitoring->monitoredSubscriptions) {
-        const auto approxPendingCount = msd.sub->approxPendingCount();
+        ConnectionHeatInfo info;
+        info.pendingCount = msd.sub->approxPendingCount();
+        info.pendingBytes = msd.sub->approxPendingBytes();
+        const auto queueCapacity = msd.sub->queueCapacity();
+
+        // bounded subscriptions may drop data instead of growing their buffer,
+        // which always is a sign of a hot connection
+        const auto droppedCount = msd.sub->droppedElementCount();
+        const bool dataDropped = droppedCount > msd.droppedCount;
+        msd.droppedCount = droppedCount;
+
+        // smooth the growth rate, so a single burst of data does not make a connection look hot
+        if (elapsedSec > 0) {
+            const double rate = (static_cast<double>(info.pendingBytes) - static_cast<double>(msd.lastPendingBytes))
+                                / elapsedSec;
+            msd.growthBytesPerSec = (msd.growthBytesPerSec + rate) / 2.0;
+        }
+        msd.growthStreak = info.pendingBytes > msd.lastPendingBytes ? msd.growthStreak + 1 : 0;
+        msd.lastPendingBytes = info.pendingBytes;
+        info.growthBytesPerSec = msd.growthBytesPerSec;
+
+        // only buffers that have grown steadily for a few checks are expected to keep growing
+        if (msd.growthStreak >= 3 && msd.growthBytesPerSec > 0) {
+            info.memoryExhaustedSec = memHeadroomBytes / msd.growthBytesPerSec;
+            totalGrowthBytesPerSec += msd.growthBytesPerSec;
+        }
+        const bool growing = info.memoryExhaustedSec >= 0;
+
+        // bounded queues are judged by their fill level
+        double fillRatio = 0;
+        if (queueCapacity > 0)
+            fillRatio = info.pendingCount / static_cast<double>(queueCapacity);
+
+        // share of the remaining memory that is occupied by this buffer
+        const double memShare = info.pendingBytes / std::max(memHeadroomBytes + info.pendingBytes, 1.0);
+
+        // determine connection "heat" level
+        if (dataDropped || fillRatio >= 0.9 || memShare >= 0.25 || (growing && info.memoryExhaustedSec < 2 * 60))
+            info.level = ConnectionHeatLevel::HIGH;
+        else if (fillRatio >= 0.75 || memShare >= 0.10 || (growing && info.memoryExhaustedSec < 10 * 60))
+            info.level = ConnectionHeatLevel::MEDIUM;
+        else if (fillRatio >= 0.5 || info.pendingBytes >= 64 * 1024 * 1024
+                 || (growing && info.memoryExhaustedSec < 30 * 60))
+            info.level = ConnectionHeatLevel::LOW;
+        else
+            info.level = ConnectionHeatLevel::NONE;
 
-        // less than 100 pending items is arbitrarily considered "okay"
-        if (approxPendingCount < 100) {
-            if (msd.heat != ConnectionHeatLevel::NONE) {
-                Q_EMIT connectionHeatChangedAtPort(msd.port, ConnectionHeatLevel::NONE);
-                msd.heat = ConnectionHeatLevel::NONE;
+        if (info.level != msd.heat) {
+            msd.heat = info.level;
+            Q_EMIT connectionHeatChangedAtPort(msd.port, info);
+            if (info.level == ConnectionHeatLevel::NONE)
                 qCDebug(logEngine).noquote()
                     << "Connection heat removed from"
                     << QString("%1:%2[<%3]")
                            .arg(msd.port->owner()->name(), msd.port->title(), msd.port->dataTypeName());
-            }
-            continue;
-        }
-
-        // determine connection "heat" level
-        ConnectionHeatLevel heat;
-        if (approxPendingCount > 300)
-            heat = ConnectionHeatLevel::HIGH;
-        else if (approxPendingCount > 200)
-            heat = ConnectionHeatLevel::MEDIUM;
-        else
-            heat = ConnectionHeatLevel::LOW;
-        if (heat != msd.heat) {
-            msd.heat = heat;
-            Q_EMIT connectionHeatChangedAtPort(msd.port, msd.heat);
-            qCDebug(logEngine).noquote().nospace()
-                << "Connection heat changed to \"" << connectionHeatToHumanString(msd.heat) << "\" for "
-                << QString("%1:%2[<%3]").arg(msd.port->owner()->name(), msd.port->title(), msd.port->dataTypeName())
-                << " (level: " << approxPendingCount << ")";
+            else
+                qCDebug(logEngine).noquote().nospace()
+                    << "Connection heat changed to \"" << connectionHeatToHumanString(msd.heat) << "\" for "
+                    << QString("%1:%2[<%3]")
+                           .arg(msd.port->owner()->name(), msd.port->title(), msd.port->dataTypeName())
+                    << " (pending: " << info.pendingCount << ", " << info.pendingBytes / 1024 << " KiB, growth: "
+                    << qRound64(info.growthBytesPerSec / 1024) << " KiB/s)";
+        } else if (info.level != ConnectionHeatLevel::NONE) {
+            // keep the displayed buffer details of hot connections current
+            Q_EMIT connectionHeatChangedAtPort(msd.port, info);
         }
 
-        if (heat > ConnectionHeatLevel::LOW) {
-            issueFound = true;
-            if (!subBufferWarningEmitted) {
-                Q_EMIT resourceWarningUpdate(
-                    StreamBuffers,
-                    false,
-                    QStringLiteral("A module is overwhelmed with its input and not fast enough."));
-                subBufferWarningEmitted = true;
-            }
-        }
+        maxHeatLevel = std::max(maxHeatLevel, info.level);
     }
 
-    if (!issueFound && subBufferWarningEmitted) {
+    if (maxHeatLevel > ConnectionHeatLevel::LOW) {
+        const double exhaustedSec = totalGrowthBytesPerSec > 0 ? memHeadroomBytes / totalGrowthBytesPerSec : -1;
+        const auto etaBucket = memoryExhaustionBucket(exhaustedSec);
+
+        // only update the warning if it changed meaningfully, to not replace other warnings all the time
+        if (!subBufferWarningEmitted || maxHeatLevel != d->monitoring->subBufferWarningLevel
+            || etaBucket != d->monitoring->subBufferWarningEtaBucket) {
+            QString message = QStringLiteral("A module is overwhelmed with its input and not fast enough.");
+            if (exhaustedSec >= 0)
+                message += QStringLiteral(" Memory will run out in about %1 at the current rate.")
+                               .arg(formatDurationSec(exhaustedSec));
+            Q_EMIT resourceWarningUpdate(StreamBuffers, false, message);
+            d->monitoring->subBufferWarningLevel = maxHeatLevel;
+            d->monitoring->subBufferWarningEtaBucket = etaBucket;
+            subBufferWarningEmitted = true;
+        }
+    } else if (subBufferWarningEmitted) {
         Q_EMIT resourceWarningUpdate(
             StreamBuffers, true, QStringLiteral("All modules appear to be running fast enough."));
         subBufferWarningEmitted = false;
@@ -1441,21 +1558,42 @@ void Engine::startResourceMonitoring(QList<AbstractModule *> activeModules, cons
             data.sub = port->subscriptionVar().get();
             data.port = port.get();
             data.heat = ConnectionHeatLevel::NONE;
+            data.droppedCount = 0;
+            data.lastPendingBytes = 0;
+            data.growthBytesPerSec = 0;
+            data.growthStreak = 0;
             d->monitoring->monitoredSubscriptions.push_back(data);
 
             // reset all connection heat levels
-            Q_EMIT connectionHeatChangedAtPort(port.get(), ConnectionHeatLevel::NONE);
+            Q_EMIT connectionHeatChangedAtPort(port.get(), ConnectionHeatInfo());
         }
     }
 
+    // buffers are checked frequently, so we can estimate how quickly they grow
     d->monitoring->subBufferWarningEmitted = false;
-    d->monitoring->subBufferCheckTimer.setInterval(10 * 1000); // check every 10sec
+    d->monitoring->subBufferWarningLevel = ConnectionHeatLevel::NONE;
+    d->monitoring->subBufferWarningEtaBucket = -1;
+    d->monitoring->lastBufferCheckTime = currentTimePoint();
+    d->monitoring->subBufferCheckTimer.setInterval(2 * 1000); // check every 2sec
     connect(&d->monitoring->subBufferCheckTimer, &QTimer::timeout, this, &Engine::onBufferMonitorEvent);
 
+    // publisher for synchronizer telemetry, so synchronizers never have to push to streams themselves
+    d->monitoring->activeModules = activeModules;
+    d->monitoring->syncTelemetryTimer.setInterval(250);
+    connect(&d->monitoring->syncTelemetryTimer, &QTimer::timeout, this, [this]() {
+        for (auto &mod : d->monitoring->activeModules)
+            mod->publishSynchronizerTelemetry();
+
+        // drain the per-thread trace buffers before they overflow
+        if (Tracing::isEnabled())
+            d->traceCollector.collect();
+    });
+
     // start resource watchers
     d->monitoring->diskSpaceCheckTimer.start();
     d->monitoring->memCheckTimer.start();
     d->monitoring->subBufferCheckTimer.start();
+    d->monitoring->syncTelemetryTimer.start();
     qCDebug(logEngine).noquote().nospace() << "Started system resource monitoring.";
 }
 
@@ -1470,7 +1608,11 @@ void Engine::stopResourceMonitoring()
     d->monitoring->subBufferCheckTimer.stop();
     d->monitoring->subBufferCheckTimer.disconnect(this);
 
+    d->monitoring->syncTelemetryTimer.stop();
+    d->monitoring->syncTelemetryTimer.disconnect(this);
+
     d->monitoring->monitoredSubscriptions.clear();
+    d->monitoring->activeModules.clear();
     d->monitoring->exportDirPath = QString();
 
     qCDebug(logEngine).noquote().nospace() << "Stopped monitoring system resources.";
@@ -1616,8 +1758,13 @@ bool Engine::runInternal(const QString &exportDirPath)
         d->edlInternalData->setName("syntalos_internal");
         storageCollection->addChild(d->edlInternalData);
         qCDebug(logEngine).noquote().nospace() << "Writing some internal data to datasets for debugging and analysis";
+
+        // record a trace of module callbacks and queue depths for this run
+        d->traceCollector.reset();
+        Tracing::setEnabled(true);
     }
     d->internalTSyncWriters.clear();
+    FramePool::resetAllStats();
 
     // fetch list of modules in their activation order
     auto orderedActiveModules = createModuleExecOrderList();
@@ -1654,6 +1801,7 @@ bool Engine::runInternal(const QString &exportDirPath)
                 d->active = false;
                 d->failed = true;
                 d->usbEventsTimer->start();
+                Tracing::setEnabled(false);
                 return false;
             }
             modNameSet.insert(uniqName);
@@ -1674,6 +1822,7 @@ bool Engine::runInternal(const QString &exportDirPath)
     // special event threads and their assigned modules, with a specific identifier string as hash key
     QHash<QString, QList<AbstractModule *>> eventModules;
     QHash<QString, std::shared_ptr<ModuleEventThread>> evThreads;
+    std::shared_ptr<ModuleEventScheduler> evScheduler;
 
     // filter out dedicated-thread modules, those get special treatment
     for (auto &mod : orderedActiveModules) {
@@ -1735,6 +1884,9 @@ bool Engine::runInternal(const QString &exportDirPath)
         else if (mod->state() != ModuleState::READY)
             mod->setState(ModuleState::DORMANT);
 
+        // synchronizer telemetry is published by us, so we also manage its stream
+        mod->startSynchronizerTelemetry();
+
         qCDebug(logEngine).noquote().nospace()
             << "Module '" << mod->name() << "' prepared in " << timeDiffToNowMsec(lastPhaseTimepoint).count() << "msec";
     }
@@ -1852,11 +2004,38 @@ bool Engine::runInternal(const QString &exportDirPath)
         for (auto &mod : orderedActiveModules)
             mod->updateStartWaitCondition(startWaitCondition.get());
 
+        // run evented modules on a shared pool of workers, if that was selected
+        if (d->gconf->eventLoopBackend() == EventLoopBackend::WORK_STEALING && !eventModules.isEmpty()) {
+            QList<AbstractModule *> allEventModules;
+            for (auto &mod : orderedActiveModules) {
+                if ((mod->driver() == ModuleDriverKind::EVENTS_SHARED)
+                    || (mod->driver() == ModuleDriverKind::EVENTS_DEDICATED))
+                    allEventModules.append(mod);
+            }
+
+            // use as many workers as we would have used event threads, so the available parallelism stays the same
+            const auto workerCount = std::max(1, std::min(static_cast<int>(eventModules.size()), cpuCoreCount));
+            evScheduler.reset(new ModuleEventScheduler(workerCount));
+            // failures are signalled from the scheduler's threads, so this is delivered as queued event
+            connect(evScheduler.get(), &ModuleEventScheduler::failed, this, [this]() {
+                onEventExecutorFailed(QStringLiteral("event scheduler"));
+            });
+            evScheduler->run(allEventModules, startWaitCondition.get());
+            qCDebug(logEngine).noquote().nospace()
+                << "Started event scheduler with " << workerCount << " workers for " << allEventModules.length()
+                << " participating modules";
+            eventModules.clear();
+        }
+
         // run special threads with built-in event loops for modules that selected an event-based driver
         for (auto it = eventModules.constBegin(); it != eventModules.constEnd(); ++it) {
             const auto &evThreadKey = it.key();
 
             std::shared_ptr<ModuleEventThread> evThread(new ModuleEventThread(evThreadKey));
+            connect(evThread.get(), &ModuleEventThread::failed, this, [this, evThreadKey]() {
+                onEventExecutorFailed(QStringLiteral("event thread `%1`").arg(evThreadKey));
+            });
+            evThread->setBackend(d->gconf->eventLoopBackend());
             evThread->run(eventModules[evThreadKey], startWaitCondition.get());
             evThreads[evThreadKey] = evThread;
             qCDebug(logEngine).noquote().nospace() << "Started event thread '" << evThreadKey << "' with "
@@ -2036,6 +2215,10 @@ bool Engine::runInternal(const QString &exportDirPath)
         emitStatusMessage(QStringLiteral("Waiting for event thread `%1`...").arg(evThread->threadName()));
         evThread->stop();
     }
+    if (evScheduler) {
+        emitStatusMessage(QStringLiteral("Waiting for event scheduler..."));
+        evScheduler->stop();
+    }
     qCDebug(logEngine).noquote().nospace()
         << "Waited " << timeDiffToNowMsec(lastPhaseTimepoint).count() << "msec for event threads to stop.";
 
@@ -2078,6 +2261,9 @@ bool Engine::runInternal(const QString &exportDirPath)
         mod->stop();
         QCoreApplication::processEvents();
 
+        // publish the remaining synchronizer telemetry, now that no new data can arrive
+        mod->publishSynchronizerTelemetry(true);
+
         // safeguard against bad modules which don't stop running their
         // thread loops on their own
         mod->m_running = false;
@@ -2190,10 +2376,44 @@ bool Engine::runInternal(const QString &exportDirPath)
     for (auto &mod : orderedActiveModules)
         mod->setStorageGroup(nullptr);
 
+    // report how well frame buffers were recycled, frequent misses indicate allocation churn
+    for (const auto &ps : FramePool::allStats()) {
+        if (ps.hits == 0 && ps.misses == 0)
+            continue;
+        qCDebug(logEngine).noquote().nospace()
+            << "Frame pool " << ps.name << ": " << ps.hits << " hits, " << ps.misses << " misses, "
+            << "high-water mark of " << ps.highWater << " buffers (" << ps.bufferSize / 1024 << " KiB each)";
+        if (d->saveInternal) {
+            QVariantHash poolInfo;
+            poolInfo.insert(QStringLiteral("buffer_size"), static_cast<qint64>(ps.bufferSize));
+            poolInfo.insert(QStringLiteral("huge_pages"), ps.hugePages);
+            poolInfo.insert(QStringLiteral("hits"), static_cast<qint64>(ps.hits));
+            poolInfo.insert(QStringLiteral("misses"), static_cast<qint64>(ps.misses));
+            poolInfo.insert(QStringLiteral("high_water"), static_cast<qint64>(ps.highWater));
+            d->edlInternalData->insertAttribute(QStringLiteral("framepool_%1").arg(ps.name), poolInfo);
+        }
+    }
+
     if (d->saveInternal) {
         emitStatusMessage(QStringLiteral("Finalizing internal dataset..."));
         for (auto &tsw : d->internalTSyncWriters.values())
             tsw->close();
+
+        Tracing::setEnabled(false);
+        d->traceCollector.collect();
+        if (initSuccessful && d->traceCollector.eventCount() > 0) {
+            std::shared_ptr<EDLDataset> ds(new EDLDataset);
+            ds->setName(QStringLiteral("trace"));
+            d->edlInternalData->addChild(ds);
+
+            QString traceError;
+            if (!d->traceCollector.saveJson(ds->setDataFile("trace.json"), &traceError))
+                qCWarning(logEngine).noquote() << "Unable to save run trace:" << traceError;
+            if (d->traceCollector.droppedCount() > 0)
+                qCDebug(logEngine).noquote().nospace()
+                    << "Trace buffers overflowed, " << d->traceCollector.droppedCount() << " events were lost.";
+        }
+        d->traceCollector.reset();
     }
 
     if (!initSuccessful) {
@@ -2268,6 +2488,22 @@ void Engine::receiveModuleError(const QString &message)
         emit runFailed(mod, message);
 }
 
+/**
+ * Stop the current run if an event thread or the event scheduler failed.
+ * If a module failure caused this, the module has already reported its error
+ * and we keep its more specific failure reason.
+ */
+void Engine::onEventExecutorFailed(const QString &executorName)
+{
+    if (d->failed)
+        return;
+
+    qCWarning(logEngine).noquote() << "Stopping run, as the" << executorName << "has failed.";
+    d->runFailedReason = QStringLiteral("engine: The %1 failed.").arg(executorName);
+    d->failed = true;
+    d->running = false;
+}
+
 void Engine::onSynchronizerDetailsChanged(const QString &id, const TimeSyncStrategies &, const microseconds_t &)
 {
     if (!d->saveInternal)
@@ -132,7 +132,7 @@ signals:
     void runStopped();
 
     void resourceWarningUpdate(SystemResource kind, bool resolved, const QString &message);
-    void connectionHeatChangedAtPort(VarStreamInputPort *iport, ConnectionHeatLevel hlevel);
+    void connectionHeatChangedAtPort(VarStreamInputPort *iport, const ConnectionHeatInfo &heat);
 
 private slots:
     void receiveModuleError(const QString &message);
@@ -145,6 +145,7 @@ private slots:
     void onDiskspaceMonitorEvent();
     void onMemoryMonitorEvent();
     void onBufferMonitorEvent();
+    void onEventExecutorFailed(const QString &executorName);
 
 private:
     class Private;
@@ -26,6 +26,7 @@
 #include <QStandardPaths>
 #include <QCoreApplication>
 
+#include "datactl/timesync.h"
 #include "rtkit.h"
 #include "utils/misc.h"
 
@@ -212,6 +213,30 @@ void GlobalConfig::setEmergencyOOMStop(bool enabled)
     m_s->setValue("engine/emergency_oom_stop", enabled);
 }
 
+EventLoopBackend GlobalConfig::eventLoopBackend() const
+{
+    return eventLoopBackendFromString(m_s->value("engine/event_loop_backend", "glib").toString());
+}
+
+void GlobalConfig::setEventLoopBackend(EventLoopBackend backend)
+{
+    m_s->setValue("engine/event_loop_backend", eventLoopBackendToString(backend));
+}
+
+/**
+ * Offset estimator used by the secondary clock synchronizers of all modules,
+ * unless a module explicitly selects a different one.
+ */
+ClockOffsetEstimator GlobalConfig::clockOffsetEstimator() const
+{
+    return clockOffsetEstimatorFromString(m_s->value("engine/clock_offset_estimator", "window-median").toString());
+}
+
+void GlobalConfig::setClockOffsetEstimator(ClockOffsetEstimator estimator)
+{
+    m_s->setValue("engine/clock_offset_estimator", clockOffsetEstimatorToString(estimator));
+}
+
 QString Syntalos::colorModeToString(ColorMode mode)
 {
     switch (mode) {
@@ -233,6 +258,27 @@ ColorMode Syntalos::colorModeFromString(const QString &str)
     return ColorMode::SYSTEM;
 }
 
+QString Syntalos::eventLoopBackendToString(EventLoopBackend backend)
+{
+    switch (backend) {
+    case EventLoopBackend::EPOLL:
+        return QStringLiteral("epoll");
+    case EventLoopBackend::WORK_STEALING:
+        return QStringLiteral("work-stealing");
+    default:
+        return QStringLiteral("glib");
+    }
+}
+
+EventLoopBackend Syntalos::eventLoopBackendFromString(const QString &str)
+{
+    if (str == "epoll")
+        return EventLoopBackend::EPOLL;
+    if (str == "work-stealing")
+        return EventLoopBackend::WORK_STEALING;
+    return EventLoopBackend::GLIB;
+}
+
 QString Syntalos::findSyntalosPyWorkerBinary()
 {
     auto workerBinary = QStringLiteral("%1/python/pyworker").arg(QCoreApplication::applicationDirPath());
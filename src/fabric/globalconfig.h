@@ -38,6 +38,20 @@ enum class ColorMode {
 QString colorModeToString(ColorMode mode);
 ColorMode colorModeFromString(const QString &str);
 
+/**
+ * @brief How modules with an event-based driver are executed
+ */
+enum class EventLoopBackend {
+    GLIB,          /// Every event thread runs a GMainLoop for a fixed set of modules
+    EPOLL,         /// Like GLIB, but the event threads wait on epoll and timerfds directly
+    WORK_STEALING, /// All evented modules share a pool of workers that balance their callbacks
+};
+
+QString eventLoopBackendToString(EventLoopBackend backend);
+EventLoopBackend eventLoopBackendFromString(const QString &str);
+
+enum class ClockOffsetEstimator;
+
 QString findSyntalosPyWorkerBinary();
 void findSyntalosLibraryPaths(QString &pkgConfigPath, QString &ldLibraryPath, QString &includePath);
 
@@ -88,6 +102,12 @@ public:
     bool emergencyOOMStop() const;
     void setEmergencyOOMStop(bool enabled);
 
+    EventLoopBackend eventLoopBackend() const;
+    void setEventLoopBackend(EventLoopBackend backend);
+
+    ClockOffsetEstimator clockOffsetEstimator() const;
+    void setClockOffsetEstimator(ClockOffsetEstimator estimator);
+
 private:
     QSettings *m_s;
     QString m_userHome;
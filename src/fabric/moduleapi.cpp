@@ -25,10 +25,12 @@
 #include <QDir>
 #include <QMainWindow>
 #include <QMessageBox>
+#include <QMutex>
 #include <QStandardPaths>
 #include <QCursor>
 
 #include "datactl/frametype.h"
+#include "globalconfig.h"
 #include "utils/misc.h"
 
 using namespace Syntalos;
@@ -204,6 +206,9 @@ public:
     QString title;
     AbstractModule *owner;
     StreamOutputPort *outPort;
+
+    size_t queueCapacity;
+    BackpressurePolicy bpPolicy;
 };
 
 VarStreamInputPort::VarStreamInputPort(AbstractModule *owner, const QString &id, const QString &title)
@@ -213,6 +218,8 @@ VarStreamInputPort::VarStreamInputPort(AbstractModule *owner, const QString &id,
     d->title = title;
     d->owner = owner;
     d->outPort = nullptr;
+    d->queueCapacity = 0;
+    d->bpPolicy = BackpressurePolicy::BlockProducer;
 }
 
 VarStreamInputPort::~VarStreamInputPort() {}
@@ -226,6 +233,8 @@ void VarStreamInputPort::setSubscription(StreamOutputPort *src, std::shared_ptr<
 {
     d->outPort = src;
     m_sub = sub;
+    if (sub != nullptr && d->queueCapacity > 0)
+        sub->setQueueCapacity(d->queueCapacity, d->bpPolicy);
 
     d->owner->inputPortConnected(this);
 
@@ -259,6 +268,24 @@ std::shared_ptr<VariantStreamSubscription> VarStreamInputPort::subscriptionVar()
     return sub;
 }
 
+void VarStreamInputPort::setQueueCapacity(size_t capacity, BackpressurePolicy policy)
+{
+    d->queueCapacity = capacity;
+    d->bpPolicy = policy;
+    if (m_sub.has_value() && m_sub.value() != nullptr)
+        m_sub.value()->setQueueCapacity(capacity, policy);
+}
+
+size_t VarStreamInputPort::queueCapacity() const
+{
+    return d->queueCapacity;
+}
+
+BackpressurePolicy VarStreamInputPort::backpressurePolicy() const
+{
+    return d->bpPolicy;
+}
+
 QString VarStreamInputPort::id() const
 {
     return d->id;
@@ -331,6 +358,16 @@ std::shared_ptr<VariantStreamSubscription> StreamOutputPort::subscribe()
     return d->stream->subscribeVar();
 }
 
+bool StreamOutputPort::setStreamBackend(StreamBackend backend, size_t ringCapacity)
+{
+    return d->stream->setBackend(backend, ringCapacity);
+}
+
+StreamBackend StreamOutputPort::streamBackend() const
+{
+    return d->stream->backend();
+}
+
 void StreamOutputPort::stopStream()
 {
     if (d->stream->active())
@@ -383,6 +420,7 @@ VarStreamInputPort *Syntalos::newInputPortForType(
     CHECK_RETURN_INPUT_PORT(Frame)
     CHECK_RETURN_INPUT_PORT(IntSignalBlock)
     CHECK_RETURN_INPUT_PORT(FloatSignalBlock)
+    CHECK_RETURN_INPUT_PORT(Float32SignalBlock)
 
     qCritical() << "Unable to create input port for unknown type ID" << typeId;
     return nullptr;
@@ -397,6 +435,7 @@ VariantDataStream *Syntalos::newStreamForType(int typeId)
     CHECK_RETURN_STREAM(Frame)
     CHECK_RETURN_STREAM(IntSignalBlock)
     CHECK_RETURN_STREAM(FloatSignalBlock)
+    CHECK_RETURN_STREAM(Float32SignalBlock)
 
     qCritical() << "Unable to create data stream for unknown type ID" << typeId;
     return nullptr;
@@ -483,6 +522,11 @@ public:
 
     bool initialized;
     bool runIsEmphemeral;
+
+    std::shared_ptr<DataStream<FloatSignalBlock>> syncTelemetryStream;
+    std::vector<std::shared_ptr<SyncTelemetryBuffer>> syncTelemetryBuffers;
+    FloatSignalBlock syncTelemetryBlock;
+    QMutex syncTelemetryMutex;
 };
 
 // instantiate static field
@@ -912,7 +956,13 @@ std::shared_ptr<EDLDataset> AbstractModule::createDatasetInGroup(
         }
     }
 
-    return group->datasetByName(datasetName, true);
+    dset = group->datasetByName(datasetName, true);
+    if (dset.get() != nullptr && dset->generatorId().isEmpty()) {
+        // record which module type created this data, so it can be found again later
+        dset->setGeneratorId(id());
+    }
+
+    return dset;
 }
 
 std::shared_ptr<EDLDataset> AbstractModule::getDefaultDataset()
@@ -964,6 +1014,7 @@ std::unique_ptr<FreqCounterSynchronizer> AbstractModule::initCounterSynchronizer
     assert(frequencyHz > 0);
 
     auto synchronizer = std::make_unique<FreqCounterSynchronizer>(m_syTimer, name(), frequencyHz);
+    synchronizer->setTelemetryBuffer(newSynchronizerTelemetryBuffer());
     synchronizer->setNotifyCallbacks(
         [this](const QString &id, const TimeSyncStrategies &strategies, const microseconds_t &tolerance) {
             Q_EMIT synchronizerDetailsChanged(id, strategies, tolerance);
@@ -984,6 +1035,11 @@ std::unique_ptr<SecondaryClockSynchronizer> AbstractModule::initClockSynchronize
     if (expectedFrequencyHz > 0)
         synchronizer->setExpectedClockFrequencyHz(expectedFrequencyHz);
 
+    // modules may still select a different estimator before they start the synchronizer
+    GlobalConfig gconf;
+    synchronizer->setOffsetEstimator(gconf.clockOffsetEstimator());
+    synchronizer->setTelemetryBuffer(newSynchronizerTelemetryBuffer());
+
     synchronizer->setNotifyCallbacks(
         [this](const QString &id, const TimeSyncStrategies &strategies, const microseconds_t &tolerance) {
             Q_EMIT synchronizerDetailsChanged(id, strategies, tolerance);
@@ -995,6 +1051,69 @@ std::unique_ptr<SecondaryClockSynchronizer> AbstractModule::initClockSynchronize
     return synchronizer;
 }
 
+std::shared_ptr<DataStream<FloatSignalBlock>> AbstractModule::registerSynchronizerTelemetryPort(
+    const QString &id,
+    const QString &title)
+{
+    d->syncTelemetryStream = registerOutputPort<FloatSignalBlock>(id, title);
+    d->syncTelemetryStream->setMetadataValue(QStringLiteral("time_unit"), QStringLiteral("microseconds"));
+    d->syncTelemetryStream->setMetadataValue(QStringLiteral("data_unit"), QStringLiteral("µs"));
+    d->syncTelemetryStream->setMetadataValue(
+        QStringLiteral("signal_names"),
+        QStringList() << QStringLiteral("offset") << QStringLiteral("filtered_offset")
+                      << QStringLiteral("correction") << QStringLiteral("synchronizer"));
+    return d->syncTelemetryStream;
+}
+
+std::shared_ptr<SyncTelemetryBuffer> AbstractModule::newSynchronizerTelemetryBuffer()
+{
+    if (!d->syncTelemetryStream || !d->syncTelemetryStream->hasSubscribers())
+        return nullptr;
+
+    // synchronizers are numbered in the order they were created, so their records can be told apart
+    QMutexLocker locker(&d->syncTelemetryMutex);
+    auto buffer = std::make_shared<SyncTelemetryBuffer>(4096, static_cast<int>(d->syncTelemetryBuffers.size()));
+    d->syncTelemetryBuffers.push_back(buffer);
+    return buffer;
+}
+
+/**
+ * @brief Start the synchronizer telemetry stream, if anything subscribed to it.
+ *
+ * Called by the engine once the module was prepared.
+ */
+void AbstractModule::startSynchronizerTelemetry()
+{
+    if (!d->syncTelemetryStream || !d->syncTelemetryStream->hasSubscribers())
+        return;
+    d->syncTelemetryStream->start();
+}
+
+/**
+ * @brief Publish all pending synchronizer telemetry.
+ *
+ * Called by the engine periodically during a run, and a last time with @p finalize set
+ * once the module has stopped, which also releases all telemetry buffers.
+ */
+void AbstractModule::publishSynchronizerTelemetry(bool finalize)
+{
+    QMutexLocker locker(&d->syncTelemetryMutex);
+    for (auto &buffer : d->syncTelemetryBuffers) {
+        if (buffer->takeAll(d->syncTelemetryBlock) > 0)
+            d->syncTelemetryStream->push(d->syncTelemetryBlock);
+    }
+
+    if (!finalize)
+        return;
+
+    for (auto &buffer : d->syncTelemetryBuffers) {
+        if (buffer->droppedCount() > 0)
+            qWarning().noquote() << "Module" << name() << "dropped" << buffer->droppedCount()
+                                 << "synchronizer telemetry records.";
+    }
+    d->syncTelemetryBuffers.clear();
+}
+
 uint AbstractModule::potentialNoaffinityCPUCount() const
 {
     return d->potentialNoaffinityCPUCount;
@@ -26,6 +26,7 @@
 #include <QList>
 #include <QObject>
 #include <QPixmap>
+#include <QSet>
 
 #include "modconfig.h"
 #include "optionalwaitcondition.h"
@@ -276,6 +277,19 @@ public:
 
     std::shared_ptr<VariantStreamSubscription> subscriptionVar();
 
+    /**
+     * @brief Limit the amount of pending elements for this port's subscription
+     *
+     * Set a maximum queue capacity for data received on this port, and the
+     * policy to apply in case the queue is full. A capacity of 0 (the default)
+     * means the queue is unbounded.
+     * The setting is applied to the current subscription (if the stream is not
+     * running) and to any future subscription of this port.
+     */
+    void setQueueCapacity(size_t capacity, BackpressurePolicy policy);
+    size_t queueCapacity() const;
+    BackpressurePolicy backpressurePolicy() const;
+
     QString id() const override;
     QString title() const override;
     PortDirection direction() const override;
@@ -301,10 +315,23 @@ public:
         m_acceptedTypeName = BaseDataType::typeIdToString(m_acceptedTypeId);
     }
 
+    /**
+     * @brief Obtain the subscription of this port as subscription to the port's primary type
+     *
+     * Returns nullptr if the port was connected to one of the types permitted via
+     * acceptAlternativeType(), use subscriptionAs() to retrieve the subscription in that case.
+     */
     std::shared_ptr<StreamSubscription<T>> subscription()
     {
         auto sub = std::dynamic_pointer_cast<StreamSubscription<T>>(m_sub.value());
         if (sub == nullptr) {
+            if (hasSubscription() && m_altTypeIds.contains(m_sub.value()->dataTypeId())) {
+                // subscribed to a compatible type, the module needs to use subscriptionAs()
+                qWarning().noquote() << "Tried to obtain" << typeid(T).name() << "subscription from port" << id()
+                                     << "which is subscribed to alternative type"
+                                     << m_sub.value()->dataTypeName() << "- use subscriptionAs() instead.";
+                return sub;
+            }
             if (hasSubscription()) {
                 qCritical().noquote() << "Conversion of variant subscription to dedicated type" << typeid(T).name()
                                       << "failed."
@@ -319,6 +346,34 @@ public:
         return sub;
     }
 
+    /**
+     * @brief Obtain the subscription of this port as subscription to a compatible type
+     *
+     * Returns nullptr if the port is not subscribed to a stream of type U.
+     * See acceptAlternativeType().
+     */
+    template<typename U>
+    std::shared_ptr<StreamSubscription<U>> subscriptionAs()
+    {
+        if (!hasSubscription())
+            return nullptr;
+        return std::dynamic_pointer_cast<StreamSubscription<U>>(m_sub.value());
+    }
+
+    /**
+     * @brief Permit connecting this port to output ports of type U as well
+     *
+     * A module that sets this must check the type of the actual subscription
+     * with subscriptionVar()->dataTypeId() and use subscriptionAs() to retrieve
+     * it if it is not of the port's primary type.
+     */
+    template<typename U>
+    void acceptAlternativeType()
+    {
+        m_altTypeIds.insert(syDataTypeId<U>());
+        m_altTypeNames.insert(BaseDataType::typeIdToString(syDataTypeId<U>()));
+    }
+
     int dataTypeId() const override
     {
         return m_acceptedTypeId;
@@ -331,12 +386,14 @@ public:
 
     bool acceptsSubscription(const QString &typeName) override
     {
-        return m_acceptedTypeName == typeName;
+        return m_acceptedTypeName == typeName || m_altTypeNames.contains(typeName);
     }
 
 private:
     int m_acceptedTypeId;
     QString m_acceptedTypeName;
+    QSet<int> m_altTypeIds;
+    QSet<QString> m_altTypeNames;
 };
 
 class Q_DECL_EXPORT StreamOutputPort : public AbstractStreamPort
@@ -362,6 +419,17 @@ public:
 
     std::shared_ptr<VariantStreamSubscription> subscribe();
 
+    /**
+     * @brief Select how data of this port is distributed to its subscribers
+     *
+     * Ports with many subscribers may benefit from the shared ring backend, where
+     * every element is only written once, independent of the number of subscribers.
+     * See DataStream::setBackend() for details. Can only be changed while the port's
+     * stream is not running.
+     */
+    bool setStreamBackend(StreamBackend backend, size_t ringCapacity = 0);
+    StreamBackend streamBackend() const;
+
     void startStream();
     void stopStream();
 
@@ -563,6 +631,23 @@ public:
         return inPort;
     }
 
+    /**
+     * @brief Register an output port for synchronizer telemetry
+     *
+     * This function may be called in the module's constructor to publish telemetry of all
+     * synchronizers created with initCounterSynchronizer() or initClockSynchronizer().
+     * Telemetry is only recorded if the port has subscribers when a synchronizer is created.
+     * Every signal block contains records of a single synchronizer, with the master timestamp in µs
+     * and the instantaneous offset deviation, filtered offset deviation and applied correction
+     * in µs as columns. A fourth "synchronizer" column holds the index of the synchronizer
+     * that produced the block, counted in the order the synchronizers were created during a run.
+     *
+     * @returns The telemetry data stream, which is managed by Syntalos.
+     */
+    std::shared_ptr<DataStream<FloatSignalBlock>> registerSynchronizerTelemetryPort(
+        const QString &id = QStringLiteral("sync-telemetry"),
+        const QString &title = QStringLiteral("Sync Telemetry"));
+
     /**
      * @brief Initialize the module
      *
@@ -954,6 +1039,9 @@ protected:
      * the secondary clock may change its speed (as is the case with many cameras that don't run at an exactly constant
      * framerate but sometimes produce frames faster or slower than before)
      *
+     * The offset estimator is preselected from the "engine/clock_offset_estimator" setting, modules
+     * can still choose a different one with SecondaryClockSynchronizer::setOffsetEstimator() before starting it.
+     *
      * Returns: A new unique clock synchronizer, or NULL if we could not create one because no master timer existed.
      */
     std::unique_ptr<SecondaryClockSynchronizer> initClockSynchronizer(double expectedFrequencyHz = 0);
@@ -1031,6 +1119,9 @@ private:
     void setPotentialNoaffinityCPUCount(uint coreN);
     void setDefaultRTPriority(int prio);
     void setEphemeralRun(bool isEphemeral);
+    std::shared_ptr<SyncTelemetryBuffer> newSynchronizerTelemetryBuffer();
+    void startSynchronizerTelemetry();
+    void publishSynchronizerTelemetry(bool finalize = false);
 };
 
 } // namespace Syntalos
@@ -46,13 +46,15 @@ public:
 
     uint waitingCount() const;
 
+protected:
+    // only the engine (or a test standing in for it) may release the waiting threads
+    void wakeAll();
+    void reset();
+
 private:
     class OWCData;
     QSharedPointer<OWCData> d;
     Q_DISABLE_COPY(OptionalWaitCondition)
-
-    void wakeAll();
-    void reset();
 };
 
 } // namespace Syntalos
@@ -25,6 +25,7 @@
 #include <iceoryx_posh/popo/untyped_publisher.hpp>
 
 #include "streams/stream.h"
+#include "streams/subscriptionsource.h"
 #include "utils/misc.h"
 #include "mlinkmodule.h"
 
@@ -197,63 +198,12 @@ static gboolean recvStreamEventDispatch(gpointer udata)
     // as the client we want to communicate with may have crashed.
     // If we try to communicate with a crashed client, we will wait for a long time
     // and might run out of memory meanwhile.
-    for (uint i = 0; i < 20; i++) {
-        if (!ed->self->isRunning())
-            break;
-        if (!ed->subscription->callIfNextVar(sendFn))
-            break;
-    }
+    if (ed->self->isRunning())
+        ed->subscription->callForPendingVar(sendFn, 20);
 
     return TRUE;
 }
 
-typedef struct {
-    GSource source;
-    int event_fd;
-    gpointer event_fd_tag;
-} EFDSignalSource;
-
-static gboolean efd_signal_source_prepare(GSource *, gint *timeout)
-{
-    *timeout = -1;
-    return FALSE;
-}
-
-static gboolean efd_signal_source_dispatch(GSource *source, GSourceFunc callback, gpointer user_data)
-{
-    EFDSignalSource *efd_source = (EFDSignalSource *)source;
-
-    unsigned events = g_source_query_unix_fd(source, efd_source->event_fd_tag);
-    if (events & G_IO_HUP || events & G_IO_ERR || events & G_IO_NVAL) {
-        return G_SOURCE_REMOVE;
-    }
-
-    gboolean result_continue = G_SOURCE_CONTINUE;
-    if (events & G_IO_IN) {
-        uint64_t buffer;
-        // just read the buffer count for now to empty it
-        // (maybe we can do something useful with the element count later?)
-        if (G_UNLIKELY(read(efd_source->event_fd, &buffer, sizeof(buffer)) == -1 && errno != EAGAIN))
-            qCWarning(logSExporter).noquote() << "Failed to read from eventfd:" << g_strerror(errno);
-
-        result_continue = callback(user_data);
-    }
-    g_source_set_ready_time(source, -1);
-    return result_continue;
-}
-
-static GSourceFuncs efd_source_funcs =
-    {.prepare = efd_signal_source_prepare, .check = NULL, .dispatch = efd_signal_source_dispatch, .finalize = NULL};
-
-static GSource *efd_signal_source_new(int event_fd)
-{
-    auto source = (EFDSignalSource *)g_source_new(&efd_source_funcs, sizeof(EFDSignalSource));
-    source->event_fd = event_fd;
-    source->event_fd_tag = g_source_add_unix_fd(
-        (GSource *)source, event_fd, (GIOCondition)(G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL));
-    return (GSource *)source;
-}
-
 void StreamExporter::streamEventThreadFunc(OptionalWaitCondition *waitCondition)
 {
     pthread_setname_np(pthread_self(), qPrintable(d->threadName.mid(0, 15)));
@@ -264,9 +214,7 @@ void StreamExporter::streamEventThreadFunc(OptionalWaitCondition *waitCondition)
 
     // register events for all streams to be published
     for (auto &ed : d->exports) {
-        int eventfd = ed.subscription->enableNotify();
-
-        ed.source = efd_signal_source_new(eventfd);
+        ed.source = newSubscriptionEventSource(ed.subscription.get());
         g_source_set_callback(ed.source, &recvStreamEventDispatch, &ed, NULL);
         g_source_attach(ed.source, context);
     }
@@ -3,6 +3,11 @@
 // should have come with this header).
 // Uses Jeff Preshing's semaphore implementation (under the terms of its
 // separate zlib license, embedded below).
+//
+// NOTE: This is a modified copy of upstream atomicops.h from readerwriterqueue.
+// Syntalos adds LightweightSemaphore::tryWaitMany() and LightweightSemaphore::waitMany(),
+// which back the bulk dequeue functions in readerwriterqueue.h. Changes are marked
+// with "Syntalos:" comments and must be carried over when syncing with upstream.
 
 #pragma once
 // clang-format off
@@ -734,6 +739,33 @@ namespace moodycamel
 				return tryWait() || waitWithPartialSpinning(timeout_usecs);
 			}
 
+			// Syntalos: Batch acquisition, not part of upstream.
+			// Acquires between 0 and (greedily) max, inclusive.
+			// Must only be called from the consumer thread.
+			ssize_t tryWaitMany(ssize_t max) AE_NO_TSAN
+			{
+				assert(max >= 0);
+				ssize_t count = m_count.load();
+				if (count <= 0)
+					return 0;
+				if (count > max)
+					count = max;
+				m_count.fetch_add_acquire(-count);
+				return count;
+			}
+
+			// Acquires at least one, and (greedily) at most max.
+			// Returns 0 if the timeout expired before anything could be acquired.
+			ssize_t waitMany(ssize_t max, std::int64_t timeout_usecs = -1) AE_NO_TSAN
+			{
+				assert(max >= 0);
+				ssize_t result = tryWaitMany(max);
+				if (result == 0 && max > 0 && wait(timeout_usecs))
+					result = 1 + tryWaitMany(max - 1);
+				return result;
+			}
+			// Syntalos: End of batch acquisition.
+
 		    void signal(ssize_t count = 1) AE_NO_TSAN
 		    {
 		    	assert(count >= 0);
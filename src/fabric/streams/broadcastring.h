@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2019-2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Fixed-size single-producer ring buffer that is read by multiple consumers
+ *
+ * Every element is written exactly once into the ring, and each reader keeps
+ * its own read position (cursor). The cost of publishing an element is therefore
+ * independent of the number of readers, and the lag of an individual reader
+ * is simply the distance between its cursor and the write position.
+ *
+ * Readers can either gate the producer, in which case the producer waits for them
+ * before overwriting an element they have not read yet, or be non-gating, in which
+ * case they may be overrun and have to skip ahead to the oldest available element.
+ *
+ * Readers must only be added or removed while nothing is published to the ring.
+ */
+template<typename T>
+class BroadcastRing
+{
+public:
+    struct Cursor {
+        std::atomic<uint64_t> position{0};
+        std::atomic_bool gating{true};
+    };
+
+    explicit BroadcastRing(size_t capacity)
+        : m_head(0),
+          m_running(false),
+          m_gateCache(0),
+          m_producerWaiting(false),
+          m_waitingReaders(0)
+    {
+        // we need a power of two so sequence numbers can be mapped to slots cheaply
+        m_capacity = 1;
+        while (m_capacity < capacity)
+            m_capacity <<= 1;
+        m_mask = m_capacity - 1;
+        m_slots = std::make_unique<Slot[]>(m_capacity);
+    }
+
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    std::shared_ptr<Cursor> addReader()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto cursor = std::make_shared<Cursor>();
+        cursor->position = m_head.load();
+        m_readers.push_back(cursor);
+        return cursor;
+    }
+
+    void removeReader(const std::shared_ptr<Cursor> &cursor)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_readers.begin(); it != m_readers.end(); ++it) {
+            if (*it == cursor) {
+                m_readers.erase(it);
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief Drop all data and rewind the ring and all reader positions
+     */
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < m_capacity; ++i) {
+            m_slots[i].seq.store(invalidSeq, std::memory_order_relaxed);
+            m_slots[i].value.store(nullptr, std::memory_order_relaxed);
+        }
+        for (const auto &cursor : m_readers)
+            cursor->position = 0;
+        m_gateCache = 0;
+        m_head = 0;
+        m_running = true;
+    }
+
+    /**
+     * @brief Stop publishing, wakes up all waiting readers and a waiting producer
+     */
+    void stop()
+    {
+        m_running = false;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_readerCond.notify_all();
+        m_producerCond.notify_all();
+    }
+
+    bool running() const
+    {
+        return m_running;
+    }
+
+    /**
+     * @brief Sequence number of the next element that will be published
+     */
+    uint64_t head() const
+    {
+        return m_head.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Publish a new element to all readers
+     *
+     * If a gating reader has not yet read the element that would be overwritten,
+     * this function blocks until it has made progress.
+     * @return False if the ring was stopped while waiting.
+     */
+    bool publish(std::shared_ptr<const T> value, int64_t timestampUsec)
+    {
+        const auto seq = m_head.load(std::memory_order_relaxed);
+        if (seq >= m_capacity && !waitForCapacity(seq - m_capacity + 1))
+            return false;
+
+        // seqlock-style write, so overrun readers can detect that the slot changed under them
+        auto &slot = m_slots[seq & m_mask];
+        slot.seq.store(invalidSeq, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.value.store(std::move(value), std::memory_order_relaxed);
+        slot.timestampUsec.store(timestampUsec, std::memory_order_relaxed);
+        slot.seq.store(seq, std::memory_order_release);
+
+        m_head.store(seq + 1, std::memory_order_seq_cst);
+        if (m_waitingReaders.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_readerCond.notify_all();
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Read the element with the given sequence number
+     * @return False if the element was already overwritten by the producer.
+     */
+    bool read(uint64_t seq, std::shared_ptr<const T> &value, int64_t &timestampUsec) const
+    {
+        const auto &slot = m_slots[seq & m_mask];
+        if (slot.seq.load(std::memory_order_acquire) != seq)
+            return false;
+        value = slot.value.load(std::memory_order_relaxed);
+        timestampUsec = slot.timestampUsec.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.seq.load(std::memory_order_relaxed) == seq;
+    }
+
+    /**
+     * @brief Notify the producer that a reader has advanced its cursor or stopped gating
+     */
+    void readerAdvanced()
+    {
+        if (!m_producerWaiting.load(std::memory_order_seq_cst))
+            return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_producerCond.notify_all();
+    }
+
+    /**
+     * @brief Wait until the given predicate becomes true
+     *
+     * The predicate is re-evaluated whenever new data was published, or wakeReaders()
+     * was called.
+     * @param timeoutUsec Maximum time to wait, or a negative value to wait indefinitely.
+     * @return The result of the predicate.
+     */
+    template<typename Pred>
+    bool waitUntil(int64_t timeoutUsec, Pred &&ready)
+    {
+        if (ready())
+            return true;
+
+        m_waitingReaders.fetch_add(1, std::memory_order_seq_cst);
+        bool result;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (timeoutUsec < 0) {
+                m_readerCond.wait(lock, ready);
+                result = true;
+            } else {
+                result = m_readerCond.wait_for(lock, std::chrono::microseconds(timeoutUsec), ready);
+            }
+        }
+        m_waitingReaders.fetch_sub(1, std::memory_order_seq_cst);
+        return result;
+    }
+
+    void wakeReaders()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_readerCond.notify_all();
+    }
+
+private:
+    static constexpr uint64_t invalidSeq = std::numeric_limits<uint64_t>::max();
+
+    struct Slot {
+        std::atomic<uint64_t> seq{invalidSeq};
+        std::atomic<std::shared_ptr<const T>> value;
+        std::atomic_int64_t timestampUsec{0};
+    };
+
+    size_t m_capacity;
+    size_t m_mask;
+    std::unique_ptr<Slot[]> m_slots;
+    alignas(64) std::atomic<uint64_t> m_head;
+    std::atomic_bool m_running;
+
+    // only accessed by the producer: lowest known position of all gating readers
+    uint64_t m_gateCache;
+
+    std::mutex m_mutex;
+    std::condition_variable m_readerCond;
+    std::condition_variable m_producerCond;
+    std::atomic_bool m_producerWaiting;
+    std::atomic_int m_waitingReaders;
+    std::vector<std::shared_ptr<Cursor>> m_readers;
+
+    uint64_t minGatingPosition() const
+    {
+        auto pos = m_head.load(std::memory_order_relaxed);
+        for (const auto &cursor : m_readers) {
+            if (!cursor->gating.load(std::memory_order_seq_cst))
+                continue;
+            pos = std::min(pos, cursor->position.load(std::memory_order_seq_cst));
+        }
+        return pos;
+    }
+
+    bool waitForCapacity(uint64_t minPosition)
+    {
+        // scanning all readers is only needed once the cached position was used up,
+        // so in the common case publishing does not touch any reader state
+        if (m_gateCache >= minPosition)
+            return true;
+
+        while (true) {
+            m_gateCache = minGatingPosition();
+            if (m_gateCache >= minPosition)
+                return true;
+            if (!m_running)
+                return false;
+
+            m_producerWaiting.store(true, std::memory_order_seq_cst);
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (minGatingPosition() < minPosition && m_running)
+                m_producerCond.wait_for(lock, std::chrono::milliseconds(10));
+            m_producerWaiting.store(false, std::memory_order_relaxed);
+        }
+    }
+};
@@ -1,6 +1,12 @@
 // ©2013-2020 Cameron Desrochers.
 // Distributed under the simplified BSD license (see the license file
 // in tests/rwqueue/LICENSE.rwqueue for details).
+//
+// NOTE: This is a modified copy of upstream readerwriterqueue.
+// Syntalos adds the bulk dequeue functions BlockingReaderWriterQueue::try_dequeue_bulk()
+// and BlockingReaderWriterQueue::wait_dequeue_bulk_timed(), which need access to the
+// private semaphore. Changes are marked with "Syntalos:" comments and must be
+// carried over when syncing with a new upstream release.
 
 #pragma once
 // clang-format off
@@ -915,6 +921,40 @@ public:
 	}
 
 
+	// Syntalos: Bulk dequeue functions, not part of upstream.
+	// Attempts to dequeue up to max elements at once, writing them to the
+	// output iterator. The semaphore is only touched once for the whole batch.
+	// Returns the number of elements dequeued (0 if the queue was empty).
+	template<typename It>
+	size_t try_dequeue_bulk(It itemFirst, size_t max) AE_NO_TSAN
+	{
+		const auto count = static_cast<size_t>(sema->tryWaitMany(static_cast<spsc_sema::LightweightSemaphore::ssize_t>(max)));
+		for (size_t i = 0; i != count; ++i) {
+			bool success = inner.try_dequeue(*itemFirst++);
+			assert(success);
+			AE_UNUSED(success);
+		}
+		return count;
+	}
+
+
+	// Like try_dequeue_bulk, but waits up to the specified timeout for at
+	// least one element to become available. A negative timeout waits
+	// indefinitely.
+	template<typename It>
+	size_t wait_dequeue_bulk_timed(It itemFirst, size_t max, std::int64_t timeout_usecs) AE_NO_TSAN
+	{
+		const auto count = static_cast<size_t>(sema->waitMany(static_cast<spsc_sema::LightweightSemaphore::ssize_t>(max), timeout_usecs));
+		for (size_t i = 0; i != count; ++i) {
+			bool success = inner.try_dequeue(*itemFirst++);
+			assert(success);
+			AE_UNUSED(success);
+		}
+		return count;
+	}
+	// Syntalos: End of bulk dequeue functions.
+
+
 	// Returns a pointer to the front element in the queue (the one that
 	// would be removed next by a call to `try_dequeue` or `pop`). If the
 	// queue appears empty at the time the method is called, nullptr is
@@ -30,10 +30,13 @@
 #include <sys/eventfd.h>
 #include <thread>
 #include <unistd.h>
+#include <variant>
 
 #include "datactl/datatypes.h"
+#include "broadcastring.h"
 #include "readerwriterqueue.h"
 #include "datactl/syclock.h"
+#include "tracing.h"
 
 using namespace moodycamel;
 using namespace Syntalos;
@@ -63,10 +66,37 @@ Q_GLOBAL_STATIC_WITH_ARGS(CommonMetadataKeyMap,
 );
 // clang-format on
 
+/**
+ * @brief Policy to apply when the queue of a bounded subscription is full
+ */
+enum class BackpressurePolicy {
+    BlockProducer, /// Wait for the consumer to make room (never loses data, but may stall the producer)
+    DropOldest,    /// Discard the oldest pending element to make room for the new one
+    DropNewest,    /// Discard the element that is being pushed
+    KeepLatest     /// Only keep the most recent element, useful for display-only consumers
+};
+
+/**
+ * @brief When a subscription signals its eventfd about new data
+ */
+enum class SubscriptionNotifyMode {
+    PerItem,   /// Signal for every new element (lowest latency, highest overhead)
+    Coalesced, /// Only signal when the consumer has seen an empty queue before, i.e. once per burst
+    Batched    /// Like Coalesced, but wait for a minimum batch size or until a latency window expired
+};
+
+/**
+ * @brief How a stream distributes its data to subscribers
+ */
+enum class StreamBackend {
+    SubscriberQueues, /// Every subscription has its own queue, data is enqueued once per subscriber
+    SharedRing        /// Data is written once into a fixed-size ring that all subscribers read from
+};
+
 /**
  * @brief A function that can be used to process a variant value
  */
-using ProcessVarFn = std::function<void(BaseDataType &)>;
+using ProcessVarFn = std::function<void(const BaseDataType &)>;
 
 class VariantStreamSubscription
 {
@@ -75,14 +105,28 @@ public:
     virtual int dataTypeId() const = 0;
     virtual QString dataTypeName() const = 0;
     virtual bool callIfNextVar(const ProcessVarFn &fn) = 0;
+    virtual size_t callForPendingVar(const ProcessVarFn &fn, size_t maxItems = 0) = 0;
     virtual bool unsubscribe() = 0;
     virtual bool active() const = 0;
     virtual bool hasPending() const = 0;
     virtual size_t approxPendingCount() const = 0;
+    virtual size_t approxPendingBytes() const = 0;
     virtual int enableNotify() = 0;
     virtual void disableNotify() = 0;
+    virtual void setNotifyMode(
+        SubscriptionNotifyMode mode,
+        size_t minBatch = 1,
+        const microseconds_t &maxLatency = microseconds_t(0)) = 0;
+    virtual SubscriptionNotifyMode notifyMode() const = 0;
+    virtual bool armNotify() = 0;
+    virtual microseconds_t notifyMaxLatency() const = 0;
     virtual void setThrottleItemsPerSec(uint itemsPerSec, bool allowMore = true) = 0;
 
+    virtual bool setQueueCapacity(size_t capacity, BackpressurePolicy policy) = 0;
+    virtual size_t queueCapacity() const = 0;
+    virtual BackpressurePolicy backpressurePolicy() const = 0;
+    virtual size_t droppedElementCount() const = 0;
+
     virtual void suspend() = 0;
     virtual void resume() = 0;
     virtual void clearPending() = 0;
@@ -106,6 +150,8 @@ public:
     virtual void stop() = 0;
     virtual bool active() const = 0;
     virtual bool hasSubscribers() const = 0;
+    virtual bool setBackend(StreamBackend backend, size_t ringCapacity = 0) = 0;
+    virtual StreamBackend backend() const = 0;
     virtual void pushRawData(int typeId, const void *data, size_t size) = 0;
     virtual QHash<QString, QVariant> metadata() = 0;
     virtual void setMetadata(const QHash<QString, QVariant> &metadata) = 0;
@@ -124,13 +170,29 @@ class StreamSubscription : public VariantStreamSubscription
 public:
     explicit StreamSubscription(DataStream<T> *stream)
         : m_stream(stream),
-          m_queue(BlockingReaderWriterQueue<std::optional<T>>(256)),
+          m_queue(BlockingReaderWriterQueue<Envelope>(256)),
+          m_capacity(0),
+          m_policy(BackpressurePolicy::BlockProducer),
+          m_producerWaiting(false),
+          m_consumerWaiting(false),
           m_eventfd(-1),
           m_notify(false),
+          m_notifyMode(SubscriptionNotifyMode::PerItem),
+          m_notifyArmed(true),
+          m_notifyMinBatch(1),
+          m_notifyMaxLatencyUsec(0),
+          m_batchStartUsec(0),
           m_active(true),
           m_suspended(false),
           m_throttle(0),
-          m_skippedElements(0)
+          m_skippedElements(0),
+          m_droppedElements(0),
+          m_forcedEndMarkers(0),
+          m_forcedEndPosition(0),
+          m_lastRingItemUsec(0),
+          m_traceQueueName(nullptr),
+          m_itemBytes(sizeof(T)),
+          m_sizeSampleCounter(0)
     {
         m_lastItemTime = currentTimePoint();
         m_eventfd = eventfd(0, EFD_NONBLOCK);
@@ -144,6 +206,8 @@ public:
     {
         m_active = false;
         unsubscribe();
+        if (m_ring)
+            m_ring->removeReader(m_cursor);
         m_notify = false;
         close(m_eventfd);
     }
@@ -154,11 +218,11 @@ public:
      */
     std::optional<T> next()
     {
-        if (!m_active && m_queue.peek() == nullptr)
+        if (!m_active && approxPendingCount() == 0)
             return std::nullopt;
-        std::optional<T> data;
-        m_queue.wait_dequeue(data);
-        return data;
+        Envelope item;
+        waitDequeue(item);
+        return takeValue(std::move(item));
     }
 
     /**
@@ -168,14 +232,48 @@ public:
      */
     std::optional<T> peekNext()
     {
-        if (!m_active && m_queue.peek() == nullptr)
+        if (!m_active && approxPendingCount() == 0)
             return std::nullopt;
-        std::optional<T> data;
+        Envelope item;
 
-        if (!m_queue.try_dequeue(data))
+        if (!tryDequeue(item))
             return std::nullopt;
 
-        return data;
+        return takeValue(std::move(item));
+    }
+
+    /**
+     * @brief Obtain next element as shared, immutable payload, block in case there is no new element
+     *
+     * If the producer published the element via DataStream::pushShared(), this will
+     * not copy the element data, but merely hand out another reference to it.
+     * Elements that were pushed by value are moved into a new shared payload.
+     *
+     * @return The obtained value, or nullptr in case the stream ended.
+     */
+    std::shared_ptr<const T> nextShared()
+    {
+        if (!m_active && approxPendingCount() == 0)
+            return nullptr;
+        Envelope item;
+        waitDequeue(item);
+        return takeShared(std::move(item));
+    }
+
+    /**
+     * @brief Obtain the next element as shared payload if there is any, otherwise return nullptr
+     * This is the non-blocking variant of nextShared().
+     */
+    std::shared_ptr<const T> peekNextShared()
+    {
+        if (!m_active && approxPendingCount() == 0)
+            return nullptr;
+        Envelope item;
+
+        if (!tryDequeue(item))
+            return nullptr;
+
+        return takeShared(std::move(item));
     }
 
     /**
@@ -185,14 +283,100 @@ public:
      */
     bool callIfNextVar(const ProcessVarFn &fn) override
     {
-        auto res = peekNext();
-        if (res.has_value()) {
-            fn(res.value());
+        Envelope item;
+        if (!tryDequeue(item))
+            return false;
+
+        // shared payloads can be passed on directly, without creating a copy
+        if (const auto value = valuePtr(item); value != nullptr) {
+            fn(*value);
             return true;
         }
         return false;
     }
 
+    /**
+     * @brief Call function on all pending elements
+     * @param fn The function to call for each element.
+     * @param maxItems Maximum number of elements to process, or 0 to process all currently pending elements.
+     * @return The number of processed elements.
+     *
+     * This is the variant-type equivalent of drainInto().
+     */
+    size_t callForPendingVar(const ProcessVarFn &fn, size_t maxItems = 0) override
+    {
+        return drainInto(fn, maxItems);
+    }
+
+    /**
+     * @brief Obtain multiple elements from the stream at once
+     * @param out Vector to append the retrieved elements to.
+     * @param maxItems Maximum number of elements to retrieve.
+     * @param timeout Time to wait for the first element to arrive. Negative values block indefinitely,
+     *                a value of zero returns immediately if nothing is pending.
+     * @return Number of elements appended to out. Zero if the timeout expired or the stream has ended,
+     *         check active() to find out whether the stream is still running.
+     *
+     * Retrieving elements in batches is more efficient than calling next() repeatedly,
+     * as synchronization with the producer happens only once per batch.
+     */
+    size_t nextBatch(std::vector<T> &out, size_t maxItems, const microseconds_t &timeout = microseconds_t(-1))
+    {
+        if (maxItems == 0 || (!m_active && approxPendingCount() == 0))
+            return 0;
+
+        const auto count = dequeueBatch(maxItems, timeout.count());
+        size_t added = 0;
+        for (size_t i = 0; i < count; ++i) {
+            auto value = takeValue(std::move(m_batchBuf[i]));
+            m_batchBuf[i] = Envelope();
+            if (!value.has_value())
+                continue; // end-of-stream marker
+            out.push_back(std::move(value.value()));
+            added++;
+        }
+
+        return added;
+    }
+
+    /**
+     * @brief Process pending elements in bulk, without blocking
+     * @param fn Callable which is invoked with a const reference to each element.
+     * @param maxItems Maximum number of elements to process, or 0 to process all elements that
+     *                 were pending when this function was called.
+     * @return Number of elements passed to the callback. End-of-stream markers are not counted.
+     *
+     * Elements are passed to the callback without being copied, so this is the most efficient
+     * way to consume bursts of data. This function must not be called recursively from the callback.
+     */
+    template<typename Fn>
+    size_t drainInto(Fn &&fn, size_t maxItems = 0)
+    {
+        constexpr size_t chunkSize = 64;
+        if (maxItems == 0)
+            maxItems = std::max<size_t>(approxPendingCount(), 1);
+
+        size_t total = 0;
+        size_t processed = 0;
+        while (total < maxItems) {
+            const auto chunk = std::min(chunkSize, maxItems - total);
+            const auto count = dequeueBatch(chunk, 0);
+            for (size_t i = 0; i < count; ++i) {
+                if (const auto value = valuePtr(m_batchBuf[i]); value != nullptr) {
+                    fn(*value);
+                    processed++;
+                }
+                m_batchBuf[i] = Envelope();
+            }
+
+            total += count;
+            if (count < chunk)
+                break;
+        }
+
+        return processed;
+    }
+
     int dataTypeId() const override
     {
         return syDataTypeId<T>();
@@ -257,6 +441,63 @@ public:
         m_notify = false;
     }
 
+    /**
+     * @brief Select how often the eventfd is signalled about new data
+     * @param mode The notification mode.
+     * @param minBatch Minimum number of pending elements before signalling (Batched mode only).
+     * @param maxLatency Maximum time to hold back a notification (Batched mode only).
+     *
+     * In the default PerItem mode, every new element results in the eventfd being written to.
+     * For high-rate streams of small elements this is expensive, so in Coalesced mode only the
+     * first element after the consumer has drained the queue triggers a notification.
+     * Consumers using a non-PerItem mode must therefore keep fetching data until the queue
+     * was found empty, and event loops should keep dispatching while hasPending() is true.
+     * In Batched mode, the event loop should additionally wake up after notifyMaxLatency()
+     * to fetch data that was not explicitly signalled.
+     */
+    void setNotifyMode(
+        SubscriptionNotifyMode mode,
+        size_t minBatch = 1,
+        const microseconds_t &maxLatency = microseconds_t(0)) override
+    {
+        m_notifyMinBatch = std::max<size_t>(minBatch, 1);
+        m_notifyMaxLatencyUsec = maxLatency.count();
+        m_notifyArmed = true;
+        m_notifyMode = mode;
+    }
+
+    SubscriptionNotifyMode notifyMode() const override
+    {
+        return m_notifyMode;
+    }
+
+    /**
+     * @brief Request an eventfd notification for the next element
+     *
+     * In coalescing notify modes, the producer only signals the eventfd once until
+     * the consumer requests a new notification. This happens implicitly when the consumer
+     * finds the queue empty, but event loops should call this explicitly before waiting
+     * on the eventfd.
+     * @return True if data is already pending, in which case the caller must not wait for a notification.
+     */
+    bool armNotify() override
+    {
+        if (m_notifyMode != SubscriptionNotifyMode::PerItem && !m_notifyArmed.load()) {
+            m_batchStartUsec = 0;
+            m_notifyArmed = true;
+        }
+
+        // pairs with the fence in notifyNewItem(): Either the producer sees the armed flag,
+        // or we see the element it enqueued before checking it
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return hasPending();
+    }
+
+    microseconds_t notifyMaxLatency() const override
+    {
+        return microseconds_t(m_notifyMaxLatencyUsec);
+    }
+
     /**
      * @brief Stop receiving data, but do not unsubscribe from the stream
      */
@@ -264,10 +505,10 @@ public:
     {
         // suspend receiving new data
         m_suspended = true;
+        updateRingGating();
 
         // drop currently pending data
-        while (m_queue.pop()) {
-        }
+        dropPending();
     }
 
     /**
@@ -275,6 +516,13 @@ public:
      */
     void resume() override
     {
+        if (m_ring) {
+            // skip everything published while we were suspended before gating the producer again
+            m_cursor->position = m_ring->head();
+            m_suspended = false;
+            updateRingGating();
+            return;
+        }
         m_suspended = false;
     }
 
@@ -284,19 +532,43 @@ public:
     void clearPending() override
     {
         m_suspended = true;
-        while (m_queue.pop()) {
-        }
+        dropPending();
         m_suspended = false;
     }
 
+    /**
+     * @brief Approximate number of elements waiting to be processed
+     *
+     * For subscriptions to a stream using the shared ring backend, this is the
+     * distance of this subscription's read position to the ring's write position.
+     */
     size_t approxPendingCount() const override
     {
+        if (m_ring) {
+            if (m_suspended)
+                return 0;
+            const auto lag = m_ring->head() - m_cursor->position.load();
+            if (m_policy == BackpressurePolicy::KeepLatest)
+                return std::min<size_t>(lag, 1);
+            return std::min<size_t>(lag, m_ring->capacity());
+        }
         return m_queue.size_approx();
     }
 
+    /**
+     * @brief Approximate amount of memory used by the elements waiting to be processed
+     *
+     * This is estimated from the size of recently pushed elements, as reported
+     * by their memorySize() method.
+     */
+    size_t approxPendingBytes() const override
+    {
+        return approxPendingCount() * m_itemBytes.load(std::memory_order_relaxed);
+    }
+
     bool hasPending() const override
     {
-        return m_queue.size_approx() > 0;
+        return approxPendingCount() > 0;
     }
 
     uint throttleValue() const
@@ -304,6 +576,62 @@ public:
         return m_throttle;
     }
 
+    /**
+     * @brief Limit the amount of elements that can be pending in this subscription
+     * @param capacity Maximum number of queued elements, or 0 for an unbounded queue.
+     * @param policy What to do when a new element arrives while the queue is full.
+     *
+     * By default, subscriptions are unbounded and will grow until the consumer
+     * catches up again (or the system runs out of memory).
+     * A bounded subscription preallocates its queue and never allocates memory
+     * when new data is pushed.
+     * Elements discarded due to the selected policy are counted as skipped elements,
+     * and (unless KeepLatest is selected) also increase droppedElementCount().
+     *
+     * If the stream uses a shared ring backend, the ring capacity limits the amount of pending
+     * elements instead, and the policy decides whether this subscription may hold back the producer
+     * (BlockProducer) or gets overrun and skips elements if it falls behind (all other policies).
+     *
+     * The queue capacity can only be changed while the stream is not running.
+     * @return True if the new limit was applied.
+     */
+    bool setQueueCapacity(size_t capacity, BackpressurePolicy policy) override
+    {
+        if (m_stream != nullptr && m_stream->active()) {
+            qWarning().noquote() << "Can not change queue capacity of an active" << dataTypeName() << "subscription.";
+            return false;
+        }
+
+        if (policy == BackpressurePolicy::KeepLatest)
+            capacity = 1;
+
+        m_capacity = capacity;
+        m_policy = policy;
+        m_queue = BlockingReaderWriterQueue<Envelope>(capacity > 0 ? capacity : 256);
+        updateRingGating();
+        return true;
+    }
+
+    size_t queueCapacity() const override
+    {
+        if (m_ring)
+            return m_policy == BackpressurePolicy::KeepLatest ? 1 : m_ring->capacity();
+        return m_capacity;
+    }
+
+    BackpressurePolicy backpressurePolicy() const override
+    {
+        return m_policy;
+    }
+
+    /**
+     * @brief Total number of elements lost due to the queue overflow policy since the stream was started
+     */
+    size_t droppedElementCount() const override
+    {
+        return m_droppedElements;
+    }
+
     uint retrieveApproxSkippedElements()
     {
         const uint si = m_skippedElements;
@@ -345,19 +673,59 @@ public:
 
     void forcePushNullopt() override
     {
-        std::optional<T> v;
-        m_queue.enqueue(v);
+        if (m_ring) {
+            // the marker is delivered only after everything that was published before it
+            m_forcedEndPosition = m_ring->head();
+            m_forcedEndMarkers++;
+            m_ring->wakeReaders();
+            return;
+        }
+        m_queue.enqueue(Envelope());
     }
 
 private:
+    /**
+     * Queue element: Either an end-of-stream marker, a value owned by this
+     * subscription, or a reference to an immutable payload shared with other subscribers.
+     */
+    using Envelope = std::variant<std::monostate, T, std::shared_ptr<const T>>;
+
     DataStream<T> *m_stream;
-    BlockingReaderWriterQueue<std::optional<T>> m_queue;
+    BlockingReaderWriterQueue<Envelope> m_queue;
+    size_t m_capacity;
+    BackpressurePolicy m_policy;
+    std::mutex m_evictMutex;
+    std::atomic_bool m_producerWaiting;
+    std::atomic_bool m_consumerWaiting;
+    spsc_sema::LightweightSemaphore m_slotFreedSema;
+    spsc_sema::LightweightSemaphore m_itemAddedSema;
     int m_eventfd;
     std::atomic_bool m_notify;
+    std::atomic<SubscriptionNotifyMode> m_notifyMode;
+    std::atomic_bool m_notifyArmed;
+    std::atomic_size_t m_notifyMinBatch;
+    std::atomic_int64_t m_notifyMaxLatencyUsec;
+    std::atomic_int64_t m_batchStartUsec;
     std::atomic_bool m_active;
     std::atomic_bool m_suspended;
     std::atomic_uint m_throttle;
     std::atomic_uint m_skippedElements;
+    std::atomic_size_t m_droppedElements;
+    std::vector<Envelope> m_batchBuf;
+
+    // only set if the stream uses a shared ring instead of per-subscription queues
+    std::shared_ptr<BroadcastRing<T>> m_ring;
+    std::shared_ptr<typename BroadcastRing<T>::Cursor> m_cursor;
+    std::atomic_uint m_forcedEndMarkers;
+    std::atomic_uint64_t m_forcedEndPosition;
+    int64_t m_lastRingItemUsec;
+
+    // name of the queue depth counter in traces, only set if tracing was enabled when the stream started
+    const char *m_traceQueueName;
+
+    // approximate memory size of a single element, sampled by the producer
+    std::atomic_size_t m_itemBytes;
+    uint m_sizeSampleCounter;
 
     // NOTE: These two variables are intentionally *not* threadsafe and are
     // only ever manipulated by the stream (in case of the time) or only
@@ -370,11 +738,394 @@ private:
         m_metadata = metadata;
     }
 
-    void push(const T &data)
+    void prepareTracing(size_t index)
+    {
+        if (!Tracing::isEnabled()) {
+            m_traceQueueName = nullptr;
+            return;
+        }
+
+        const auto keyMap = _commonMetadataKeyMap();
+        const auto srcModName = m_metadata.value(keyMap->value(CommonMetadataKey::SrcModName)).toString();
+        const auto portTitle = m_metadata.value(keyMap->value(CommonMetadataKey::SrcModPortTitle)).toString();
+        m_traceQueueName = Tracing::internName(
+            QStringLiteral("queue: %1 [%2] #%3").arg(srcModName, portTitle).arg(index));
+    }
+
+    /**
+     * True if the producer may remove elements from the queue, in which case
+     * all consumer-side queue operations need to be serialized.
+     */
+    bool producerEvicts() const
+    {
+        return m_capacity > 0
+               && (m_policy == BackpressurePolicy::DropOldest || m_policy == BackpressurePolicy::KeepLatest);
+    }
+
+    void onSlotFreed()
+    {
+        if (m_policy == BackpressurePolicy::BlockProducer && m_producerWaiting.exchange(false))
+            m_slotFreedSema.signal();
+    }
+
+    /**
+     * Attach this subscription to the shared ring of its stream, or detach it
+     * from the ring if nullptr is passed.
+     */
+    void attachRing(const std::shared_ptr<BroadcastRing<T>> &ring)
+    {
+        if (m_ring)
+            m_ring->removeReader(m_cursor);
+        m_cursor.reset();
+        m_ring = ring;
+        if (m_ring) {
+            m_cursor = m_ring->addReader();
+            updateRingGating();
+        }
+    }
+
+    /**
+     * Only subscriptions that must not lose data hold back the ring producer, and
+     * only as long as they are actually receiving data.
+     */
+    void updateRingGating()
+    {
+        if (!m_ring)
+            return;
+        m_cursor->gating = m_policy == BackpressurePolicy::BlockProducer && m_active && !m_suspended;
+        m_ring->readerAdvanced();
+    }
+
+    /**
+     * Read up to maxItems elements from the shared ring, applying the throttle
+     * and overflow policy of this subscription.
+     */
+    size_t ringRead(Envelope *out, size_t maxItems)
+    {
+        if (maxItems == 0)
+            return 0;
+        if (m_suspended) {
+            m_cursor->position = m_ring->head();
+            return takeForcedEndMarker(m_cursor->position.load(), out) ? 1 : 0;
+        }
+
+        const auto startPos = m_cursor->position.load();
+        auto pos = startPos;
+        size_t count = 0;
+        std::shared_ptr<const T> value;
+        int64_t timestampUsec;
+        while (count < maxItems) {
+            const auto head = m_ring->head();
+            if (pos >= head)
+                break;
+
+            // skip elements that were already overwritten, or that we are not interested in
+            uint64_t first = head > m_ring->capacity() ? head - m_ring->capacity() : 0;
+            if (m_policy == BackpressurePolicy::KeepLatest)
+                first = head - 1;
+            if (pos < first) {
+                m_skippedElements += first - pos;
+                if (m_policy != BackpressurePolicy::KeepLatest)
+                    m_droppedElements += first - pos;
+                pos = first;
+            }
+            if (m_forcedEndMarkers > 0 && pos >= m_forcedEndPosition.load())
+                break; // data published after a forced end marker is read once the marker was delivered
+
+            if (!m_ring->read(pos, value, timestampUsec))
+                continue; // the producer overwrote this element while we were reading it
+            pos++;
+
+            if (m_throttle != 0) {
+                if (timestampUsec - m_lastRingItemUsec < m_throttle) {
+                    m_skippedElements++;
+                    continue;
+                }
+                m_lastRingItemUsec = timestampUsec;
+            }
+            out[count++] = Envelope(std::move(value));
+        }
+
+        if (pos != startPos) {
+            // never move the cursor backwards, in case pending data was dropped concurrently
+            auto expected = startPos;
+            m_cursor->position.compare_exchange_strong(expected, pos);
+            m_ring->readerAdvanced();
+        }
+
+        if (count < maxItems && takeForcedEndMarker(pos, out + count))
+            count++;
+
+        return count;
+    }
+
+    /**
+     * Emit a pending forced end marker, once the reader at position pos has
+     * consumed all data that was published before the marker was forced.
+     */
+    bool takeForcedEndMarker(uint64_t pos, Envelope *out)
+    {
+        if (m_forcedEndMarkers == 0 || pos < m_forcedEndPosition.load())
+            return false;
+        m_forcedEndMarkers--;
+        *out = Envelope();
+        return true;
+    }
+
+    bool ringWaitDequeue(Envelope &item, int64_t timeoutUsec)
+    {
+        const auto startTime = currentTimePoint();
+        while (true) {
+            if (tryDequeue(item))
+                return true;
+            if (!m_active) {
+                // check once more, in case data was published right before the stream was stopped
+                if (!tryDequeue(item))
+                    item = Envelope();
+                return true;
+            }
+
+            int64_t waitUsec = -1;
+            if (timeoutUsec >= 0) {
+                waitUsec = timeoutUsec - timeDiffUsec(currentTimePoint(), startTime).count();
+                if (waitUsec <= 0)
+                    return false;
+            }
+            m_ring->waitUntil(waitUsec, [this] {
+                return m_ring->head() > m_cursor->position.load() || !m_active || m_forcedEndMarkers > 0;
+            });
+        }
+    }
+
+    bool tryDequeueUnchecked(Envelope &item)
+    {
+        if (m_ring)
+            return ringRead(&item, 1) == 1;
+        if (producerEvicts()) {
+            std::lock_guard<std::mutex> lock(m_evictMutex);
+            return m_queue.try_dequeue(item);
+        }
+        return m_queue.try_dequeue(item);
+    }
+
+    bool tryDequeue(Envelope &item)
+    {
+        bool success = tryDequeueUnchecked(item);
+        if (!success && m_notifyMode != SubscriptionNotifyMode::PerItem && armNotify())
+            success = tryDequeueUnchecked(item);
+        if (!success)
+            return false;
+
+        if (m_capacity > 0)
+            onSlotFreed();
+        SY_TRACE_COUNTER(m_traceQueueName, approxPendingCount());
+        return true;
+    }
+
+    bool waitDequeue(Envelope &item, int64_t timeoutUsec = -1)
+    {
+        if (m_ring)
+            return ringWaitDequeue(item, timeoutUsec);
+
+        if (!producerEvicts()) {
+            bool success = true;
+            if (timeoutUsec < 0)
+                m_queue.wait_dequeue(item);
+            else
+                success = m_queue.wait_dequeue_timed(item, timeoutUsec);
+            if (!success)
+                return false;
+
+            if (m_capacity > 0)
+                onSlotFreed();
+            SY_TRACE_COUNTER(m_traceQueueName, approxPendingCount());
+            return true;
+        }
+
+        // the producer may evict elements, so we can not block on the queue directly
+        // and instead wait for it to tell us about new data
+        const auto startTime = currentTimePoint();
+        while (true) {
+            m_consumerWaiting = true;
+            if (tryDequeue(item)) {
+                m_consumerWaiting = false;
+                return true;
+            }
+
+            int64_t waitUsec = 100 * 1000;
+            if (timeoutUsec >= 0) {
+                const auto remainingUsec = timeoutUsec - timeDiffUsec(currentTimePoint(), startTime).count();
+                if (remainingUsec <= 0) {
+                    m_consumerWaiting = false;
+                    return false;
+                }
+                waitUsec = std::min(waitUsec, remainingUsec);
+            }
+            m_itemAddedSema.wait(waitUsec);
+        }
+    }
+
+    /**
+     * Dequeue up to maxItems elements into the batch buffer. Waits up to timeoutUsec
+     * for the first element (0 does not wait, negative values wait indefinitely).
+     */
+    size_t dequeueBatch(size_t maxItems, int64_t timeoutUsec)
+    {
+        if (m_batchBuf.size() < maxItems)
+            m_batchBuf.resize(maxItems);
+
+        size_t count;
+        if (m_ring) {
+            count = ringRead(m_batchBuf.data(), maxItems);
+            if (count == 0 && timeoutUsec != 0 && waitDequeue(m_batchBuf[0], timeoutUsec))
+                count = 1 + ringRead(m_batchBuf.data() + 1, maxItems - 1);
+            if (count == 0 && timeoutUsec == 0 && m_notifyMode != SubscriptionNotifyMode::PerItem && armNotify())
+                count = ringRead(m_batchBuf.data(), maxItems);
+            return count;
+        }
+
+        if (producerEvicts()) {
+            {
+                std::lock_guard<std::mutex> lock(m_evictMutex);
+                count = m_queue.try_dequeue_bulk(m_batchBuf.begin(), maxItems);
+            }
+            if (count == 0 && timeoutUsec != 0 && waitDequeue(m_batchBuf[0], timeoutUsec)) {
+                std::lock_guard<std::mutex> lock(m_evictMutex);
+                count = 1 + m_queue.try_dequeue_bulk(m_batchBuf.begin() + 1, maxItems - 1);
+            }
+        } else {
+            if (timeoutUsec == 0)
+                count = m_queue.try_dequeue_bulk(m_batchBuf.begin(), maxItems);
+            else
+                count = m_queue.wait_dequeue_bulk_timed(m_batchBuf.begin(), maxItems, timeoutUsec);
+        }
+
+        if (count == 0 && timeoutUsec == 0 && m_notifyMode != SubscriptionNotifyMode::PerItem && armNotify()) {
+            if (producerEvicts()) {
+                std::lock_guard<std::mutex> lock(m_evictMutex);
+                count = m_queue.try_dequeue_bulk(m_batchBuf.begin(), maxItems);
+            } else {
+                count = m_queue.try_dequeue_bulk(m_batchBuf.begin(), maxItems);
+            }
+        }
+
+        if (count > 0 && m_capacity > 0)
+            onSlotFreed();
+        return count;
+    }
+
+    void dropPending()
+    {
+        if (m_ring) {
+            m_cursor->position = m_ring->head();
+            m_ring->readerAdvanced();
+            return;
+        }
+
+        if (producerEvicts()) {
+            std::lock_guard<std::mutex> lock(m_evictMutex);
+            while (m_queue.pop()) {
+            }
+        } else {
+            while (m_queue.pop()) {
+            }
+        }
+
+        if (m_capacity > 0)
+            onSlotFreed();
+    }
+
+    /**
+     * Enqueue a new element, respecting the queue capacity and overflow policy
+     * of this subscription.
+     */
+    bool enqueueItem(Envelope &&item)
+    {
+        if (m_capacity == 0) {
+            m_queue.enqueue(std::move(item));
+            return true;
+        }
+
+        switch (m_policy) {
+        case BackpressurePolicy::DropNewest:
+            if (m_queue.size_approx() >= m_capacity || !m_queue.try_enqueue(std::move(item))) {
+                m_skippedElements++;
+                m_droppedElements++;
+                return false;
+            }
+            return true;
+
+        case BackpressurePolicy::BlockProducer:
+            while (m_queue.size_approx() >= m_capacity || !m_queue.try_enqueue(std::move(item))) {
+                // give up if nobody is going to consume the data anymore
+                if (m_suspended || !m_active) {
+                    m_skippedElements++;
+                    m_droppedElements++;
+                    return false;
+                }
+
+                m_producerWaiting = true;
+                if (m_queue.size_approx() < m_capacity && m_queue.try_enqueue(std::move(item))) {
+                    m_producerWaiting = false;
+                    return true;
+                }
+                m_slotFreedSema.wait(10 * 1000);
+            }
+            return true;
+
+        case BackpressurePolicy::DropOldest:
+        case BackpressurePolicy::KeepLatest:
+            while (m_queue.size_approx() >= m_capacity || !m_queue.try_enqueue(std::move(item))) {
+                std::lock_guard<std::mutex> lock(m_evictMutex);
+                if (m_queue.pop()) {
+                    // superseding elements is the whole point of keep-latest mode, so we
+                    // only consider this a data loss in drop-oldest mode
+                    m_skippedElements++;
+                    if (m_policy == BackpressurePolicy::DropOldest)
+                        m_droppedElements++;
+                }
+            }
+
+            if (m_consumerWaiting.exchange(false))
+                m_itemAddedSema.signal();
+            return true;
+        }
+
+        return false;
+    }
+
+    static const T *valuePtr(const Envelope &item)
+    {
+        if (const auto value = std::get_if<T>(&item))
+            return value;
+        if (const auto shared = std::get_if<std::shared_ptr<const T>>(&item))
+            return shared->get();
+        return nullptr;
+    }
+
+    static std::optional<T> takeValue(Envelope &&item)
+    {
+        if (auto value = std::get_if<T>(&item))
+            return std::move(*value);
+        if (const auto shared = std::get_if<std::shared_ptr<const T>>(&item))
+            return **shared;
+        return std::nullopt;
+    }
+
+    static std::shared_ptr<const T> takeShared(Envelope &&item)
+    {
+        if (auto shared = std::get_if<std::shared_ptr<const T>>(&item))
+            return std::move(*shared);
+        if (auto value = std::get_if<T>(&item))
+            return std::make_shared<const T>(std::move(*value));
+        return nullptr;
+    }
+
+    bool acceptsNewItem()
     {
         // don't accept any new data if we are suspended
         if (m_suspended)
-            return;
+            return false;
 
         // check if we can throttle the enqueueing speed of data
         if (m_throttle != 0) {
@@ -382,27 +1133,115 @@ private:
             const auto durUsec = timeDiffUsec(timeNow, m_lastItemTime);
             if (durUsec.count() < m_throttle) {
                 m_skippedElements++;
-                return;
+                return false;
             }
             m_lastItemTime = timeNow;
         }
 
-        // actually send the data to the subscriber
-        m_queue.enqueue(std::optional<T>(data));
+        return true;
+    }
+
+    void notifyNewItem()
+    {
+        if (!m_notify)
+            return;
+
+        const auto mode = m_notifyMode.load();
+        if (mode != SubscriptionNotifyMode::PerItem) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            // nothing to do if the consumer still knows that there is pending data
+            if (!m_notifyArmed.load())
+                return;
+
+            if (mode == SubscriptionNotifyMode::Batched) {
+                const int64_t nowUsec = std::chrono::duration_cast<microseconds_t>(
+                                            currentTimePoint().time_since_epoch())
+                                            .count();
+                int64_t expected = 0;
+                m_batchStartUsec.compare_exchange_strong(expected, nowUsec);
+                if (approxPendingCount() < m_notifyMinBatch
+                    && (nowUsec - m_batchStartUsec.load()) < m_notifyMaxLatencyUsec)
+                    return;
+            }
+
+            // only the first element after the consumer has drained the queue gets a notification
+            if (!m_notifyArmed.exchange(false))
+                return;
+        }
 
         // ping the eventfd, in case anyone is listening for messages
-        if (m_notify) {
-            const uint64_t buffer = 1;
-            if (write(m_eventfd, &buffer, sizeof(buffer)) == -1)
-                qWarning().noquote() << "Unable to write to eventfd in" << dataTypeName()
-                                     << "data subscription. FD:" << m_eventfd << "Error:" << std::strerror(errno);
+        const uint64_t buffer = 1;
+        if (write(m_eventfd, &buffer, sizeof(buffer)) == -1)
+            qWarning().noquote() << "Unable to write to eventfd in" << dataTypeName()
+                                 << "data subscription. FD:" << m_eventfd << "Error:" << std::strerror(errno);
+    }
+
+    /**
+     * Remember the approximate memory size of the elements of this subscription.
+     * Only every 16th element is measured, which is enough to follow changes in element size.
+     */
+    void sampleItemSize(const T &data)
+    {
+        if ((m_sizeSampleCounter++ % 16) != 0)
+            return;
+        const auto memSize = data.memorySize();
+        m_itemBytes.store(memSize > 0 ? static_cast<size_t>(memSize) : sizeof(T), std::memory_order_relaxed);
+    }
+
+    void push(const T &data)
+    {
+        if (!acceptsNewItem())
+            return;
+        sampleItemSize(data);
+
+        // actually send the data to the subscriber
+        if (enqueueItem(Envelope(std::in_place_type<T>, data))) {
+            SY_TRACE_COUNTER(m_traceQueueName, approxPendingCount());
+            notifyNewItem();
+        }
+    }
+
+    void push(T &&data)
+    {
+        if (!acceptsNewItem())
+            return;
+        sampleItemSize(data);
+
+        // the element is owned by this subscription from now on, so no copy is needed
+        if (enqueueItem(Envelope(std::in_place_type<T>, std::move(data)))) {
+            SY_TRACE_COUNTER(m_traceQueueName, approxPendingCount());
+            notifyNewItem();
+        }
+    }
+
+    void pushShared(const std::shared_ptr<const T> &data)
+    {
+        if (!acceptsNewItem())
+            return;
+        sampleItemSize(*data);
+
+        // only the reference is enqueued, the payload is shared between all subscribers
+        if (enqueueItem(Envelope(data))) {
+            SY_TRACE_COUNTER(m_traceQueueName, approxPendingCount());
+            notifyNewItem();
         }
     }
 
     void stop()
     {
         m_active = false;
-        m_queue.enqueue(std::nullopt);
+
+        // the ring wakes up all of its readers itself once it is stopped
+        if (m_ring) {
+            updateRingGating();
+            return;
+        }
+
+        // the end-of-stream marker is always enqueued, even if that exceeds the queue capacity
+        m_queue.enqueue(Envelope());
+        if (m_consumerWaiting.exchange(false))
+            m_itemAddedSema.signal();
     }
 
     void reset()
@@ -411,8 +1250,13 @@ private:
         m_active = true;
         m_throttle = 0;
         m_lastItemTime = currentTimePoint();
-        while (m_queue.pop()) {
-        } // ensure the queue is empty
+        m_lastRingItemUsec = 0;
+        m_sizeSampleCounter = 0;
+        m_droppedElements = 0;
+        m_forcedEndMarkers = 0;
+        m_forcedEndPosition = 0;
+        updateRingGating();
+        dropPending(); // ensure the queue is empty
     }
 };
 
@@ -421,7 +1265,9 @@ class DataStream : public VariantDataStream
 {
 public:
     DataStream()
-        : m_active(false)
+        : m_active(false),
+          m_backend(StreamBackend::SubscriberQueues),
+          m_tracePushName(nullptr)
     {
         m_ownerId = std::this_thread::get_id();
     }
@@ -483,6 +1329,8 @@ public:
         std::lock_guard<std::mutex> lock(m_mutex);
         std::shared_ptr<StreamSubscription<T>> sub(new StreamSubscription<T>(this));
         sub->setMetadata(m_metadata);
+        if (m_ring)
+            sub->attachRing(m_ring);
         m_subs.push_back(sub);
         return sub;
     }
@@ -501,6 +1349,7 @@ public:
         std::lock_guard<std::mutex> lock(m_mutex);
         for (uint i = 0; i < m_subs.size(); i++) {
             if (m_subs.at(i).get() == sub) {
+                sub->attachRing(nullptr);
                 m_subs.erase(m_subs.begin() + i);
                 return true;
             }
@@ -509,13 +1358,57 @@ public:
         return false;
     }
 
+    /**
+     * @brief Select how data is distributed to the subscribers of this stream
+     * @param backend The backend to use.
+     * @param ringCapacity Number of elements the shared ring can hold (rounded up to a power of two),
+     *                     or 0 to use a default size.
+     *
+     * By default, every subscription has its own queue, so pushing an element costs one
+     * enqueue (and one copy, unless pushShared() is used) per subscriber.
+     * With the SharedRing backend, every element is written exactly once into a fixed-size
+     * ring, and subscriptions read from it at their own pace. Subscriptions using the
+     * BlockProducer policy (the default) make the producer wait if they fall behind by more
+     * than the ring capacity, subscriptions with any other policy are overrun instead.
+     *
+     * The backend can only be changed while the stream is not running.
+     * @return True if the backend was changed.
+     */
+    bool setBackend(StreamBackend backend, size_t ringCapacity = 0) override
+    {
+        if (m_active) {
+            qWarning().noquote() << "Can not change the backend of an active" << dataTypeName() << "stream.";
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_backend = backend;
+        if (backend == StreamBackend::SharedRing)
+            m_ring = std::make_shared<BroadcastRing<T>>(ringCapacity > 0 ? ringCapacity : 1024);
+        else
+            m_ring.reset();
+
+        for (auto const &sub : m_subs)
+            sub->attachRing(m_ring);
+        return true;
+    }
+
+    StreamBackend backend() const override
+    {
+        return m_backend;
+    }
+
     void start() override
     {
         m_ownerId = std::this_thread::get_id();
-        for (auto const &sub : m_subs) {
-            sub->reset();
-            sub->setMetadata(m_metadata);
+        if (m_ring)
+            m_ring->reset();
+        for (size_t i = 0; i < m_subs.size(); i++) {
+            m_subs[i]->reset();
+            m_subs[i]->setMetadata(m_metadata);
+            m_subs[i]->prepareTracing(i);
         }
+        prepareTracing();
         m_active = true;
     }
 
@@ -523,6 +1416,8 @@ public:
     {
         for (auto const &sub : m_subs)
             sub->stop();
+        if (m_ring)
+            m_ring->stop();
         m_active = false;
     }
 
@@ -530,10 +1425,37 @@ public:
     {
         if (!m_active)
             return;
+        SY_TRACE_SCOPE(m_tracePushName);
+        if (m_ring) {
+            publishToRing(std::make_shared<const T>(data));
+            return;
+        }
         for (auto &sub : m_subs)
             sub->push(data);
     }
 
+    /**
+     * @brief Push an immutable, reference-counted element to all subscribers
+     *
+     * Unlike push(), this does not copy the element for every subscriber, fanning
+     * out data only costs one reference count increment per subscription.
+     * The data must not be modified after it was pushed.
+     * Subscribers can retrieve the element without copying via StreamSubscription::nextShared(),
+     * while next() continues to work and will return a copy of the data.
+     */
+    void pushShared(const std::shared_ptr<const T> &data)
+    {
+        if (!m_active || data == nullptr)
+            return;
+        SY_TRACE_SCOPE(m_tracePushName);
+        if (m_ring) {
+            publishToRing(data);
+            return;
+        }
+        for (auto &sub : m_subs)
+            sub->pushShared(data);
+    }
+
     void pushRawData(int typeId, const void *data, size_t size) override
     {
         if (!m_active)
@@ -543,9 +1465,14 @@ public:
             return;
         }
 
-        const T &entity = T::fromMemory(data, size);
-        for (auto &sub : m_subs)
-            sub->push(entity);
+        if (m_subs.size() == 1 && !m_ring) {
+            // a single subscriber can take ownership of the deserialized element directly
+            m_subs.front()->push(T::fromMemory(data, size));
+            return;
+        }
+
+        // deserialize once and share the result with all subscribers
+        pushShared(std::make_shared<const T>(T::fromMemory(data, size)));
     }
 
     void terminate()
@@ -575,4 +1502,40 @@ private:
     std::mutex m_mutex;
     std::vector<std::shared_ptr<StreamSubscription<T>>> m_subs;
     QHash<QString, QVariant> m_metadata;
+    StreamBackend m_backend;
+    std::shared_ptr<BroadcastRing<T>> m_ring;
+    const char *m_tracePushName;
+
+    void prepareTracing()
+    {
+        if (!Tracing::isEnabled()) {
+            m_tracePushName = nullptr;
+            return;
+        }
+
+        const auto keyMap = _commonMetadataKeyMap();
+        const auto srcModName = m_metadata.value(keyMap->value(CommonMetadataKey::SrcModName)).toString();
+        const auto portTitle = m_metadata.value(keyMap->value(CommonMetadataKey::SrcModPortTitle)).toString();
+        m_tracePushName = Tracing::internName(QStringLiteral("push: %1 [%2]").arg(srcModName, portTitle));
+    }
+
+    void publishToRing(const std::shared_ptr<const T> &data)
+    {
+        if (m_subs.empty())
+            return;
+
+        const int64_t timestampUsec = std::chrono::duration_cast<microseconds_t>(
+                                          currentTimePoint().time_since_epoch())
+                                          .count();
+        if (!m_ring->publish(data, timestampUsec))
+            return;
+
+        // the data itself is only written once, but subscribers may still want to be woken up
+        for (auto &sub : m_subs) {
+            if (!sub->m_suspended) {
+                sub->sampleItemSize(*data);
+                sub->notifyNewItem();
+            }
+        }
+    }
 };
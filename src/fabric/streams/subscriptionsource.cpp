@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2020-2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "subscriptionsource.h"
+
+#include <cerrno>
+#include <unistd.h>
+
+#include "streams/stream.h"
+
+typedef struct {
+    GSource source;
+    int event_fd;
+    gpointer event_fd_tag;
+    VariantStreamSubscription *sub;
+    gint64 pending_since;
+} EFDSignalSource;
+
+static gboolean efd_signal_source_prepare(GSource *source, gint *timeout)
+{
+    EFDSignalSource *efd_source = (EFDSignalSource *)source;
+    *timeout = -1;
+
+    const auto mode = efd_source->sub->notifyMode();
+    if (mode == SubscriptionNotifyMode::PerItem)
+        return FALSE;
+
+    // in coalescing modes we are only notified once per burst of data, so we need to
+    // request a new notification and keep dispatching until everything was processed
+    if (!efd_source->sub->armNotify()) {
+        efd_source->pending_since = 0;
+        return FALSE;
+    }
+    if (mode == SubscriptionNotifyMode::Coalesced)
+        return TRUE;
+
+    // in batched mode, we fetch pending data after the latency window at the latest
+    const auto now = g_source_get_time(source);
+    if (efd_source->pending_since == 0)
+        efd_source->pending_since = now;
+    const auto remainingUsec = efd_source->sub->notifyMaxLatency().count() - (now - efd_source->pending_since);
+    if (remainingUsec <= 0)
+        return TRUE;
+    *timeout = (remainingUsec + 999) / 1000;
+    return FALSE;
+}
+
+static gboolean efd_signal_source_check(GSource *source)
+{
+    EFDSignalSource *efd_source = (EFDSignalSource *)source;
+
+    if (g_source_query_unix_fd(source, efd_source->event_fd_tag) != 0)
+        return TRUE;
+    if (efd_source->pending_since == 0)
+        return FALSE;
+    return (g_source_get_time(source) - efd_source->pending_since) >= efd_source->sub->notifyMaxLatency().count();
+}
+
+static gboolean efd_signal_source_dispatch(GSource *source, GSourceFunc callback, gpointer user_data)
+{
+    EFDSignalSource *efd_source = (EFDSignalSource *)source;
+
+    unsigned events = g_source_query_unix_fd(source, efd_source->event_fd_tag);
+    if (events & G_IO_HUP || events & G_IO_ERR || events & G_IO_NVAL) {
+        return G_SOURCE_REMOVE;
+    }
+
+    gboolean result_continue = G_SOURCE_CONTINUE;
+    if (events & G_IO_IN) {
+        uint64_t buffer;
+        // just read the buffer count for now to empty it
+        // (maybe we can do something useful with the element count later?)
+        if (G_UNLIKELY(read(efd_source->event_fd, &buffer, sizeof(buffer)) == -1 && errno != EAGAIN))
+            qWarning().noquote() << "Failed to read from eventfd:" << g_strerror(errno);
+
+        result_continue = callback(user_data);
+    } else if (efd_source->sub->notifyMode() != SubscriptionNotifyMode::PerItem && efd_source->sub->hasPending()) {
+        // we were not explicitly notified, but still have data to process
+        result_continue = callback(user_data);
+    }
+    efd_source->pending_since = 0;
+    g_source_set_ready_time(source, -1);
+    return result_continue;
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+static GSourceFuncs efd_source_funcs =
+    {.prepare = efd_signal_source_prepare,
+     .check = efd_signal_source_check,
+     .dispatch = efd_signal_source_dispatch,
+     .finalize = NULL};
+#pragma GCC diagnostic pop
+
+GSource *Syntalos::newSubscriptionEventSource(VariantStreamSubscription *sub)
+{
+    auto source = (EFDSignalSource *)g_source_new(&efd_source_funcs, sizeof(EFDSignalSource));
+    const auto event_fd = sub->enableNotify();
+    source->sub = sub;
+    source->pending_since = 0;
+    source->event_fd = event_fd;
+    source->event_fd_tag = g_source_add_unix_fd(
+        (GSource *)source, event_fd, (GIOCondition)(G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL));
+    return (GSource *)source;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2020-2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+class VariantStreamSubscription;
+
+namespace Syntalos
+{
+
+/**
+ * @brief Create a GLib event source that fires when new data arrives on a subscription
+ *
+ * The source listens on the eventfd of the subscription and honors its notification mode,
+ * so in coalesced and batched modes the callback is dispatched once per burst of data
+ * and keeps being dispatched until all pending data was processed.
+ * The subscription must outlive the returned source.
+ */
+GSource *newSubscriptionEventSource(VariantStreamSubscription *sub);
+
+} // namespace Syntalos
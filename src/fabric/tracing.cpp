@@ -0,0 +1,348 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tracing.h"
+
+#include <QHash>
+#include <QSaveFile>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <pthread.h>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <unordered_set>
+
+using namespace Syntalos;
+
+std::atomic_bool Syntalos::Tracing::_enabled(false);
+
+/**
+ * Number of events each thread can buffer before the collector has to drain them.
+ * At 32 bytes per event, this is 1 MiB per tracing thread.
+ */
+static constexpr uint64_t THREAD_BUFFER_CAPACITY = 1 << 15;
+
+namespace
+{
+
+/**
+ * Single-producer/single-consumer ring of trace events owned by one thread.
+ * The owning thread writes, the collector reads.
+ */
+struct ThreadTraceBuffer {
+    ThreadTraceBuffer()
+        : head(0),
+          tail(0),
+          dropped(0),
+          exited(false),
+          events(THREAD_BUFFER_CAPACITY)
+    {
+        tid = static_cast<pid_t>(syscall(SYS_gettid));
+
+        char buf[16] = {0};
+        pthread_getname_np(pthread_self(), buf, sizeof(buf));
+        threadName = QString::fromUtf8(buf);
+    }
+
+    std::atomic_uint64_t head;
+    std::atomic_uint64_t tail;
+    std::atomic_uint64_t dropped;
+    std::atomic_bool exited;
+    std::vector<TraceEvent> events;
+
+    pid_t tid;
+    QString threadName;
+};
+
+/**
+ * All thread buffers, kept alive until the collector has drained
+ * the remaining events of exited threads.
+ */
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadTraceBuffer>> buffers;
+
+    std::mutex namesMutex;
+    std::unordered_set<std::string> names;
+};
+
+TraceRegistry *traceRegistry()
+{
+    // intentionally leaked, threads may still record events during static destruction
+    static auto registry = new TraceRegistry;
+    return registry;
+}
+
+/**
+ * Registers the buffer of a thread on first use, and marks it
+ * as exited once the thread terminates.
+ */
+class ThreadBufferHolder
+{
+public:
+    ThreadBufferHolder()
+        : buffer(std::make_shared<ThreadTraceBuffer>())
+    {
+        auto registry = traceRegistry();
+        std::lock_guard<std::mutex> lock(registry->mutex);
+        registry->buffers.push_back(buffer);
+    }
+
+    ~ThreadBufferHolder()
+    {
+        buffer->exited = true;
+    }
+
+    std::shared_ptr<ThreadTraceBuffer> buffer;
+};
+
+inline ThreadTraceBuffer *currentThreadBuffer()
+{
+    static thread_local ThreadBufferHolder holder;
+    return holder.buffer.get();
+}
+
+} // namespace
+
+void Tracing::setEnabled(bool enabled)
+{
+    _enabled.store(enabled);
+}
+
+const char *Tracing::internName(const QString &name)
+{
+    auto registry = traceRegistry();
+    std::lock_guard<std::mutex> lock(registry->namesMutex);
+
+    // elements of node-based containers never move, so the pointer remains valid
+    return registry->names.insert(name.toStdString()).first->c_str();
+}
+
+void Tracing::recordEvent(char phase, const char *name, int64_t value)
+{
+    if (name == nullptr)
+        return;
+
+    auto buf = currentThreadBuffer();
+    const auto head = buf->head.load(std::memory_order_relaxed);
+    if (head - buf->tail.load(std::memory_order_acquire) >= THREAD_BUFFER_CAPACITY) {
+        // the collector did not keep up, we rather lose events than block a thread
+        buf->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto &ev = buf->events[head % THREAD_BUFFER_CAPACITY];
+    ev.timestampNsec = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now().time_since_epoch())
+                           .count();
+    ev.name = name;
+    ev.value = value;
+    ev.phase = phase;
+    buf->head.store(head + 1, std::memory_order_release);
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+class TraceCollector::Private
+{
+public:
+    Private()
+        : eventCount(0),
+          droppedCount(0)
+    {
+    }
+
+    struct ThreadEvents {
+        QString threadName;
+        std::vector<TraceEvent> events;
+    };
+
+    QHash<pid_t, ThreadEvents> threads;
+    size_t eventCount;
+    uint64_t droppedCount;
+
+    /**
+     * Move all pending events out of the thread buffers, and forget
+     * about the buffers of threads that have exited.
+     */
+    void drain(bool discard)
+    {
+        auto registry = traceRegistry();
+        std::lock_guard<std::mutex> lock(registry->mutex);
+        for (auto it = registry->buffers.begin(); it != registry->buffers.end();) {
+            auto &buf = *it;
+            const bool exited = buf->exited.load();
+            const auto tail = buf->tail.load(std::memory_order_relaxed);
+            const auto head = buf->head.load(std::memory_order_acquire);
+
+            if (!discard && head != tail) {
+                auto &te = threads[buf->tid];
+                te.threadName = buf->threadName;
+                te.events.reserve(te.events.size() + (head - tail));
+                for (auto i = tail; i != head; i++)
+                    te.events.push_back(buf->events[i % THREAD_BUFFER_CAPACITY]);
+                eventCount += head - tail;
+            }
+            buf->tail.store(head, std::memory_order_release);
+
+            const auto dropped = buf->dropped.exchange(0);
+            if (!discard)
+                droppedCount += dropped;
+
+            if (exited)
+                it = registry->buffers.erase(it);
+            else
+                it++;
+        }
+    }
+};
+#pragma GCC diagnostic pop
+
+TraceCollector::TraceCollector()
+    : d(new TraceCollector::Private)
+{
+}
+
+TraceCollector::~TraceCollector() {}
+
+/**
+ * Discard all events that were recorded so far.
+ */
+void TraceCollector::reset()
+{
+    d->drain(true);
+    d->threads.clear();
+    d->eventCount = 0;
+    d->droppedCount = 0;
+}
+
+/**
+ * Fetch all pending events from the per-thread buffers.
+ * This should be called periodically while tracing is enabled,
+ * to prevent the thread buffers from overflowing.
+ */
+void TraceCollector::collect()
+{
+    d->drain(false);
+}
+
+size_t TraceCollector::eventCount() const
+{
+    return d->eventCount;
+}
+
+/**
+ * Number of events which were lost because a thread buffer was full.
+ */
+uint64_t TraceCollector::droppedCount() const
+{
+    return d->droppedCount;
+}
+
+static QByteArray jsonString(const char *str)
+{
+    QByteArray res;
+    res.reserve(static_cast<int>(strlen(str)) + 2);
+    res.append('"');
+    for (const char *c = str; *c != '\0'; c++) {
+        switch (*c) {
+        case '"':
+            res.append("\\\"");
+            break;
+        case '\\':
+            res.append("\\\\");
+            break;
+        case '\n':
+            res.append("\\n");
+            break;
+        case '\t':
+            res.append("\\t");
+            break;
+        default:
+            if (static_cast<unsigned char>(*c) < 0x20)
+                res.append(QStringLiteral("\\u%1").arg(static_cast<int>(*c), 4, 16, QLatin1Char('0')).toLatin1());
+            else
+                res.append(*c);
+        }
+    }
+    res.append('"');
+    return res;
+}
+
+/**
+ * Write all collected events to a JSON file in the Chrome trace event format,
+ * which can be loaded by Perfetto.
+ */
+bool TraceCollector::saveJson(const QString &fname, QString *errorMessage)
+{
+    QSaveFile file(fname);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (errorMessage != nullptr)
+            *errorMessage = file.errorString();
+        return false;
+    }
+
+    const auto pid = QByteArray::number(static_cast<qint64>(getpid()));
+
+    // use the earliest event as time origin, to keep timestamps readable
+    int64_t originNsec = std::numeric_limits<int64_t>::max();
+    for (const auto &te : d->threads) {
+        if (!te.events.empty())
+            originNsec = std::min(originNsec, te.events.front().timestampNsec);
+    }
+
+    file.write("{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":");
+    file.write(QByteArray::number(static_cast<qulonglong>(d->droppedCount)));
+    file.write("},\"traceEvents\":[\n");
+    file.write("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"args\":{\"name\":\"Syntalos\"}}");
+
+    for (auto it = d->threads.constBegin(); it != d->threads.constEnd(); it++) {
+        const auto tid = QByteArray::number(static_cast<qint64>(it.key()));
+        file.write(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid
+                   + ",\"args\":{\"name\":" + jsonString(it->threadName.toUtf8().constData()) + "}}");
+
+        QByteArray line;
+        for (const auto &ev : it->events) {
+            line.clear();
+            line.append(",\n{\"name\":");
+            line.append(jsonString(ev.name));
+            line.append(",\"ph\":\"");
+            line.append(ev.phase);
+            line.append("\",\"ts\":");
+            line.append(QByteArray::number(static_cast<double>(ev.timestampNsec - originNsec) / 1000.0, 'f', 3));
+            line.append(",\"pid\":" + pid + ",\"tid\":" + tid);
+            if (ev.phase == 'C')
+                line.append(",\"args\":{\"value\":" + QByteArray::number(static_cast<qint64>(ev.value)) + "}");
+            line.append('}');
+            file.write(line);
+        }
+    }
+    file.write("\n]}\n");
+
+    if (!file.commit()) {
+        if (errorMessage != nullptr)
+            *errorMessage = file.errorString();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Syntalos
+{
+
+/**
+ * @brief A single recorded trace event
+ */
+struct TraceEvent {
+    int64_t timestampNsec; /// steady-clock timestamp
+    const char *name;      /// static or interned name of the event
+    int64_t value;         /// counter value, unused for begin/end events
+    char phase;            /// 'B' (begin), 'E' (end) or 'C' (counter), as in the Chrome trace format
+};
+
+namespace Tracing
+{
+
+#if !defined(DOXYGEN_SHOULD_SKIP_THIS)
+extern std::atomic_bool _enabled;
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+/**
+ * @brief Check whether trace events are currently recorded.
+ *
+ * This is a single relaxed atomic load, so it is cheap enough to be
+ * called on every hot path.
+ */
+inline bool isEnabled()
+{
+    return _enabled.load(std::memory_order_relaxed);
+}
+
+void setEnabled(bool enabled);
+
+/**
+ * @brief Return a name pointer that stays valid for the lifetime of the process.
+ *
+ * Event names are stored as raw pointers, so names that are not string literals
+ * (e.g. module names) need to be interned once before they can be used in events.
+ */
+const char *internName(const QString &name);
+
+void recordEvent(char phase, const char *name, int64_t value = 0);
+
+/**
+ * @brief Record a begin/end event pair for the current scope
+ */
+class ScopedEvent
+{
+public:
+    explicit ScopedEvent(const char *name)
+        : m_name(isEnabled() ? name : nullptr)
+    {
+        if (m_name != nullptr)
+            recordEvent('B', m_name);
+    }
+
+    ~ScopedEvent()
+    {
+        if (m_name != nullptr)
+            recordEvent('E', m_name);
+    }
+
+private:
+    const char *m_name;
+    Q_DISABLE_COPY(ScopedEvent)
+};
+
+} // namespace Tracing
+
+/**
+ * @brief Collects trace events from all threads and writes them to disk
+ *
+ * Every thread records events into its own lock-free ring buffer. The collector
+ * periodically drains these buffers and eventually writes all events as a
+ * Chrome/Perfetto compatible JSON trace, which can be opened with ui.perfetto.dev
+ * or chrome://tracing.
+ * Only one collector should be active at a time.
+ */
+class TraceCollector
+{
+public:
+    explicit TraceCollector();
+    ~TraceCollector();
+
+    void reset();
+    void collect();
+
+    size_t eventCount() const;
+    uint64_t droppedCount() const;
+
+    bool saveJson(const QString &fname, QString *errorMessage = nullptr);
+
+private:
+    class Private;
+    std::unique_ptr<Private> d;
+    Q_DISABLE_COPY(TraceCollector)
+};
+
+} // namespace Syntalos
+
+#define SY_TRACE_CONCAT_IMPL(a, b) a##b
+#define SY_TRACE_CONCAT(a, b)      SY_TRACE_CONCAT_IMPL(a, b)
+
+/**
+ * Trace event macros, for use in modules and the Syntalos core.
+ * Names must be string literals or pointers returned by Syntalos::Tracing::internName().
+ * If tracing is disabled, each of these costs one relaxed atomic load and a branch.
+ * The engine only records the lifetime of module threads, so threaded modules should
+ * mark the work done in each iteration of their main loop with SY_TRACE_SCOPE().
+ */
+#define SY_TRACE_BEGIN(name)                             \
+    do {                                                 \
+        if (Q_UNLIKELY(Syntalos::Tracing::isEnabled()))  \
+            Syntalos::Tracing::recordEvent('B', (name)); \
+    } while (0)
+
+#define SY_TRACE_END(name)                               \
+    do {                                                 \
+        if (Q_UNLIKELY(Syntalos::Tracing::isEnabled()))  \
+            Syntalos::Tracing::recordEvent('E', (name)); \
+    } while (0)
+
+#define SY_TRACE_COUNTER(name, value)                                                 \
+    do {                                                                              \
+        if (Q_UNLIKELY(Syntalos::Tracing::isEnabled()))                               \
+            Syntalos::Tracing::recordEvent('C', (name), static_cast<int64_t>(value)); \
+    } while (0)
+
+#define SY_TRACE_SCOPE(name) Syntalos::Tracing::ScopedEvent SY_TRACE_CONCAT(_syTraceScope, __LINE__)(name)
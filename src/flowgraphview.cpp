@@ -48,6 +48,29 @@
 #include "utils/misc.h"
 #include "utils/style.h"
 
+/**
+ * Check if the stream data types of two ports permit connecting them.
+ */
+static bool streamPortsCompatible(FlowGraphNodePort *port1, FlowGraphNodePort *port2)
+{
+    const auto sport1 = port1->streamPort();
+    const auto sport2 = port2->streamPort();
+    if (sport1->dataTypeId() == sport2->dataTypeId())
+        return true;
+
+    // input ports may accept more than one data type
+    auto inPort = dynamic_cast<VarStreamInputPort *>(sport1.get());
+    auto otherPort = sport2;
+    if (inPort == nullptr) {
+        inPort = dynamic_cast<VarStreamInputPort *>(sport2.get());
+        otherPort = sport1;
+    }
+    if (inPort == nullptr)
+        return false;
+
+    return inPort->acceptsSubscription(otherPort->dataTypeName());
+}
+
 //----------------------------------------------------------------------------
 // FlowGraphItem
 
@@ -919,7 +942,8 @@ QRectF FlowGraphNode::editorRect(void) const
 FlowGraphEdge::FlowGraphEdge(void)
     : FlowGraphItem(nullptr),
       m_port1(nullptr),
-      m_port2(nullptr)
+      m_port2(nullptr),
+      m_heatLevel(ConnectionHeatLevel::NONE)
 {
     QGraphicsPathItem::setZValue(-1);
 
@@ -1102,6 +1126,7 @@ void FlowGraphEdge::updatePortTypeColors(void)
 
 void FlowGraphEdge::setHeatLevel(ConnectionHeatLevel hlevel)
 {
+    m_heatLevel = hlevel;
     const QPalette pal;
     const bool isDarkest = pal.base().color().value() < 24;
     QColor shadowColor = isDarkest ? Qt::white : Qt::black;
@@ -1133,6 +1158,45 @@ void FlowGraphEdge::setHeatLevel(ConnectionHeatLevel hlevel)
     QGraphicsPathItem::setGraphicsEffect(effect);
 }
 
+static QString bytesToHumanString(double bytes)
+{
+    if (qAbs(bytes) >= 1024.0 * 1024.0 * 1024.0)
+        return QStringLiteral("%1 GiB").arg(bytes / 1024.0 / 1024.0 / 1024.0, 0, 'f', 1);
+    if (qAbs(bytes) >= 1024.0 * 1024.0)
+        return QStringLiteral("%1 MiB").arg(bytes / 1024.0 / 1024.0, 0, 'f', 1);
+    return QStringLiteral("%1 KiB").arg(bytes / 1024.0, 0, 'f', 1);
+}
+
+/**
+ * Update the heat level of this connection, and show
+ * the state of its buffer as tooltip.
+ */
+void FlowGraphEdge::setHeat(const ConnectionHeatInfo &heat)
+{
+    // recreating the shadow effect is expensive, so only do it when needed
+    if (heat.level != m_heatLevel)
+        setHeatLevel(heat.level);
+
+    if (heat.level == ConnectionHeatLevel::NONE) {
+        QGraphicsPathItem::setToolTip(QString());
+        return;
+    }
+
+    QString details = QStringLiteral("Buffer heat: %1\nPending: %2 elements (%3)")
+                          .arg(connectionHeatToHumanString(heat.level))
+                          .arg(heat.pendingCount)
+                          .arg(bytesToHumanString(heat.pendingBytes));
+    if (heat.growthBytesPerSec > 0)
+        details.append(QStringLiteral("\nGrowing by %1/s").arg(bytesToHumanString(heat.growthBytesPerSec)));
+    if (heat.memoryExhaustedSec >= 0) {
+        const auto minutes = heat.memoryExhaustedSec / 60.0;
+        details.append(
+            minutes < 1 ? QStringLiteral("\nMemory runs out in less than a minute at this rate!")
+                        : QStringLiteral("\nMemory runs out in about %1 min at this rate").arg(qRound(minutes)));
+    }
+    QGraphicsPathItem::setToolTip(details);
+}
+
 //----------------------------------------------------------------------------
 // FlowGraphView
 
@@ -1422,7 +1486,7 @@ void FlowGraphView::connectPorts(FlowGraphNodePort *port1, FlowGraphNodePort *po
         return;
     }
 
-    if (port1->streamPort()->dataTypeId() != port2->streamPort()->dataTypeId()) {
+    if (!streamPortsCompatible(port1, port2)) {
         // we have two incompatible ports, don't permit a connection
         delete edge;
         return;
@@ -1688,7 +1752,7 @@ void FlowGraphView::mouseReleaseEvent(QMouseEvent *event)
 
                     if (m_connect->setPort2(port2) && m_allowEdit) {
                         // check if the ports have compatible data types
-                        if (port1->streamPort()->dataTypeId() == port2->streamPort()->dataTypeId()) {
+                        if (streamPortsCompatible(port1, port2)) {
                             m_connect->updatePathTo(port2->portPos());
                             m_connect = nullptr;
                             ++m_selected_nodes;
@@ -405,6 +405,7 @@ public:
     void updatePortTypeColors();
 
     void setHeatLevel(ConnectionHeatLevel hlevel);
+    void setHeat(const ConnectionHeatInfo &heat);
 
 protected:
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
@@ -413,6 +414,7 @@ protected:
 private:
     FlowGraphNodePort *m_port1;
     FlowGraphNodePort *m_port2;
+    ConnectionHeatLevel m_heatLevel;
 };
 
 /**
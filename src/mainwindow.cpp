@@ -1318,14 +1318,14 @@ void MainWindow::onEngineResourceWarningUpdate(Engine::SystemResource kind, bool
     }
 }
 
-void MainWindow::onEngineConnectionHeatChanged(VarStreamInputPort *iport, ConnectionHeatLevel hlevel)
+void MainWindow::onEngineConnectionHeatChanged(VarStreamInputPort *iport, const ConnectionHeatInfo &heat)
 {
     auto edge = m_portGraphEdgeCache.value(iport);
     if (edge == nullptr) {
-        edge = ui->graphForm->updateConnectionHeat(iport, iport->outPort(), hlevel);
+        edge = ui->graphForm->updateConnectionHeat(iport, iport->outPort(), heat);
         m_portGraphEdgeCache.insert(iport, edge);
     } else {
-        edge->setHeatLevel(hlevel);
+        edge->setHeat(heat);
     }
 }
 
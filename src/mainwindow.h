@@ -83,7 +83,7 @@ private slots:
     void onEngineRunStarted();
     void onEngineStopped();
     void onEngineResourceWarningUpdate(Engine::SystemResource kind, bool resolved, const QString &message);
-    void onEngineConnectionHeatChanged(VarStreamInputPort *iport, ConnectionHeatLevel hlevel);
+    void onEngineConnectionHeatChanged(VarStreamInputPort *iport, const ConnectionHeatInfo &heat);
     void onElapsedTimeUpdate();
 
     void statusMessageChanged(const QString &message);
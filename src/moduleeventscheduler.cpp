@@ -0,0 +1,642 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "moduleeventscheduler.h"
+
+#include <QThread>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <thread>
+#include <unistd.h>
+
+#include "utils/misc.h"
+
+using namespace Syntalos;
+
+/**
+ * Interval in which the preferred workers of all modules are reassigned
+ * based on the cost of their callbacks.
+ */
+static constexpr int64_t REBALANCE_INTERVAL_USEC = 1000 * 1000;
+
+static constexpr int64_t NO_DEADLINE = std::numeric_limits<int64_t>::max();
+
+static inline int64_t monotonicUsec() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+namespace
+{
+
+struct ModuleSlot;
+
+/**
+ * A single timer or subscription callback of a module.
+ */
+struct EventTask {
+    ModuleSlot *slot;
+    bool isTimer;
+
+    intervalEventFunc_t timerFn;
+    int interval;                // only touched by the worker running the module
+    std::atomic_int64_t dueUsec; // next expiry of the timer
+
+    recvDataEventFunc_t recvFn;
+    VariantStreamSubscription *sub;
+    int eventFd;
+    std::atomic_int64_t latencyDueUsec; // time at which pending data in batched mode must be fetched
+
+    std::atomic_bool ready;
+    std::atomic_bool enabled;
+};
+
+/**
+ * Scheduling state of a module. A module is queued on at most one worker
+ * deque (or running on one worker) at a time.
+ */
+struct ModuleSlot {
+    AbstractModule *module;
+    const char *traceName;
+    std::vector<EventTask *> tasks;
+
+    std::atomic_bool queued;
+    std::atomic_bool disabled;
+    std::atomic_int homeWorker;
+
+    std::atomic_uint64_t costNsec;
+    std::atomic_uint64_t callCount;
+    uint64_t lastCostNsec; // only touched by the reactor
+};
+
+struct Worker {
+    std::mutex mutex;
+    std::deque<ModuleSlot *> queue;
+    std::thread thread;
+};
+
+} // namespace
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+class ModuleEventScheduler::Private
+{
+public:
+    Private() {}
+    ~Private() {}
+
+    QString threadName;
+    int workerCount;
+    std::atomic_bool running;
+    std::atomic_bool failed;
+
+    bool threadActive;
+    std::thread reactorThread;
+    int wakeFd;
+    std::atomic_int64_t reactorWakeUsec;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::unique_ptr<ModuleSlot>> slots;
+    std::vector<std::unique_ptr<EventTask>> tasks;
+
+    std::atomic_int pendingCount;
+    std::atomic_int inFlightCount;
+    std::atomic_bool workersStop;
+    std::mutex parkMutex;
+    std::condition_variable parkCond;
+
+    void wakeReactor()
+    {
+        const uint64_t v = 1;
+        if (write(wakeFd, &v, sizeof(v)) == -1 && errno != EAGAIN)
+            qWarning().noquote() << "Failed to wake event reactor:" << std::strerror(errno);
+    }
+
+    void wakeReactorAt(int64_t usec)
+    {
+        // only wake the reactor if it would otherwise sleep past the new deadline
+        // (reactorWakeUsec is NO_DEADLINE while the reactor is processing events)
+        if (usec < reactorWakeUsec.load())
+            wakeReactor();
+    }
+
+    void schedule(ModuleSlot *slot)
+    {
+        if (slot->disabled)
+            return;
+        if (slot->queued.exchange(true))
+            return;
+
+        auto &worker = workers[slot->homeWorker.load()];
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->queue.push_back(slot);
+        }
+        pendingCount++;
+
+        {
+            std::lock_guard<std::mutex> lock(parkMutex);
+        }
+        parkCond.notify_one();
+    }
+
+    void markReady(EventTask *task)
+    {
+        task->ready = true;
+        schedule(task->slot);
+    }
+
+    ModuleSlot *takeWork(int workerIdx)
+    {
+        ModuleSlot *slot = nullptr;
+
+        // take the oldest module from our own deque first
+        {
+            auto &own = workers[workerIdx];
+            std::lock_guard<std::mutex> lock(own->mutex);
+            if (!own->queue.empty()) {
+                slot = own->queue.front();
+                own->queue.pop_front();
+            }
+        }
+
+        // steal the newest module from the other workers if we have nothing to do
+        for (int i = 1; slot == nullptr && i < workerCount; i++) {
+            auto &victim = workers[(workerIdx + i) % workerCount];
+            std::lock_guard<std::mutex> lock(victim->mutex);
+            if (!victim->queue.empty()) {
+                slot = victim->queue.back();
+                victim->queue.pop_back();
+            }
+        }
+
+        if (slot != nullptr) {
+            inFlightCount++;
+            pendingCount--;
+        }
+        return slot;
+    }
+};
+#pragma GCC diagnostic pop
+
+ModuleEventScheduler::ModuleEventScheduler(int workerCount, QObject *parent)
+    : QObject(parent),
+      d(new ModuleEventScheduler::Private)
+{
+    d->running = false;
+    d->failed = false;
+    d->threadActive = false;
+    d->workerCount = workerCount > 0 ? workerCount : std::max(1, QThread::idealThreadCount());
+    d->threadName = QStringLiteral("ev:ws");
+    d->pendingCount = 0;
+    d->inFlightCount = 0;
+    d->workersStop = false;
+    d->reactorWakeUsec = NO_DEADLINE;
+    d->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (d->wakeFd < 0)
+        qFatal("Unable to obtain eventfd for event scheduler: %s", std::strerror(errno));
+}
+
+ModuleEventScheduler::~ModuleEventScheduler()
+{
+    shutdownThreads();
+    close(d->wakeFd);
+}
+
+bool ModuleEventScheduler::isRunning() const
+{
+    return d->running;
+}
+
+bool ModuleEventScheduler::isFailed() const
+{
+    return d->failed;
+}
+
+QString ModuleEventScheduler::threadName() const
+{
+    return d->threadName;
+}
+
+int ModuleEventScheduler::workerCount() const
+{
+    return d->workerCount;
+}
+
+/**
+ * Mark the scheduler as failed. The failed() signal is emitted
+ * once, when the scheduler enters the failed state.
+ */
+void ModuleEventScheduler::setFailed(bool failed)
+{
+    const bool wasFailed = d->failed.exchange(failed);
+    if (failed && !wasFailed)
+        emit this->failed();
+}
+
+static void rebalanceModules(const std::vector<std::unique_ptr<ModuleSlot>> &slots, int workerCount)
+{
+    if (workerCount <= 1)
+        return;
+
+    std::vector<std::pair<uint64_t, ModuleSlot *>> costs;
+    std::vector<uint64_t> currentLoad(workerCount, 0);
+    for (const auto &slot : slots) {
+        if (slot->disabled)
+            continue;
+        const uint64_t total = slot->costNsec;
+        const auto cost = total - slot->lastCostNsec;
+        slot->lastCostNsec = total;
+        costs.emplace_back(cost, slot.get());
+        currentLoad[slot->homeWorker] += cost;
+    }
+
+    // assign the most expensive modules first, each to the least loaded worker
+    std::sort(costs.begin(), costs.end(), [](const auto &a, const auto &b) {
+        return a.first > b.first;
+    });
+    std::vector<uint64_t> newLoad(workerCount, 0);
+    std::vector<int> newHome;
+    newHome.reserve(costs.size());
+    for (const auto &c : costs) {
+        const auto w = std::distance(newLoad.begin(), std::min_element(newLoad.begin(), newLoad.end()));
+        // add a tiny bias, so modules without measurable cost are distributed evenly as well
+        newLoad[w] += c.first + 1;
+        newHome.push_back(static_cast<int>(w));
+    }
+
+    // moving modules between workers costs cache locality, only do it if it pays off
+    const auto currentMax = *std::max_element(currentLoad.begin(), currentLoad.end());
+    const auto newMax = *std::max_element(newLoad.begin(), newLoad.end());
+    if (currentMax <= newMax + newMax / 4)
+        return;
+
+    for (size_t i = 0; i < costs.size(); i++)
+        costs[i].second->homeWorker = newHome[i];
+}
+
+void ModuleEventScheduler::reactorThreadFunc(QList<AbstractModule *> mods, OptionalWaitCondition *waitCondition)
+{
+    pthread_setname_np(pthread_self(), qPrintable(d->threadName.mid(0, 15)));
+    const int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        qCritical().noquote() << "Unable to create epoll instance for event scheduler:" << std::strerror(errno);
+        setFailed(true);
+        waitCondition->wait();
+        return;
+    }
+
+    epoll_event wakeEv = {};
+    wakeEv.events = EPOLLIN;
+    wakeEv.data.ptr = nullptr;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, d->wakeFd, &wakeEv);
+
+    // register event sources
+    int nextHome = 0;
+    for (const auto &mod : mods) {
+        auto slot = std::make_unique<ModuleSlot>();
+        slot->module = mod;
+        slot->traceName = Tracing::isEnabled() ? Tracing::internName(mod->name()) : nullptr;
+        slot->queued = false;
+        slot->disabled = false;
+        slot->homeWorker = nextHome++ % d->workerCount;
+        slot->costNsec = 0;
+        slot->callCount = 0;
+        slot->lastCostNsec = 0;
+
+        // add "timer" events
+        for (const auto &ev : mod->intervalEventCallbacks()) {
+            if (ev.second < 0)
+                continue;
+
+            auto task = std::make_unique<EventTask>();
+            task->slot = slot.get();
+            task->isTimer = true;
+            task->timerFn = ev.first;
+            task->interval = ev.second;
+            task->dueUsec = NO_DEADLINE;
+            task->sub = nullptr;
+            task->eventFd = -1;
+            task->latencyDueUsec = NO_DEADLINE;
+            task->ready = false;
+            task->enabled = true;
+            slot->tasks.push_back(task.get());
+            d->tasks.push_back(std::move(task));
+        }
+
+        // add "received data in subscription" events
+        for (const auto &ev : mod->recvDataEventCallbacks()) {
+            auto sub = ev.second;
+            if (sub == nullptr) {
+                qCritical().noquote().nospace()
+                    << "Bad event destination in module '" << mod->name() << "'. Was the event subscription valid?";
+                continue;
+            }
+
+            auto task = std::make_unique<EventTask>();
+            task->slot = slot.get();
+            task->isTimer = false;
+            task->recvFn = ev.first;
+            task->interval = -1;
+            task->dueUsec = NO_DEADLINE;
+            task->sub = sub.get();
+            task->eventFd = sub->enableNotify();
+            task->latencyDueUsec = NO_DEADLINE;
+            task->ready = false;
+            task->enabled = true;
+
+            epoll_event sev = {};
+            sev.events = EPOLLIN;
+            sev.data.ptr = task.get();
+            if (epoll_ctl(epfd, EPOLL_CTL_ADD, task->eventFd, &sev) != 0) {
+                qCritical().noquote().nospace() << "Unable to watch subscription of module '" << mod->name()
+                                                << "': " << std::strerror(errno);
+                continue;
+            }
+            slot->tasks.push_back(task.get());
+            d->tasks.push_back(std::move(task));
+        }
+
+        d->slots.push_back(std::move(slot));
+    }
+
+    // wait for us to start
+    waitCondition->wait();
+
+    // check if any module signals that it will actually not be doing anything
+    // (if so, we don't need to call it and can maybe even terminate this thread)
+    int activeCount = 0;
+    for (auto &slot : d->slots) {
+        if (slot->module->state() == ModuleState::IDLE)
+            slot->disabled = true;
+        else
+            activeCount++;
+    }
+
+    symaster_timepoint tpWaitStart;
+    int64_t nextRebalanceUsec;
+    if (activeCount == 0) {
+        qDebug().noquote() << "All evented modules are idle, shutting down the event scheduler.";
+        goto out;
+    }
+
+    // immediately return in case other modules have already failed
+    if (d->failed)
+        goto out;
+
+    // if we are already stopped, do nothing
+    if (!d->running)
+        goto out;
+
+    for (int i = 0; i < d->workerCount; i++)
+        d->workers[i]->thread = std::thread(&ModuleEventScheduler::workerThreadFunc, this, i);
+
+    // arm all timers, and dispatch data that was already sent before we were started
+    for (const auto &task : d->tasks) {
+        if (task->isTimer)
+            task->dueUsec = monotonicUsec() + static_cast<int64_t>(task->interval) * 1000;
+        else if (task->sub->notifyMode() != SubscriptionNotifyMode::PerItem && task->sub->armNotify())
+            d->markReady(task.get());
+    }
+
+    nextRebalanceUsec = monotonicUsec() + REBALANCE_INTERVAL_USEC;
+    while (d->running) {
+        // find the next deadline we have to wake up for
+        int64_t wakeUsec = nextRebalanceUsec;
+        for (const auto &task : d->tasks) {
+            if (!task->enabled)
+                continue;
+            wakeUsec = std::min(wakeUsec, std::min(task->dueUsec.load(), task->latencyDueUsec.load()));
+        }
+        d->reactorWakeUsec = wakeUsec;
+
+        // the deadline may have changed while we were computing it
+        int64_t now = monotonicUsec();
+        const int timeoutMsec = wakeUsec <= now ? 0 : static_cast<int>((wakeUsec - now + 999) / 1000);
+
+        epoll_event events[64];
+        const int n = epoll_wait(epfd, events, 64, timeoutMsec);
+
+        // while we are awake, workers must always notify us about new deadlines,
+        // as we may already have computed the next wakeup time without them
+        d->reactorWakeUsec = NO_DEADLINE;
+        if (n < 0 && errno != EINTR) {
+            qCritical().noquote() << "Event scheduler failed to wait for events:" << std::strerror(errno);
+            setFailed(true);
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            uint64_t buffer;
+            auto task = static_cast<EventTask *>(events[i].data.ptr);
+            if (task == nullptr) {
+                if (read(d->wakeFd, &buffer, sizeof(buffer)) == -1 && errno != EAGAIN)
+                    qWarning().noquote() << "Failed to read from eventfd:" << std::strerror(errno);
+                continue;
+            }
+
+            if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                epoll_ctl(epfd, EPOLL_CTL_DEL, task->eventFd, nullptr);
+                task->enabled = false;
+                continue;
+            }
+
+            // just read the buffer count for now to empty it
+            if (read(task->eventFd, &buffer, sizeof(buffer)) == -1 && errno != EAGAIN)
+                qWarning().noquote() << "Failed to read from eventfd:" << std::strerror(errno);
+            task->latencyDueUsec = NO_DEADLINE;
+            d->markReady(task);
+        }
+
+        now = monotonicUsec();
+        for (const auto &task : d->tasks) {
+            if (!task->enabled)
+                continue;
+            if (task->dueUsec <= now) {
+                // the worker running the timer arms it again
+                task->dueUsec = NO_DEADLINE;
+                d->markReady(task.get());
+            }
+            if (task->latencyDueUsec <= now) {
+                task->latencyDueUsec = NO_DEADLINE;
+                d->markReady(task.get());
+            }
+        }
+
+        if (now >= nextRebalanceUsec) {
+            rebalanceModules(d->slots, d->workerCount);
+            nextRebalanceUsec = now + REBALANCE_INTERVAL_USEC;
+        }
+    }
+
+    // process remaining data in subscriptions, for one second at most
+    for (const auto &task : d->tasks) {
+        if (!task->isTimer && task->enabled && task->sub->hasPending())
+            d->markReady(task.get());
+    }
+    tpWaitStart = symaster_clock::now();
+    while (d->pendingCount > 0 || d->inFlightCount > 0) {
+        if (timeDiffToNowMsec(tpWaitStart).count() >= 1000)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    d->workersStop = true;
+    {
+        std::lock_guard<std::mutex> lock(d->parkMutex);
+    }
+    d->parkCond.notify_all();
+    for (auto &worker : d->workers) {
+        if (worker->thread.joinable())
+            worker->thread.join();
+    }
+
+    for (const auto &slot : d->slots) {
+        if (slot->callCount == 0)
+            continue;
+        qDebug().noquote().nospace() << "Event scheduler: Module '" << slot->module->name() << "' ran "
+                                     << slot->callCount << " callbacks, taking "
+                                     << slot->costNsec / 1000 / 1000 << "msec in total";
+    }
+
+out:
+    close(epfd);
+}
+
+void ModuleEventScheduler::workerThreadFunc(int workerIdx)
+{
+    pthread_setname_np(pthread_self(), qPrintable(QStringLiteral("%1-%2").arg(d->threadName).arg(workerIdx)));
+
+    while (true) {
+        auto slot = d->takeWork(workerIdx);
+        if (slot == nullptr) {
+            std::unique_lock<std::mutex> lock(d->parkMutex);
+            if (d->workersStop)
+                break;
+            d->parkCond.wait_for(lock, std::chrono::milliseconds(100), [&] {
+                return d->pendingCount > 0 || d->workersStop;
+            });
+            continue;
+        }
+
+        for (auto task : slot->tasks) {
+            if (!task->ready.exchange(false))
+                continue;
+            if (!task->enabled || slot->disabled)
+                continue;
+
+            int interval = task->interval;
+            const auto tpStart = std::chrono::steady_clock::now();
+            SY_TRACE_BEGIN(slot->traceName);
+            if (task->isTimer)
+                std::invoke(task->timerFn, slot->module, interval);
+            else
+                std::invoke(task->recvFn, slot->module);
+            SY_TRACE_END(slot->traceName);
+            slot->costNsec += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::steady_clock::now() - tpStart)
+                                  .count();
+            slot->callCount++;
+
+            if (slot->module->state() == ModuleState::ERROR) {
+                // ewww, this module failed. suspend execution
+                setFailed(true);
+                slot->disabled = true;
+                qDebug().noquote().nospace() << "Module '" << slot->module->name()
+                                             << "' failed in event scheduler. Stopping.";
+                break;
+            }
+
+            if (task->isTimer) {
+                // interval < 0 means we should stop this timer
+                if (interval < 0) {
+                    task->enabled = false;
+                    continue;
+                }
+                task->interval = interval;
+                const auto due = monotonicUsec() + static_cast<int64_t>(interval) * 1000;
+                task->dueUsec = due;
+                d->wakeReactorAt(due);
+                continue;
+            }
+
+            // in coalescing modes we are only notified once per burst of data, so we need to
+            // request a new notification and keep dispatching until everything was processed
+            const auto mode = task->sub->notifyMode();
+            if (mode == SubscriptionNotifyMode::PerItem || !task->sub->armNotify())
+                continue;
+            if (mode == SubscriptionNotifyMode::Coalesced) {
+                task->ready = true;
+            } else if (task->latencyDueUsec == NO_DEADLINE) {
+                // in batched mode, we fetch pending data after the latency window at the latest
+                const auto due = monotonicUsec() + task->sub->notifyMaxLatency().count();
+                task->latencyDueUsec = due;
+                d->wakeReactorAt(due);
+            }
+        }
+
+        // release the module, and queue it again if new events arrived while it was running
+        slot->queued = false;
+        d->inFlightCount--;
+        for (auto task : slot->tasks) {
+            if (task->ready) {
+                d->schedule(slot);
+                break;
+            }
+        }
+    }
+}
+
+void ModuleEventScheduler::run(QList<AbstractModule *> mods, OptionalWaitCondition *waitCondition)
+{
+    if (d->threadActive)
+        return;
+
+    d->workers.clear();
+    for (int i = 0; i < d->workerCount; i++)
+        d->workers.push_back(std::make_unique<Worker>());
+
+    d->running = true;
+    d->threadActive = true;
+    d->workersStop = false;
+    d->reactorThread = std::thread(&ModuleEventScheduler::reactorThreadFunc, this, mods, waitCondition);
+}
+
+void ModuleEventScheduler::stop()
+{
+    shutdownThreads();
+}
+
+void ModuleEventScheduler::shutdownThreads()
+{
+    if (!d->threadActive)
+        return;
+    d->running = false;
+    d->wakeReactor();
+    d->reactorThread.join();
+    d->threadActive = false;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "moduleapi.h"
+#include "optionalwaitcondition.h"
+#include <QObject>
+
+namespace Syntalos
+{
+
+/**
+ * @brief Runs evented modules on a shared pool of work-stealing workers
+ *
+ * This is an alternative to running a fixed set of modules per ModuleEventThread.
+ * A reactor thread waits for new data in the modules' subscriptions and for their
+ * timers to expire, and then queues the affected module on the deque of its
+ * preferred worker. Workers that run out of work steal queued modules from other
+ * workers, so a single module with expensive callbacks can no longer starve the
+ * modules it would otherwise share a thread with.
+ *
+ * Every module has at most one callback in flight at any time, so modules can make
+ * the same thread-safety assumptions as when running on a ModuleEventThread.
+ * The time spent in each module's callbacks is measured, and the preferred workers
+ * of all modules are periodically reassigned to spread that cost evenly.
+ */
+class ModuleEventScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ModuleEventScheduler(int workerCount = -1, QObject *parent = nullptr);
+    ~ModuleEventScheduler();
+
+    bool isRunning() const;
+    bool isFailed() const;
+    QString threadName() const;
+    int workerCount() const;
+
+    void setFailed(bool failed);
+
+    void run(QList<AbstractModule *> mods, OptionalWaitCondition *waitCondition);
+    void stop();
+
+signals:
+    void failed();
+
+private:
+    class Private;
+    Q_DISABLE_COPY(ModuleEventScheduler)
+    QScopedPointer<Private> d;
+
+    void shutdownThreads();
+    void reactorThreadFunc(QList<AbstractModule *> mods, OptionalWaitCondition *waitCondition);
+    void workerThreadFunc(int workerIdx);
+};
+
+} // namespace Syntalos
@@ -19,9 +19,15 @@
 
 #include "moduleeventthread.h"
 
+#include <algorithm>
 #include <glib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #include <thread>
+#include <unistd.h>
 
+#include "streams/subscriptionsource.h"
 #include "utils/misc.h"
 
 using namespace Syntalos;
@@ -32,6 +38,7 @@ public:
     uint interval;
     AbstractModule *module;
     intervalEventFunc_t fn;
+    const char *traceName;
 
     ModuleEventThread *self;
     GSource *source;
@@ -43,6 +50,7 @@ class RecvDataEventPayload
 public:
     AbstractModule *module;
     recvDataEventFunc_t fn;
+    const char *traceName;
 
     ModuleEventThread *self;
     GSource *source;
@@ -58,11 +66,14 @@ public:
 
     QString threadName;
     bool running;
-    bool failed;
+    std::atomic_bool failed;
 
     bool threadActive;
     std::thread thread;
     std::atomic<GMainLoop *> activeLoop;
+
+    EventLoopBackend backend;
+    int wakeFd;
 };
 #pragma GCC diagnostic pop
 
@@ -74,6 +85,8 @@ ModuleEventThread::ModuleEventThread(const QString &threadName, QObject *parent)
     d->running = false;
     d->failed = false;
     d->threadActive = false;
+    d->backend = EventLoopBackend::GLIB;
+    d->wakeFd = -1;
     if (threadName.isEmpty())
         d->threadName = QStringLiteral("ev:%1").arg(createRandomString(9));
     else
@@ -83,6 +96,8 @@ ModuleEventThread::ModuleEventThread(const QString &threadName, QObject *parent)
 ModuleEventThread::~ModuleEventThread()
 {
     shutdownThread();
+    if (d->wakeFd >= 0)
+        close(d->wakeFd);
 }
 
 bool ModuleEventThread::isRunning() const
@@ -100,16 +115,41 @@ QString ModuleEventThread::threadName() const
     return d->threadName;
 }
 
+/**
+ * Mark the event thread as failed. The failed() signal is emitted
+ * once, when the thread enters the failed state.
+ */
 void ModuleEventThread::setFailed(bool failed)
 {
-    d->failed = failed;
+    const bool wasFailed = d->failed.exchange(failed);
+    if (failed && !wasFailed)
+        emit this->failed();
+}
+
+EventLoopBackend ModuleEventThread::backend() const
+{
+    return d->backend;
+}
+
+/**
+ * Select the event loop implementation used by this thread.
+ * Must be called before the thread is started. Work-stealing is not
+ * a per-thread backend, the GLib loop is used in that case.
+ */
+void ModuleEventThread::setBackend(EventLoopBackend backend)
+{
+    if (d->threadActive)
+        return;
+    d->backend = backend == EventLoopBackend::EPOLL ? EventLoopBackend::EPOLL : EventLoopBackend::GLIB;
 }
 
 static gboolean timerEventDispatch(gpointer udata)
 {
     const auto pl = static_cast<TimerEventPayload *>(udata);
     int interval = pl->interval;
+    SY_TRACE_BEGIN(pl->traceName);
     std::invoke(pl->fn, pl->module, interval);
+    SY_TRACE_END(pl->traceName);
 
     if (pl->module->state() == ModuleState::ERROR) {
         // ewww, this module failed. suspend execution
@@ -142,7 +182,9 @@ static gboolean timerEventDispatch(gpointer udata)
 static gboolean recvDataEventDispatch(gpointer udata)
 {
     const auto pl = static_cast<RecvDataEventPayload *>(udata);
+    SY_TRACE_BEGIN(pl->traceName);
     std::invoke(pl->fn, pl->module);
+    SY_TRACE_END(pl->traceName);
 
     if (pl->module->state() == ModuleState::ERROR) {
         // ewww, this module failed. suspend execution
@@ -154,56 +196,6 @@ static gboolean recvDataEventDispatch(gpointer udata)
     return TRUE;
 }
 
-typedef struct {
-    GSource source;
-    int event_fd;
-    gpointer event_fd_tag;
-} EFDSignalSource;
-
-static gboolean efd_signal_source_prepare(GSource *, gint *timeout)
-{
-    *timeout = -1;
-    return FALSE;
-}
-
-static gboolean efd_signal_source_dispatch(GSource *source, GSourceFunc callback, gpointer user_data)
-{
-    EFDSignalSource *efd_source = (EFDSignalSource *)source;
-
-    unsigned events = g_source_query_unix_fd(source, efd_source->event_fd_tag);
-    if (events & G_IO_HUP || events & G_IO_ERR || events & G_IO_NVAL) {
-        return G_SOURCE_REMOVE;
-    }
-
-    gboolean result_continue = G_SOURCE_CONTINUE;
-    if (events & G_IO_IN) {
-        uint64_t buffer;
-        // just read the buffer count for now to empty it
-        // (maybe we can do something useful with the element count later?)
-        if (G_UNLIKELY(read(efd_source->event_fd, &buffer, sizeof(buffer)) == -1 && errno != EAGAIN))
-            qWarning().noquote() << "Failed to read from eventfd:" << g_strerror(errno);
-
-        result_continue = callback(user_data);
-    }
-    g_source_set_ready_time(source, -1);
-    return result_continue;
-}
-
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
-static GSourceFuncs efd_source_funcs =
-    {.prepare = efd_signal_source_prepare, .check = NULL, .dispatch = efd_signal_source_dispatch, .finalize = NULL};
-#pragma GCC diagnostic pop
-
-static GSource *efd_signal_source_new(int event_fd)
-{
-    auto source = (EFDSignalSource *)g_source_new(&efd_source_funcs, sizeof(EFDSignalSource));
-    source->event_fd = event_fd;
-    source->event_fd_tag = g_source_add_unix_fd(
-        (GSource *)source, event_fd, (GIOCondition)(G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL));
-    return (GSource *)source;
-}
-
 void ModuleEventThread::moduleEventThreadFunc(QList<AbstractModule *> mods, OptionalWaitCondition *waitCondition)
 {
     pthread_setname_np(pthread_self(), qPrintable(d->threadName.mid(0, 15)));
@@ -216,6 +208,9 @@ void ModuleEventThread::moduleEventThreadFunc(QList<AbstractModule *> mods, Opti
     std::vector<std::unique_ptr<TimerEventPayload>> intervalPayloads;
     std::vector<std::unique_ptr<RecvDataEventPayload>> recvDataPayloads;
     for (const auto &mod : mods) {
+        // module callbacks show up under the module's name in traces
+        const auto traceName = Tracing::isEnabled() ? Tracing::internName(mod->name()) : nullptr;
+
         // add "timer" event sources
         for (const auto &ev : mod->intervalEventCallbacks()) {
             if (ev.second < 0)
@@ -225,6 +220,7 @@ void ModuleEventThread::moduleEventThreadFunc(QList<AbstractModule *> mods, Opti
             pl->interval = ev.second;
             pl->module = mod;
             pl->fn = ev.first;
+            pl->traceName = traceName;
             pl->self = this;
             pl->context = context;
             pl->source = g_timeout_source_new(pl->interval);
@@ -241,13 +237,12 @@ void ModuleEventThread::moduleEventThreadFunc(QList<AbstractModule *> mods, Opti
                     << "Bad event destination in module '" << mod->name() << "'. Was the event subscription valid?";
                 continue;
             }
-            int eventfd = sub->enableNotify();
-
             auto pl = std::make_unique<RecvDataEventPayload>();
             pl->module = mod;
             pl->fn = ev.first;
+            pl->traceName = traceName;
             pl->self = this;
-            pl->source = efd_signal_source_new(eventfd);
+            pl->source = newSubscriptionEventSource(sub.get());
             g_source_set_callback(pl->source, &recvDataEventDispatch, pl.get(), NULL);
             g_source_attach(pl->source, context);
             recvDataPayloads.push_back(std::move(pl));
@@ -308,6 +303,324 @@ out:
     }
 }
 
+/**
+ * An event source of the epoll-based event loop, either a timer or a stream subscription.
+ */
+class EpollEventSource
+{
+public:
+    bool isTimer;
+    int fd;
+    AbstractModule *module;
+    const char *traceName;
+    bool active;
+    uint64_t lastDispatch;
+
+    intervalEventFunc_t timerFn;
+    int interval;
+
+    recvDataEventFunc_t recvFn;
+    VariantStreamSubscription *sub;
+    int64_t pendingSince;
+};
+
+static bool armIntervalTimerFd(int fd, int intervalMsec)
+{
+    // a zero interval would disarm the timer, but means "run as often as possible" for us
+    const int64_t intervalNsec = std::max<int64_t>(static_cast<int64_t>(intervalMsec) * 1000 * 1000, 1000);
+
+    itimerspec spec;
+    spec.it_interval.tv_sec = intervalNsec / (1000 * 1000 * 1000);
+    spec.it_interval.tv_nsec = intervalNsec % (1000 * 1000 * 1000);
+    spec.it_value = spec.it_interval;
+    return timerfd_settime(fd, 0, &spec, nullptr) == 0;
+}
+
+static bool epollTimerDispatch(EpollEventSource *src, ModuleEventThread *self)
+{
+    uint64_t expirations;
+    if (read(src->fd, &expirations, sizeof(expirations)) == -1 && errno != EAGAIN)
+        qWarning().noquote() << "Failed to read from timerfd:" << g_strerror(errno);
+
+    int interval = src->interval;
+    SY_TRACE_BEGIN(src->traceName);
+    std::invoke(src->timerFn, src->module, interval);
+    SY_TRACE_END(src->traceName);
+
+    if (src->module->state() == ModuleState::ERROR) {
+        // ewww, this module failed. suspend execution
+        self->setFailed(true);
+        qDebug().noquote().nospace() << "Module '" << src->module->name() << "' failed in event loop. Stopping.";
+        return false;
+    }
+
+    // interval wasn't changed, we continue as normal
+    if (interval == src->interval)
+        return true;
+
+    // interval < 0 means we should stop this event source
+    if (interval < 0)
+        return false;
+
+    // the interval was adjusted, so we just rearm our timer
+    src->interval = interval;
+    return armIntervalTimerFd(src->fd, interval);
+}
+
+static bool epollRecvDataDispatch(EpollEventSource *src, ModuleEventThread *self)
+{
+    SY_TRACE_BEGIN(src->traceName);
+    std::invoke(src->recvFn, src->module);
+    SY_TRACE_END(src->traceName);
+
+    if (src->module->state() == ModuleState::ERROR) {
+        // ewww, this module failed. suspend execution
+        self->setFailed(true);
+        qDebug().noquote().nospace() << "Module '" << src->module->name() << "' failed in event loop. Stopping.";
+        return false;
+    }
+
+    return true;
+}
+
+void ModuleEventThread::moduleEventThreadFuncEpoll(QList<AbstractModule *> mods, OptionalWaitCondition *waitCondition)
+{
+    pthread_setname_np(pthread_self(), qPrintable(d->threadName.mid(0, 15)));
+
+    // we could not be woken up for shutdown without the eventfd, so we must not run at all
+    if (d->wakeFd < 0) {
+        setFailed(true);
+        waitCondition->wait();
+        return;
+    }
+
+    const int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        qCritical().noquote() << "Unable to create epoll instance for event thread:" << g_strerror(errno);
+        setFailed(true);
+        waitCondition->wait();
+        return;
+    }
+
+    epoll_event wakeEv = {};
+    wakeEv.events = EPOLLIN;
+    wakeEv.data.ptr = nullptr;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, d->wakeFd, &wakeEv);
+
+    // add event sources
+    std::vector<std::unique_ptr<EpollEventSource>> sources;
+    for (const auto &mod : mods) {
+        // module callbacks show up under the module's name in traces
+        const auto traceName = Tracing::isEnabled() ? Tracing::internName(mod->name()) : nullptr;
+
+        // add "timer" event sources
+        for (const auto &ev : mod->intervalEventCallbacks()) {
+            if (ev.second < 0)
+                continue;
+
+            auto src = std::make_unique<EpollEventSource>();
+            src->isTimer = true;
+            src->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+            src->module = mod;
+            src->traceName = traceName;
+            src->active = true;
+            src->lastDispatch = 0;
+            src->timerFn = ev.first;
+            src->interval = ev.second;
+            src->sub = nullptr;
+            src->pendingSince = 0;
+            if (src->fd < 0) {
+                qCritical().noquote().nospace()
+                    << "Unable to create timer for module '" << mod->name() << "': " << g_strerror(errno);
+                continue;
+            }
+            sources.push_back(std::move(src));
+        }
+
+        // add "received data in subscription" event sources
+        for (const auto &ev : mod->recvDataEventCallbacks()) {
+            auto sub = ev.second;
+            if (sub == nullptr) {
+                qCritical().noquote().nospace()
+                    << "Bad event destination in module '" << mod->name() << "'. Was the event subscription valid?";
+                continue;
+            }
+
+            auto src = std::make_unique<EpollEventSource>();
+            src->isTimer = false;
+            src->fd = sub->enableNotify();
+            src->module = mod;
+            src->traceName = traceName;
+            src->active = true;
+            src->lastDispatch = 0;
+            src->interval = -1;
+            src->recvFn = ev.first;
+            src->sub = sub.get();
+            src->pendingSince = 0;
+            sources.push_back(std::move(src));
+        }
+    }
+
+    for (const auto &src : sources) {
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.ptr = src.get();
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, src->fd, &ev) != 0) {
+            qCritical().noquote().nospace() << "Unable to watch event source of module '" << src->module->name()
+                                            << "': " << g_strerror(errno);
+            src->active = false;
+        }
+    }
+
+    // wait for us to start
+    waitCondition->wait();
+
+    // check if any module signals that it will actually not be doing anything
+    // (if so, we don't need to call it and can maybe even terminate this thread)
+    QMutableListIterator<AbstractModule *> i(mods);
+    while (i.hasNext()) {
+        if (i.next()->state() == ModuleState::IDLE)
+            i.remove();
+    }
+
+    // used later to measure wait time on shutdown
+    symaster_timepoint tpWaitStart;
+    std::vector<EpollEventSource *> ready;
+    uint64_t iteration = 0;
+    epoll_event events[64];
+    ready.reserve(sources.size());
+
+    // dispatch all sources in the ready list, and check their results
+    auto dispatchReady = [&]() {
+        for (auto src : ready) {
+            if (!src->active || src->lastDispatch == iteration)
+                continue;
+            src->lastDispatch = iteration;
+
+            const auto keep = src->isTimer ? epollTimerDispatch(src, this) : epollRecvDataDispatch(src, this);
+            if (!keep) {
+                src->active = false;
+                epoll_ctl(epfd, EPOLL_CTL_DEL, src->fd, nullptr);
+            }
+        }
+        ready.clear();
+    };
+
+    // wait for events and put all sources that are ready into the ready list
+    auto collectReady = [&](bool allowWait) {
+        int timeoutMsec = allowWait ? -1 : 0;
+        const auto now = g_get_monotonic_time();
+        iteration++;
+
+        for (const auto &src : sources) {
+            if (!src->active || src->isTimer)
+                continue;
+            const auto mode = src->sub->notifyMode();
+            if (mode == SubscriptionNotifyMode::PerItem)
+                continue;
+
+            // in coalescing modes we are only notified once per burst of data, so we need to
+            // request a new notification and keep dispatching until everything was processed
+            if (!src->sub->armNotify()) {
+                src->pendingSince = 0;
+                continue;
+            }
+            if (mode == SubscriptionNotifyMode::Coalesced) {
+                ready.push_back(src.get());
+                timeoutMsec = 0;
+                continue;
+            }
+
+            // in batched mode, we fetch pending data after the latency window at the latest
+            if (src->pendingSince == 0)
+                src->pendingSince = now;
+            const auto remainingUsec = src->sub->notifyMaxLatency().count() - (now - src->pendingSince);
+            if (remainingUsec <= 0) {
+                ready.push_back(src.get());
+                src->pendingSince = 0;
+                timeoutMsec = 0;
+            } else if (timeoutMsec != 0) {
+                const int srcTimeout = static_cast<int>((remainingUsec + 999) / 1000);
+                timeoutMsec = timeoutMsec < 0 ? srcTimeout : std::min(timeoutMsec, srcTimeout);
+            }
+        }
+
+        const int n = epoll_wait(epfd, events, 64, timeoutMsec);
+        if (n < 0 && errno != EINTR)
+            qWarning().noquote() << "Failed to wait for module events:" << g_strerror(errno);
+
+        for (int j = 0; j < n; j++) {
+            auto src = static_cast<EpollEventSource *>(events[j].data.ptr);
+            if (src == nullptr) {
+                uint64_t buffer;
+                if (read(d->wakeFd, &buffer, sizeof(buffer)) == -1 && errno != EAGAIN)
+                    qWarning().noquote() << "Failed to read from eventfd:" << g_strerror(errno);
+                continue;
+            }
+
+            if (events[j].events & (EPOLLHUP | EPOLLERR)) {
+                src->active = false;
+                epoll_ctl(epfd, EPOLL_CTL_DEL, src->fd, nullptr);
+                continue;
+            }
+
+            if (!src->isTimer) {
+                // just read the buffer count for now to empty it
+                uint64_t buffer;
+                if (read(src->fd, &buffer, sizeof(buffer)) == -1 && errno != EAGAIN)
+                    qWarning().noquote() << "Failed to read from eventfd:" << g_strerror(errno);
+                src->pendingSince = 0;
+            }
+            ready.push_back(src);
+        }
+
+        return n > 0 || !ready.empty();
+    };
+
+    if (mods.isEmpty()) {
+        qDebug().noquote() << "All evented modules are idle, shutting down their thread.";
+        goto out;
+    }
+
+    // immediately return in case other modules have already failed
+    if (d->failed)
+        goto out;
+
+    // if we are already stopped, do nothing
+    if (!d->running)
+        goto out;
+
+    // arm all timers, relative to the time we actually started
+    for (const auto &src : sources) {
+        if (src->isTimer && src->active && !armIntervalTimerFd(src->fd, src->interval)) {
+            qCritical().noquote().nospace()
+                << "Unable to arm timer for module '" << src->module->name() << "': " << g_strerror(errno);
+            src->active = false;
+        }
+    }
+
+    // run the event loop
+    while (d->running) {
+        collectReady(true);
+        dispatchReady();
+    }
+
+    // cleanup and process remaining events
+    tpWaitStart = symaster_clock::now();
+    while (timeDiffToNowMsec(tpWaitStart).count() < 1000) {
+        if (!collectReady(false))
+            break;
+        dispatchReady();
+    }
+
+out:
+    for (const auto &src : sources) {
+        if (src->isTimer && src->fd >= 0)
+            close(src->fd);
+    }
+    close(epfd);
+}
+
 void ModuleEventThread::run(QList<AbstractModule *> mods, OptionalWaitCondition *waitCondition)
 {
     if (d->threadActive)
@@ -315,7 +628,16 @@ void ModuleEventThread::run(QList<AbstractModule *> mods, OptionalWaitCondition
 
     d->running = true;
     d->threadActive = true;
-    d->thread = std::thread(&ModuleEventThread::moduleEventThreadFunc, this, mods, waitCondition);
+    if (d->backend == EventLoopBackend::EPOLL) {
+        if (d->wakeFd < 0) {
+            d->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (d->wakeFd < 0)
+                qCritical().noquote() << "Unable to obtain eventfd for event thread:" << g_strerror(errno);
+        }
+        d->thread = std::thread(&ModuleEventThread::moduleEventThreadFuncEpoll, this, mods, waitCondition);
+    } else {
+        d->thread = std::thread(&ModuleEventThread::moduleEventThreadFunc, this, mods, waitCondition);
+    }
 }
 
 void ModuleEventThread::stop()
@@ -330,6 +652,11 @@ void ModuleEventThread::shutdownThread()
     d->running = false;
     if (d->activeLoop != nullptr)
         g_main_loop_quit(d->activeLoop);
+    if (d->wakeFd >= 0) {
+        const uint64_t v = 1;
+        if (write(d->wakeFd, &v, sizeof(v)) == -1 && errno != EAGAIN)
+            qWarning().noquote() << "Failed to wake event thread:" << g_strerror(errno);
+    }
     d->thread.join();
     d->threadActive = false;
 }
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include "globalconfig.h"
 #include "moduleapi.h"
 #include "optionalwaitcondition.h"
 #include <QObject>
@@ -41,6 +42,9 @@ namespace Syntalos
  * Therefore, the thread managed by this class runs a GMainLoop-based event
  * loop to have much tighter control on what is executed when and why, and
  * to take care of Syntalos-specific quirks.
+ * Alternatively, the thread can wait on the subscription eventfds and on timerfds
+ * using epoll directly, which avoids GLib's per-iteration overhead for every
+ * event source when a thread serves many subscriptions.
  */
 class ModuleEventThread : public QObject
 {
@@ -55,6 +59,9 @@ public:
 
     void setFailed(bool failed);
 
+    EventLoopBackend backend() const;
+    void setBackend(EventLoopBackend backend);
+
     void run(QList<AbstractModule *> mods, OptionalWaitCondition *waitCondition);
     void stop();
 
@@ -68,6 +75,7 @@ private:
 
     void shutdownThread();
     void moduleEventThreadFunc(QList<AbstractModule *> mods, OptionalWaitCondition *waitCondition);
+    void moduleEventThreadFuncEpoll(QList<AbstractModule *> mods, OptionalWaitCondition *waitCondition);
 };
 
 } // namespace Syntalos
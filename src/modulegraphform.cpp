@@ -79,6 +79,7 @@ ModuleGraphForm::ModuleGraphForm(QWidget *parent)
     ui->graphView->setPortTypeColor(TableRow::staticTypeId(), QColor::fromRgb(0x8FD6FE));
     ui->graphView->setPortTypeColor(IntSignalBlock::staticTypeId(), QColor::fromRgb(0x2ECC71));
     ui->graphView->setPortTypeColor(FloatSignalBlock::staticTypeId(), QColor::fromRgb(0xAECC70));
+    ui->graphView->setPortTypeColor(Float32SignalBlock::staticTypeId(), QColor::fromRgb(0x9CBF5A));
 }
 
 ModuleGraphForm::~ModuleGraphForm()
@@ -124,7 +125,7 @@ void ModuleGraphForm::setModifyPossible(bool allowModify)
 FlowGraphEdge *ModuleGraphForm::updateConnectionHeat(
     const VarStreamInputPort *inPort,
     const StreamOutputPort *outPort,
-    ConnectionHeatLevel hlevel)
+    const ConnectionHeatInfo &heat)
 {
     const auto inNode = m_modNodeMap.value(inPort->owner());
     const auto outNode = m_modNodeMap.value(outPort->owner());
@@ -145,7 +146,7 @@ FlowGraphEdge *ModuleGraphForm::updateConnectionHeat(
         return nullptr;
     }
 
-    edge->setHeatLevel(hlevel);
+    edge->setHeat(heat);
     return edge;
 }
 
@@ -67,7 +67,7 @@ public:
     FlowGraphEdge *updateConnectionHeat(
         const VarStreamInputPort *inPort,
         const StreamOutputPort *outPort,
-        ConnectionHeatLevel hlevel);
+        const ConnectionHeatInfo &heat);
 
 private slots:
     void on_actionAddModule_triggered();
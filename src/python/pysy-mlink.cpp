@@ -206,6 +206,9 @@ struct InputPort {
                 case syDataTypeId<FloatSignalBlock>():
                     _on_data_cb(py::cast(FloatSignalBlock::fromMemory(data, size)));
                     break;
+                case syDataTypeId<Float32SignalBlock>():
+                    _on_data_cb(py::cast(Float32SignalBlock::fromMemory(data, size)));
+                    break;
                 }
             } catch (py::error_already_set &e) {
                 auto pb = PyBridge::instance();
@@ -263,6 +266,8 @@ struct OutputPort {
             return slink->submitOutput(_oport, py::cast<IntSignalBlock>(pyObj));
         case syDataTypeId<FloatSignalBlock>():
             return slink->submitOutput(_oport, py::cast<FloatSignalBlock>(pyObj));
+        case syDataTypeId<Float32SignalBlock>():
+            return slink->submitOutput(_oport, py::cast<Float32SignalBlock>(pyObj));
         default:
             return false;
         }
@@ -595,6 +600,13 @@ PYBIND11_MODULE(syntalos_mlink, m)
         .def_property_readonly("length", &FloatSignalBlock::length)
         .def_property_readonly("rows", &FloatSignalBlock::rows)
         .def_property_readonly("cols", &FloatSignalBlock::cols);
+    py::class_<Float32SignalBlock>(m, "Float32SignalBlock", "A block of timestamped single-precision float signal data.")
+        .def(py::init<>())
+        .def_readwrite("timestamps", &Float32SignalBlock::timestamps, "Timestamps of the data blocks.")
+        .def_readwrite("data", &Float32SignalBlock::data, "The data matrix.")
+        .def_property_readonly("length", &Float32SignalBlock::length)
+        .def_property_readonly("rows", &Float32SignalBlock::rows)
+        .def_property_readonly("cols", &Float32SignalBlock::cols);
 
     /**
      ** Additional Functions
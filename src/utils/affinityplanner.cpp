@@ -0,0 +1,430 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "affinityplanner.h"
+
+#include <QDir>
+#include <QFile>
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <numeric>
+#include <tuple>
+
+#include "cpuaffinity.h"
+
+static QString readSysfsValue(const QString &fname)
+{
+    QFile f(fname);
+    if (!f.open(QIODevice::ReadOnly))
+        return QString();
+    return QString::fromUtf8(f.readAll()).trimmed();
+}
+
+/**
+ * Parse a kernel CPU list, like "0-3,8,10-11"
+ */
+QList<uint> parseCpuList(const QString &list)
+{
+    QList<uint> result;
+    for (const auto &part : list.trimmed().split(',', Qt::SkipEmptyParts)) {
+        const auto range = part.split('-');
+        bool okFirst = false;
+        bool okLast = false;
+        const uint first = range[0].trimmed().toUInt(&okFirst);
+        const uint last = range.length() > 1 ? range[1].trimmed().toUInt(&okLast) : first;
+        if (!okFirst || (range.length() > 1 && !okLast))
+            continue;
+        for (uint cpu = first; cpu <= last; cpu++)
+            result.append(cpu);
+    }
+
+    return result;
+}
+
+static int lowestCpu(const QList<uint> &cpus, int fallback)
+{
+    if (cpus.isEmpty())
+        return fallback;
+    return static_cast<int>(*std::min_element(cpus.begin(), cpus.end()));
+}
+
+CpuTopology::CpuTopology() {}
+
+/**
+ * Read the CPU topology of this system from sysfs.
+ * If no topology information is available, a flat topology is returned.
+ */
+CpuTopology CpuTopology::fromSysfs(const QString &cpuRoot)
+{
+    const auto onlineCpus = parseCpuList(readSysfsValue(QStringLiteral("%1/online").arg(cpuRoot)));
+    if (onlineCpus.isEmpty())
+        return CpuTopology::flat(get_online_cores_count());
+
+    CpuTopology topo;
+    for (const auto cpu : onlineCpus) {
+        const auto base = QStringLiteral("%1/cpu%2").arg(cpuRoot).arg(cpu);
+
+        CpuInfo info;
+        info.cpu = cpu;
+        info.coreId = lowestCpu(
+            parseCpuList(readSysfsValue(QStringLiteral("%1/topology/thread_siblings_list").arg(base))),
+            static_cast<int>(cpu));
+        info.packageId = readSysfsValue(QStringLiteral("%1/topology/physical_package_id").arg(base)).toInt();
+
+        info.numaNode = 0;
+        const auto nodeDirs = QDir(base).entryList(QStringList() << "node*", QDir::Dirs | QDir::NoDotAndDotDot);
+        if (!nodeDirs.isEmpty())
+            info.numaNode = nodeDirs.first().mid(4).toInt();
+
+        // find the highest-level data cache, which is shared between the most cores
+        info.llcId = -1;
+        int llcLevel = 0;
+        const auto cacheDir = QStringLiteral("%1/cache").arg(base);
+        for (const auto &index : QDir(cacheDir).entryList(QStringList() << "index*", QDir::Dirs)) {
+            const auto indexDir = QStringLiteral("%1/%2").arg(cacheDir, index);
+            if (readSysfsValue(QStringLiteral("%1/type").arg(indexDir)) == QStringLiteral("Instruction"))
+                continue;
+            const auto level = readSysfsValue(QStringLiteral("%1/level").arg(indexDir)).toInt();
+            if (level <= llcLevel)
+                continue;
+            llcLevel = level;
+            info.llcId = lowestCpu(
+                parseCpuList(readSysfsValue(QStringLiteral("%1/shared_cpu_list").arg(indexDir))), info.coreId);
+        }
+
+        topo.m_cpus.append(info);
+    }
+
+    // without cache information, we assume all CPUs of a package share their last-level cache
+    for (auto &info : topo.m_cpus) {
+        if (info.llcId >= 0)
+            continue;
+        info.llcId = static_cast<int>(info.cpu);
+        for (const auto &other : topo.m_cpus) {
+            if (other.packageId == info.packageId)
+                info.llcId = std::min(info.llcId, static_cast<int>(other.cpu));
+        }
+    }
+
+    for (const auto cpu : parseCpuList(readSysfsValue(QStringLiteral("%1/isolated").arg(cpuRoot))))
+        topo.m_isolated.insert(cpu);
+
+    return topo;
+}
+
+/**
+ * Create a topology of @cpuCount independent cores sharing one cache.
+ */
+CpuTopology CpuTopology::flat(int cpuCount)
+{
+    CpuTopology topo;
+    for (int i = 0; i < cpuCount; i++) {
+        CpuInfo info;
+        info.cpu = static_cast<uint>(i);
+        info.coreId = i;
+        info.packageId = 0;
+        info.numaNode = 0;
+        info.llcId = 0;
+        topo.m_cpus.append(info);
+    }
+
+    return topo;
+}
+
+bool CpuTopology::isEmpty() const
+{
+    return m_cpus.isEmpty();
+}
+
+QList<CpuInfo> CpuTopology::cpus() const
+{
+    return m_cpus;
+}
+
+QList<uint> CpuTopology::isolatedCpus() const
+{
+    auto list = m_isolated.values();
+    std::sort(list.begin(), list.end());
+    return list;
+}
+
+bool CpuTopology::isIsolated(uint cpu) const
+{
+    return m_isolated.contains(cpu);
+}
+
+int CpuTopology::physicalCoreCount() const
+{
+    QSet<int> ids;
+    for (const auto &info : m_cpus)
+        ids.insert(info.coreId);
+    return ids.size();
+}
+
+int CpuTopology::llcDomainCount() const
+{
+    QSet<int> ids;
+    for (const auto &info : m_cpus)
+        ids.insert(info.llcId);
+    return ids.size();
+}
+
+int CpuTopology::numaNodeCount() const
+{
+    QSet<int> ids;
+    for (const auto &info : m_cpus)
+        ids.insert(info.numaNode);
+    return ids.size();
+}
+
+CoreAffinityPlanner::CoreAffinityPlanner(const CpuTopology &topology)
+    : m_topology(topology),
+      m_pinMainThread(false)
+{
+}
+
+/**
+ * Register a thread that should be pinned to a CPU core.
+ * @param realtime Whether the thread needs a physical core without busy SMT siblings
+ * @param required Whether this thread should be placed before all other threads
+ * @return Index of the thread in the resulting plan.
+ */
+int CoreAffinityPlanner::addThread(const QString &name, bool realtime, bool required)
+{
+    m_threads.push_back(ThreadRequest{name, realtime, required});
+    return static_cast<int>(m_threads.size()) - 1;
+}
+
+/**
+ * Register that @producer sends data to @consumer. Threads connected by links
+ * with a positive weight are placed on cores sharing a cache, if possible.
+ */
+void CoreAffinityPlanner::addLink(int producer, int consumer, double weight)
+{
+    const auto count = static_cast<int>(m_threads.size());
+    if (producer < 0 || consumer < 0 || producer >= count || consumer >= count || producer == consumer)
+        return;
+    m_links.push_back(Link{producer, consumer, weight});
+}
+
+/**
+ * Set whether the main thread should be pinned to the cores that were
+ * not assigned to any other thread.
+ */
+void CoreAffinityPlanner::setPinMainThread(bool pin)
+{
+    m_pinMainThread = pin;
+}
+
+static QVariantList cpuVectorToVariant(const std::vector<uint> &cpus)
+{
+    QVariantList list;
+    for (const auto cpu : cpus)
+        list.append(static_cast<int>(cpu));
+    return list;
+}
+
+AffinityPlan CoreAffinityPlanner::plan() const
+{
+    struct Core {
+        int id;
+        int llcId;
+        int numaNode;
+        std::vector<uint> cpus;
+        size_t usedCount;
+        bool exclusive;
+    };
+
+    AffinityPlan plan;
+    const auto threadCount = m_threads.size();
+    plan.threadCpus.resize(threadCount);
+
+    // collect all physical cores we may use, grouped by their cache domain
+    auto cpus = m_topology.cpus();
+    std::sort(cpus.begin(), cpus.end(), [](const CpuInfo &a, const CpuInfo &b) {
+        return std::tie(a.llcId, a.coreId, a.cpu) < std::tie(b.llcId, b.coreId, b.cpu);
+    });
+    std::vector<Core> cores;
+    for (const auto &info : cpus) {
+        // the administrator isolated these CPUs from the scheduler, so we don't touch them
+        if (m_topology.isIsolated(info.cpu))
+            continue;
+        if (cores.empty() || cores.back().id != info.coreId)
+            cores.push_back(Core{info.coreId, info.llcId, info.numaNode, {}, 0, false});
+        cores.back().cpus.push_back(info.cpu);
+    }
+
+    QSet<uint> usedCpus;
+    auto takeCpu = [&](Core &core) -> uint {
+        for (const auto cpu : core.cpus) {
+            if (usedCpus.contains(cpu))
+                continue;
+            usedCpus.insert(cpu);
+            core.usedCount++;
+            return cpu;
+        }
+        return 0;
+    };
+    auto freeCoresInLlc = [&](int llcId) {
+        return std::count_if(cores.begin(), cores.end(), [&](const Core &c) {
+            return c.llcId == llcId && c.usedCount == 0;
+        });
+    };
+
+    // find a core for a thread, preferring the given cache domain
+    auto findCore = [&](int preferredLlc, bool needFreeCore) -> Core * {
+        Core *best = nullptr;
+        long bestScore = -1;
+        for (auto &core : cores) {
+            if (core.usedCount == 0) {
+                // prefer the requested domain, then the domain with the most free cores left
+                const long score = (core.llcId == preferredLlc ? 1000000 : 0) + freeCoresInLlc(core.llcId);
+                if (score > bestScore) {
+                    best = &core;
+                    bestScore = score;
+                }
+            }
+        }
+        if (best != nullptr || needFreeCore)
+            return best;
+
+        // no free physical core left, so we share a core with a thread that is not realtime
+        for (auto &core : cores) {
+            if (core.exclusive || core.usedCount >= core.cpus.size())
+                continue;
+            if (best == nullptr || (core.llcId == preferredLlc && best->llcId != preferredLlc))
+                best = &core;
+        }
+        return best;
+    };
+
+    // the first core is always left for the main thread
+    if (!cores.empty()) {
+        const auto mainCpu = takeCpu(cores.front());
+        if (m_pinMainThread)
+            plan.mainThreadCpus.push_back(mainCpu);
+    }
+
+    // group threads connected by high-bandwidth links into clusters
+    std::vector<size_t> clusterOf(threadCount);
+    std::iota(clusterOf.begin(), clusterOf.end(), 0);
+    std::function<size_t(size_t)> findCluster = [&](size_t i) {
+        return clusterOf[i] == i ? i : (clusterOf[i] = findCluster(clusterOf[i]));
+    };
+    std::vector<double> clusterWeight(threadCount, 0);
+    for (const auto &link : m_links) {
+        if (link.weight <= 0)
+            continue;
+        const auto a = findCluster(link.producer);
+        const auto b = findCluster(link.consumer);
+        if (a != b) {
+            clusterOf[b] = a;
+            clusterWeight[a] += clusterWeight[b];
+        }
+        clusterWeight[a] += link.weight;
+    }
+
+    // place required and realtime threads first, then the clusters exchanging the most data
+    std::vector<size_t> order(threadCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        const auto &ta = m_threads[a];
+        const auto &tb = m_threads[b];
+        if (ta.required != tb.required)
+            return ta.required;
+        if (ta.realtime != tb.realtime)
+            return ta.realtime;
+        return clusterWeight[findCluster(a)] > clusterWeight[findCluster(b)];
+    });
+
+    QVariantHash threadsDesc;
+    std::vector<int> clusterLlc(threadCount, INT_MIN);
+    for (const auto idx : order) {
+        const auto &thread = m_threads[idx];
+        const auto cluster = findCluster(idx);
+
+        auto core = findCore(clusterLlc[cluster], thread.realtime);
+        bool smtExclusive = false;
+        if (core != nullptr && thread.realtime) {
+            // reserve all SMT siblings of this core, so no other thread competes with the realtime one
+            plan.threadCpus[idx].push_back(takeCpu(*core));
+            for (const auto cpu : core->cpus)
+                usedCpus.insert(cpu);
+            core->usedCount = core->cpus.size();
+            core->exclusive = true;
+            smtExclusive = true;
+        } else {
+            // realtime threads end up here as well if there is no free physical core left
+            if (core == nullptr)
+                core = findCore(clusterLlc[cluster], false);
+            if (core != nullptr)
+                plan.threadCpus[idx].push_back(takeCpu(*core));
+        }
+
+        QVariantHash desc;
+        desc.insert("realtime", thread.realtime);
+        desc.insert("cpus", cpuVectorToVariant(plan.threadCpus[idx]));
+        if (core != nullptr) {
+            if (clusterLlc[cluster] == INT_MIN)
+                clusterLlc[cluster] = core->llcId;
+            desc.insert("llc", core->llcId);
+            desc.insert("numa_node", core->numaNode);
+            desc.insert("smt_exclusive", smtExclusive);
+        }
+        threadsDesc.insert(thread.name, desc);
+    }
+
+    // give the remaining cores to the main thread
+    // NOTE: A lot of threads & tasks will still fork off the main thread, so this is well-invested
+    if (m_pinMainThread) {
+        for (const auto &core : cores) {
+            for (const auto cpu : core.cpus) {
+                if (!usedCpus.contains(cpu))
+                    plan.mainThreadCpus.push_back(cpu);
+            }
+        }
+    }
+
+    QVariantHash topoDesc;
+    topoDesc.insert("cpus", static_cast<int>(m_topology.cpus().size()));
+    topoDesc.insert("physical_cores", m_topology.physicalCoreCount());
+    topoDesc.insert("llc_domains", m_topology.llcDomainCount());
+    topoDesc.insert("numa_nodes", m_topology.numaNodeCount());
+    QVariantList isolated;
+    for (const auto cpu : m_topology.isolatedCpus())
+        isolated.append(static_cast<int>(cpu));
+    topoDesc.insert("isolated", isolated);
+
+    QVariantList linksDesc;
+    for (const auto &link : m_links) {
+        QVariantHash desc;
+        desc.insert("producer", m_threads[link.producer].name);
+        desc.insert("consumer", m_threads[link.consumer].name);
+        desc.insert("weight", link.weight);
+        linksDesc.append(desc);
+    }
+
+    plan.description.insert("topology", topoDesc);
+    plan.description.insert("main_thread", cpuVectorToVariant(plan.mainThreadCpus));
+    plan.description.insert("threads", threadsDesc);
+    plan.description.insert("links", linksDesc);
+
+    return plan;
+}
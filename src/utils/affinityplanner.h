@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QVariantHash>
+#include <vector>
+
+/**
+ * @brief Topology information about a single logical CPU
+ */
+struct CpuInfo {
+    uint cpu;
+    int coreId;   /// ID of the physical core (the lowest CPU of all its SMT siblings)
+    int packageId;
+    int numaNode;
+    int llcId; /// ID of the last-level cache domain (the lowest CPU sharing that cache)
+};
+
+/**
+ * @brief Layout of the CPUs of this system
+ */
+class CpuTopology
+{
+public:
+    explicit CpuTopology();
+
+    static CpuTopology fromSysfs(const QString &cpuRoot = QStringLiteral("/sys/devices/system/cpu"));
+    static CpuTopology flat(int cpuCount);
+
+    bool isEmpty() const;
+    QList<CpuInfo> cpus() const;
+    QList<uint> isolatedCpus() const;
+    bool isIsolated(uint cpu) const;
+
+    int physicalCoreCount() const;
+    int llcDomainCount() const;
+    int numaNodeCount() const;
+
+private:
+    QList<CpuInfo> m_cpus;
+    QSet<uint> m_isolated;
+};
+
+QList<uint> parseCpuList(const QString &list);
+
+/**
+ * @brief Result of a core affinity planning run
+ */
+struct AffinityPlan {
+    std::vector<std::vector<uint>> threadCpus; /// CPUs for each thread, empty if it could not be placed
+    std::vector<uint> mainThreadCpus;
+    QVariantHash description;
+};
+
+/**
+ * @brief Plans which threads are pinned to which CPU cores
+ *
+ * Places threads on the CPUs of a CpuTopology, so that threads which exchange a lot
+ * of data share a last-level cache, realtime threads get a physical core without busy
+ * SMT siblings, and CPUs isolated from the scheduler are left alone.
+ */
+class CoreAffinityPlanner
+{
+public:
+    explicit CoreAffinityPlanner(const CpuTopology &topology);
+
+    int addThread(const QString &name, bool realtime, bool required = false);
+    void addLink(int producer, int consumer, double weight);
+    void setPinMainThread(bool pin);
+
+    AffinityPlan plan() const;
+
+private:
+    struct ThreadRequest {
+        QString name;
+        bool realtime;
+        bool required;
+    };
+    struct Link {
+        int producer;
+        int consumer;
+        double weight;
+    };
+
+    CpuTopology m_topology;
+    std::vector<ThreadRequest> m_threads;
+    std::vector<Link> m_links;
+    bool m_pinMainThread;
+};
@@ -0,0 +1,108 @@
+
+#include <QtTest>
+
+#include "utils/affinityplanner.h"
+
+static void writeSysfsFile(const QString &fname, const QString &value)
+{
+    QDir().mkpath(QFileInfo(fname).absolutePath());
+    QFile f(fname);
+    QVERIFY(f.open(QIODevice::WriteOnly));
+    f.write(value.toUtf8() + "\n");
+}
+
+/**
+ * Create a fake sysfs CPU tree with two cache domains of two physical cores each,
+ * every core having two SMT siblings, with the last core isolated.
+ */
+static void createFakeSysfs(const QString &root)
+{
+    writeSysfsFile(root + "/online", "0-7");
+    writeSysfsFile(root + "/isolated", "3,7");
+    for (int cpu = 0; cpu < 8; cpu++) {
+        const auto base = QStringLiteral("%1/cpu%2").arg(root).arg(cpu);
+        const auto core = cpu % 4;
+        writeSysfsFile(base + "/topology/thread_siblings_list", QStringLiteral("%1,%2").arg(core).arg(core + 4));
+        writeSysfsFile(base + "/topology/physical_package_id", "0");
+        QDir().mkpath(base + "/node0");
+
+        writeSysfsFile(base + "/cache/index0/level", "1");
+        writeSysfsFile(base + "/cache/index0/type", "Data");
+        writeSysfsFile(base + "/cache/index0/shared_cpu_list", QStringLiteral("%1,%2").arg(core).arg(core + 4));
+        writeSysfsFile(base + "/cache/index1/level", "1");
+        writeSysfsFile(base + "/cache/index1/type", "Instruction");
+        writeSysfsFile(base + "/cache/index1/shared_cpu_list", QStringLiteral("%1,%2").arg(core).arg(core + 4));
+        writeSysfsFile(base + "/cache/index2/level", "3");
+        writeSysfsFile(base + "/cache/index2/type", "Unified");
+        writeSysfsFile(base + "/cache/index2/shared_cpu_list", core < 2 ? "0-1,4-5" : "2-3,6-7");
+    }
+}
+
+class TestAffinityPlanner : public QObject
+{
+    Q_OBJECT
+private slots:
+    void runParseCpuList()
+    {
+        QCOMPARE(parseCpuList("0-3,8,10-11"), QList<uint>() << 0 << 1 << 2 << 3 << 8 << 10 << 11);
+        QCOMPARE(parseCpuList(""), QList<uint>());
+        QCOMPARE(parseCpuList("5\n"), QList<uint>() << 5);
+    }
+
+    void runReadTopology()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        createFakeSysfs(dir.path());
+
+        const auto topo = CpuTopology::fromSysfs(dir.path());
+        QCOMPARE(topo.cpus().size(), 8);
+        QCOMPARE(topo.physicalCoreCount(), 4);
+        QCOMPARE(topo.llcDomainCount(), 2);
+        QCOMPARE(topo.numaNodeCount(), 1);
+        QCOMPARE(topo.isolatedCpus(), QList<uint>() << 3 << 7);
+        QCOMPARE(topo.cpus()[5].coreId, 1);
+        QCOMPARE(topo.cpus()[6].llcId, 2);
+    }
+
+    void runPlanAffinities()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        createFakeSysfs(dir.path());
+
+        CoreAffinityPlanner planner(CpuTopology::fromSysfs(dir.path()));
+        planner.setPinMainThread(true);
+        const auto camera = planner.addThread("camera", false);
+        const auto recorder = planner.addThread("recorder", false);
+        const auto daq = planner.addThread("daq", true);
+        const auto other = planner.addThread("other", false);
+        planner.addLink(camera, recorder, 10);
+        planner.addLink(daq, other, 0);
+
+        const auto plan = planner.plan();
+        QCOMPARE(plan.threadCpus.size(), (size_t)4);
+
+        // every thread got exactly one CPU, and nobody got an isolated one
+        QSet<uint> used(plan.mainThreadCpus.begin(), plan.mainThreadCpus.end());
+        for (const auto &cpus : plan.threadCpus) {
+            QCOMPARE(cpus.size(), (size_t)1);
+            QVERIFY(cpus[0] != 3 && cpus[0] != 7);
+            used.insert(cpus[0]);
+        }
+
+        // the realtime thread has a physical core for itself
+        const auto daqCpu = plan.threadCpus[daq][0];
+        QVERIFY(!used.contains(daqCpu < 4 ? daqCpu + 4 : daqCpu - 4));
+
+        // the camera and its recorder share a cache
+        const auto threads = plan.description["threads"].toHash();
+        QCOMPARE(threads["camera"].toHash()["llc"], threads["recorder"].toHash()["llc"]);
+        QVERIFY(threads["daq"].toHash()["smt_exclusive"].toBool());
+
+        QCOMPARE(plan.mainThreadCpus, std::vector<uint>{0});
+    }
+};
+
+QTEST_MAIN(TestAffinityPlanner)
+#include "test-affinityplanner.moc"
@@ -3,6 +3,7 @@
 #include <QtTest>
 #include <iostream>
 
+#include "datactl/edlindex.h"
 #include "datactl/edlstorage.h"
 #include "utils/misc.h"
 #include "utils/tomlutils.h"
@@ -125,6 +126,196 @@ private slots:
         QVERIFY2(collection->save(), qPrintable(collection->lastError()));
     }
 
+    void runEDLIncrementalSave()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        std::unique_ptr<EDLCollection> collection(new EDLCollection("test-incremental"));
+        collection->setRootPath(dir.path());
+        auto dset = collection->datasetByName("video", true);
+        dset->setDataFile("video_0.mkv", "Sliced video");
+        dset->addAuxDataFile("video.tsync", "tsync");
+        QVERIFY2(collection->save(), qPrintable(collection->lastError()));
+
+        // new parts are added to the existing manifest with every save
+        const auto manifestFname = QStringLiteral("%1/manifest.toml").arg(dset->path());
+        for (int i = 1; i < 20; ++i) {
+            dset->addDataFilePart(QStringLiteral("video_%1.mkv").arg(i));
+            QVERIFY2(dset->save(), qPrintable(dset->lastError()));
+        }
+
+        QString errorMessage;
+        auto manifest = parseTomlFile(manifestFname, errorMessage);
+        QVERIFY2(errorMessage.isEmpty(), qPrintable(errorMessage));
+        QCOMPARE(manifest["type"].toString(), QStringLiteral("dataset"));
+        QCOMPARE(manifest["data"].toHash()["summary"].toString(), QStringLiteral("Sliced video"));
+        QCOMPARE(manifest["data_aux"].toList().size(), 1);
+
+        auto parts = manifest["data"].toHash()["parts"].toList();
+        QCOMPARE(parts.size(), 20);
+        for (int i = 0; i < parts.size(); ++i) {
+            QCOMPARE(parts[i].toHash()["index"].toInt(), i);
+            QCOMPARE(parts[i].toHash()["fname"].toString(), QStringLiteral("video_%1.mkv").arg(i));
+        }
+
+        // a complete rewrite must yield the same manifest
+        dset->setTimeCreated(dset->timeCreated());
+        QVERIFY2(dset->save(), qPrintable(dset->lastError()));
+        QCOMPARE(parseTomlFile(manifestFname, errorMessage), manifest);
+
+        // saving in the background eventually writes changed attributes
+        dset->insertAttribute("frames", 1234);
+        dset->scheduleSave();
+        const auto attrsFname = QStringLiteral("%1/attributes.toml").arg(dset->path());
+        QTRY_VERIFY_WITH_TIMEOUT(QFileInfo::exists(attrsFname), 5000);
+        QTRY_COMPARE_WITH_TIMEOUT(parseTomlFile(attrsFname, errorMessage)["frames"].toInt(), 1234, 5000);
+    }
+
+    void runEDLScanPatternIncrementalSave()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        std::unique_ptr<EDLCollection> collection(new EDLCollection("test-scan-incremental"));
+        collection->setRootPath(dir.path());
+        auto dset = collection->datasetByName("video", true);
+        dset->setDataScanPattern("video_*", "Sliced video");
+        dset->addAuxDataScanPattern("video_*.tsync", "Video timestamps");
+        QVERIFY(QDir().mkpath(dset->path()));
+
+        const auto touchFile = [&](const QString &fname) {
+            QFile file(dset->pathForDataBasename(fname));
+            return file.open(QIODevice::WriteOnly);
+        };
+        QVERIFY(touchFile("video_timestamps.tsync"));
+        QVERIFY(touchFile("video_0.mkv"));
+        QVERIFY(touchFile("video_1.mkv"));
+        QVERIFY2(collection->save(), qPrintable(collection->lastError()));
+
+        // mark the manifest, so we can tell whether it was rewritten completely
+        const auto manifestFname = QStringLiteral("%1/manifest.toml").arg(dset->path());
+        const auto marker = QByteArrayLiteral("# full manifest write\n");
+        {
+            QFile file(manifestFname);
+            QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Append));
+            file.write(marker);
+        }
+        const auto manifestContains = [&](const QByteArray &data) {
+            QFile file(manifestFname);
+            return file.open(QIODevice::ReadOnly) && file.readAll().contains(data);
+        };
+
+        // slices which show up in later scans are appended to the manifest
+        for (int i = 2; i < 12; ++i) {
+            QVERIFY(touchFile(QStringLiteral("video_%1.mkv").arg(i)));
+            QVERIFY2(dset->save(), qPrintable(dset->lastError()));
+            QVERIFY(manifestContains(marker));
+        }
+
+        QString errorMessage;
+        auto manifest = parseTomlFile(manifestFname, errorMessage);
+        QVERIFY2(errorMessage.isEmpty(), qPrintable(errorMessage));
+        QCOMPARE(manifest["data_aux"].toList().size(), 1);
+        auto parts = manifest["data"].toHash()["parts"].toList();
+        QCOMPARE(parts.size(), 12);
+        for (int i = 0; i < parts.size(); ++i) {
+            QCOMPARE(parts[i].toHash()["index"].toInt(), i);
+            QCOMPARE(parts[i].toHash()["fname"].toString(), QStringLiteral("video_%1.mkv").arg(i));
+        }
+
+        // an unchanged scan result leaves the manifest alone
+        QVERIFY2(dset->save(), qPrintable(dset->lastError()));
+        QVERIFY(manifestContains(marker));
+
+        // if existing parts vanish, the manifest has to be written again
+        QVERIFY(QFile::remove(dset->pathForDataBasename("video_3.mkv")));
+        QVERIFY2(dset->save(), qPrintable(dset->lastError()));
+        QVERIFY(!manifestContains(marker));
+        manifest = parseTomlFile(manifestFname, errorMessage);
+        QVERIFY2(errorMessage.isEmpty(), qPrintable(errorMessage));
+        QCOMPARE(manifest["data"].toHash()["parts"].toList().size(), 11);
+    }
+
+    void runEDLCollectionIndex()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        const auto day1 = QDateTime(QDate(2024, 3, 1), QTime(10, 0, 0));
+        const auto day2 = QDateTime(QDate(2024, 3, 8), QTime(10, 0, 0));
+        for (const auto &time : {day1, day2}) {
+            std::unique_ptr<EDLCollection> collection(new EDLCollection(time.toString("yyyy-MM-dd")));
+            collection->setRootPath(dir.path());
+            collection->setTimeCreated(time);
+
+            auto group = collection->groupByName("videos", true);
+            auto video = group->datasetByName("top-camera", true);
+            video->setGeneratorId("camera-generic");
+            video->setTimeCreated(time);
+            video->setDataFile("video_0.mkv");
+            video->addDataFilePart("video_1.mkv");
+            auto ephys = collection->datasetByName("ephys", true);
+            ephys->setGeneratorId("intan-rhx");
+            ephys->setTimeCreated(time);
+            ephys->setDataFile("data.rhd");
+            QVERIFY2(collection->save(), qPrintable(collection->lastError()));
+
+            QFile dataFile(video->pathForDataPart(video->dataFile().parts.first()));
+            QVERIFY(dataFile.open(QIODevice::WriteOnly));
+            dataFile.write(QByteArray(100, 'x'));
+        }
+
+        EDLCollectionIndex index;
+        QCOMPARE(index.addDirectory(dir.path()), 2);
+        QCOMPARE(index.collections().size(), 2);
+
+        auto videos = index.findDatasets("camera-generic");
+        QCOMPARE(videos.size(), 2);
+        QCOMPARE(videos[0].path, QStringLiteral("videos/top-camera"));
+        QCOMPARE(videos[0].dataParts, QStringList() << "video_0.mkv" << "video_1.mkv");
+        QCOMPARE(videos[0].dataSize, qint64(100));
+        QVERIFY(!videos[0].collectionId.isNull());
+
+        auto ephys = index.findDatasets("intan-rhx", day1.addDays(1), day2.addDays(1));
+        QCOMPARE(ephys.size(), 1);
+        QCOMPARE(ephys[0].timeCreated, day2);
+
+        // a second index must read the cached data and yield the same result
+        const auto colPath = QStringLiteral("%1/%2").arg(dir.path(), day1.toString("yyyy-MM-dd"));
+        QVERIFY(QFileInfo::exists(QStringLiteral("%1/.edl-index.json").arg(colPath)));
+        EDLCollectionIndex cachedIndex;
+        cachedIndex.addDirectory(dir.path());
+        QCOMPARE(cachedIndex.findDatasets("camera-generic").size(), 2);
+
+        // data files growing in place must be reflected, even if the cached index is used
+        QFile grownFile(QStringLiteral("%1/videos/top-camera/video_0.mkv").arg(colPath));
+        QVERIFY(grownFile.open(QIODevice::Append));
+        grownFile.write(QByteArray(50, 'x'));
+        grownFile.close();
+        EDLCollectionIndex grownIndex;
+        auto grownInfo = grownIndex.collection(colPath);
+        QVERIFY2(grownInfo.has_value(), qPrintable(grownIndex.lastError()));
+        for (const auto &ds : grownInfo->datasets) {
+            if (ds.path == QStringLiteral("videos/top-camera"))
+                QCOMPARE(ds.dataSize, qint64(150));
+        }
+
+        // modifying a collection invalidates its cached index
+        std::unique_ptr<EDLCollection> collection(new EDLCollection(day1.toString("yyyy-MM-dd")));
+        collection->setRootPath(dir.path());
+        auto dset = collection->datasetByName("tracking", true);
+        dset->setGeneratorId("camera-generic");
+        dset->setDataFile("tracks.csv");
+        QVERIFY2(dset->save(), qPrintable(dset->lastError()));
+
+        EDLCollectionIndex updatedIndex;
+        auto info = updatedIndex.collection(colPath);
+        QVERIFY2(info.has_value(), qPrintable(updatedIndex.lastError()));
+        QCOMPARE(info->datasets.size(), 3);
+        QCOMPARE(info->groups, QStringList() << "videos");
+    }
+
     void runUtilsSortTest()
     {
         QStringList files;
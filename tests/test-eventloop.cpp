@@ -0,0 +1,422 @@
+
+#include <QtTest>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+#include "moduleeventscheduler.h"
+#include "moduleeventthread.h"
+#include "streams/stream.h"
+
+using namespace Syntalos;
+
+static const int N_OF_SUBSCRIPTIONS = 64;
+static const int N_OF_THROUGHPUT_ITEMS = 20000;
+static const int N_OF_LATENCY_SAMPLES = 500;
+static const int N_OF_EXCLUSIVE_MODULES = 8;
+static const int N_OF_EXCLUSIVE_ITEMS = 4000;
+
+/**
+ * Start barrier that lets the test release evented modules, like the engine does.
+ */
+class TestWaitCondition : public OptionalWaitCondition
+{
+public:
+    void startModules()
+    {
+        // wait for the event thread to reach its start barrier
+        while (waitingCount() == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        wakeAll();
+    }
+};
+
+class EventTestModule : public AbstractModule
+{
+public:
+    explicit EventTestModule(QObject *parent = nullptr)
+        : AbstractModule(parent),
+          received(0),
+          lastReceiveUsec(0),
+          timerCalls(0),
+          failOnTimer(false)
+    {
+    }
+
+    void addSubscription(std::shared_ptr<StreamSubscription<TableRow>> sub)
+    {
+        m_subs.push_back(sub);
+        registerDataReceivedEvent(&EventTestModule::onDataReceived, sub);
+    }
+
+    void addTimer(const milliseconds_t &interval)
+    {
+        registerTimedEvent(&EventTestModule::onTimer, interval);
+    }
+
+    std::atomic_int64_t received;
+    std::atomic_int64_t lastReceiveUsec;
+    std::atomic_int timerCalls;
+    bool failOnTimer;
+
+private:
+    std::vector<std::shared_ptr<StreamSubscription<TableRow>>> m_subs;
+
+    void onDataReceived()
+    {
+        for (auto &sub : m_subs) {
+            while (sub->peekNext().has_value())
+                received++;
+        }
+        lastReceiveUsec = std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+    }
+
+    void onTimer(int &)
+    {
+        timerCalls++;
+        if (failOnTimer)
+            raiseError(QStringLiteral("Failure requested by test"));
+    }
+};
+
+/**
+ * Module that records whether any of its callbacks ever ran concurrently.
+ */
+class ExclusiveTestModule : public AbstractModule
+{
+public:
+    explicit ExclusiveTestModule(QObject *parent = nullptr)
+        : AbstractModule(parent),
+          active(0),
+          overlaps(0),
+          received(0),
+          timerCalls(0)
+    {
+    }
+
+    void addSubscription(std::shared_ptr<StreamSubscription<TableRow>> sub, SubscriptionNotifyMode mode)
+    {
+        sub->setNotifyMode(mode, 16, microseconds_t(2000));
+        m_subs.push_back(sub);
+        registerDataReceivedEvent(&ExclusiveTestModule::onDataReceived, sub);
+    }
+
+    void addTimer(const milliseconds_t &interval)
+    {
+        registerTimedEvent(&ExclusiveTestModule::onTimer, interval);
+    }
+
+    std::atomic_int active;
+    std::atomic_int overlaps;
+    std::atomic_int64_t received;
+    std::atomic_int timerCalls;
+
+private:
+    std::vector<std::shared_ptr<StreamSubscription<TableRow>>> m_subs;
+
+    void enterCallback()
+    {
+        if (active.fetch_add(1) != 0)
+            overlaps++;
+        // stay in the callback for a bit, so other workers get a chance to run us concurrently
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+    }
+
+    void leaveCallback()
+    {
+        active--;
+    }
+
+    void onDataReceived()
+    {
+        enterCallback();
+        for (auto &sub : m_subs) {
+            while (sub->peekNext().has_value())
+                received++;
+        }
+        leaveCallback();
+    }
+
+    void onTimer(int &)
+    {
+        enterCallback();
+        timerCalls++;
+        leaveCallback();
+    }
+};
+
+/**
+ * Runs modules on a ModuleEventThread or on a ModuleEventScheduler, depending on the backend.
+ */
+class EventRunner
+{
+public:
+    explicit EventRunner(EventLoopBackend backend, const QString &name)
+    {
+        if (backend == EventLoopBackend::WORK_STEALING) {
+            m_scheduler = std::make_unique<ModuleEventScheduler>(4);
+        } else {
+            m_thread = std::make_unique<ModuleEventThread>(name);
+            m_thread->setBackend(backend);
+        }
+    }
+
+    void run(const QList<AbstractModule *> &mods, OptionalWaitCondition *waitCondition)
+    {
+        if (m_scheduler)
+            m_scheduler->run(mods, waitCondition);
+        else
+            m_thread->run(mods, waitCondition);
+    }
+
+    void stop()
+    {
+        if (m_scheduler)
+            m_scheduler->stop();
+        else
+            m_thread->stop();
+    }
+
+    bool isFailed() const
+    {
+        return m_scheduler ? m_scheduler->isFailed() : m_thread->isFailed();
+    }
+
+    QObject *executor() const
+    {
+        return m_scheduler ? static_cast<QObject *>(m_scheduler.get()) : static_cast<QObject *>(m_thread.get());
+    }
+
+private:
+    std::unique_ptr<ModuleEventThread> m_thread;
+    std::unique_ptr<ModuleEventScheduler> m_scheduler;
+};
+
+static int64_t steadyUsec()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+class TestEventLoop : public QObject
+{
+    Q_OBJECT
+private:
+    void addBackendRows()
+    {
+        QTest::addColumn<int>("backend");
+        QTest::newRow("glib") << static_cast<int>(EventLoopBackend::GLIB);
+        QTest::newRow("epoll") << static_cast<int>(EventLoopBackend::EPOLL);
+        QTest::newRow("work-stealing") << static_cast<int>(EventLoopBackend::WORK_STEALING);
+    }
+
+private slots:
+    void runTimerEvents_data()
+    {
+        addBackendRows();
+    }
+
+    void runTimerEvents()
+    {
+        QFETCH(int, backend);
+
+        EventTestModule mod;
+        mod.addTimer(milliseconds_t(10));
+
+        TestWaitCondition waitCondition;
+        EventRunner evThread(static_cast<EventLoopBackend>(backend), QStringLiteral("test-timer"));
+        evThread.run(QList<AbstractModule *>() << &mod, &waitCondition);
+        waitCondition.startModules();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        evThread.stop();
+
+        // we make no guarantees about exact timing, but the timer must have run at about the right rate
+        QVERIFY2(mod.timerCalls >= 10, qPrintable(QString::number(mod.timerCalls)));
+        QVERIFY2(mod.timerCalls <= 22, qPrintable(QString::number(mod.timerCalls)));
+    }
+
+    void runModuleFailure_data()
+    {
+        addBackendRows();
+    }
+
+    void runModuleFailure()
+    {
+        QFETCH(int, backend);
+
+        EventTestModule mod;
+        mod.failOnTimer = true;
+        mod.addTimer(milliseconds_t(5));
+
+        TestWaitCondition waitCondition;
+        EventRunner evThread(static_cast<EventLoopBackend>(backend), QStringLiteral("test-failure"));
+        QSignalSpy failedSpy(evThread.executor(), SIGNAL(failed()));
+        evThread.run(QList<AbstractModule *>() << &mod, &waitCondition);
+        waitCondition.startModules();
+
+        // the failing module must be reported exactly once, and must not be called again
+        const auto startUsec = steadyUsec();
+        while (!evThread.isFailed() && steadyUsec() - startUsec < 2000 * 1000)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        evThread.stop();
+
+        QVERIFY(evThread.isFailed());
+        QCOMPARE(failedSpy.count(), 1);
+        QCOMPARE(mod.timerCalls.load(), 1);
+    }
+
+    void runDispatchLatency_data()
+    {
+        addBackendRows();
+    }
+
+    void runDispatchLatency()
+    {
+        QFETCH(int, backend);
+
+        DataStream<TableRow> stream;
+        EventTestModule mod;
+        mod.addSubscription(stream.subscribe());
+        stream.start();
+
+        TestWaitCondition waitCondition;
+        EventRunner evThread(static_cast<EventLoopBackend>(backend), QStringLiteral("test-latency"));
+        evThread.run(QList<AbstractModule *>() << &mod, &waitCondition);
+        waitCondition.startModules();
+
+        std::vector<int64_t> latencies;
+        latencies.reserve(N_OF_LATENCY_SAMPLES);
+        TableRow row;
+        for (int i = 0; i < N_OF_LATENCY_SAMPLES; i++) {
+            const auto sendUsec = steadyUsec();
+            stream.push(row);
+            while (mod.received <= i) {
+                QVERIFY(steadyUsec() - sendUsec < 1000 * 1000);
+                std::this_thread::yield();
+            }
+            latencies.push_back(mod.lastReceiveUsec - sendUsec);
+        }
+        evThread.stop();
+        stream.stop();
+
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << "Dispatch latency (" << QTest::currentDataTag()
+                  << "): median=" << latencies[latencies.size() / 2] << "µs"
+                  << " p99=" << latencies[latencies.size() * 99 / 100] << "µs" << std::endl;
+    }
+
+    void runDispatchThroughput_data()
+    {
+        addBackendRows();
+    }
+
+    void runDispatchThroughput()
+    {
+        QFETCH(int, backend);
+
+        std::vector<std::unique_ptr<DataStream<TableRow>>> streams;
+        std::vector<std::unique_ptr<EventTestModule>> mods;
+        QList<AbstractModule *> modList;
+        for (int i = 0; i < N_OF_SUBSCRIPTIONS; i++) {
+            streams.push_back(std::make_unique<DataStream<TableRow>>());
+            mods.push_back(std::make_unique<EventTestModule>());
+            mods.back()->addSubscription(streams.back()->subscribe());
+            streams.back()->start();
+            modList.append(mods.back().get());
+        }
+
+        TestWaitCondition waitCondition;
+        EventRunner evThread(static_cast<EventLoopBackend>(backend), QStringLiteral("test-throughput"));
+        evThread.run(modList, &waitCondition);
+        waitCondition.startModules();
+
+        const auto startUsec = steadyUsec();
+        TableRow row;
+        for (int i = 0; i < N_OF_THROUGHPUT_ITEMS; i++)
+            streams[i % N_OF_SUBSCRIPTIONS]->push(row);
+
+        int64_t total = 0;
+        while (total < N_OF_THROUGHPUT_ITEMS) {
+            QVERIFY(steadyUsec() - startUsec < 30 * 1000 * 1000);
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            total = 0;
+            for (const auto &mod : mods)
+                total += mod->received;
+        }
+        const auto elapsedUsec = steadyUsec() - startUsec;
+        evThread.stop();
+        for (auto &stream : streams)
+            stream->stop();
+
+        std::cout << "Dispatch throughput (" << QTest::currentDataTag() << ", " << N_OF_SUBSCRIPTIONS
+                  << " subscriptions): " << (N_OF_THROUGHPUT_ITEMS * 1000.0 / elapsedUsec) << " items/ms" << std::endl;
+    }
+
+    void runWorkStealingExclusive()
+    {
+        // modules using different notify modes and timers, with data arriving from several threads
+        std::vector<std::unique_ptr<DataStream<TableRow>>> streams;
+        std::vector<std::unique_ptr<ExclusiveTestModule>> mods;
+        QList<AbstractModule *> modList;
+        for (int i = 0; i < N_OF_EXCLUSIVE_MODULES; i++) {
+            mods.push_back(std::make_unique<ExclusiveTestModule>());
+            for (const auto mode : {SubscriptionNotifyMode::Coalesced, SubscriptionNotifyMode::Batched}) {
+                streams.push_back(std::make_unique<DataStream<TableRow>>());
+                mods.back()->addSubscription(streams.back()->subscribe(), mode);
+                streams.back()->start();
+            }
+            mods.back()->addTimer(milliseconds_t(2));
+            modList.append(mods.back().get());
+        }
+
+        TestWaitCondition waitCondition;
+        ModuleEventScheduler scheduler(4);
+        scheduler.run(modList, &waitCondition);
+        waitCondition.startModules();
+
+        std::vector<std::thread> producers;
+        const int producerCount = 4;
+        for (int p = 0; p < producerCount; p++) {
+            producers.emplace_back([&, p]() {
+                TableRow row;
+                for (int i = 0; i < N_OF_EXCLUSIVE_ITEMS; i++) {
+                    streams[(p + i * producerCount) % streams.size()]->push(row);
+                    if (i % 64 == 0)
+                        std::this_thread::sleep_for(std::chrono::microseconds(200));
+                }
+            });
+        }
+        for (auto &t : producers)
+            t.join();
+
+        // the last items of batched subscriptions only arrive once their latency window expired
+        const auto startUsec = steadyUsec();
+        int64_t total = 0;
+        while (total < N_OF_EXCLUSIVE_ITEMS * producerCount) {
+            QVERIFY2(steadyUsec() - startUsec < 30 * 1000 * 1000, qPrintable(QString::number(total)));
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            total = 0;
+            for (const auto &mod : mods)
+                total += mod->received;
+        }
+        scheduler.stop();
+        for (auto &stream : streams)
+            stream->stop();
+
+        QCOMPARE(total, (int64_t)N_OF_EXCLUSIVE_ITEMS * producerCount);
+        QVERIFY(!scheduler.isFailed());
+        for (const auto &mod : mods) {
+            QCOMPARE(mod->overlaps.load(), 0);
+            QVERIFY(mod->timerCalls > 0);
+        }
+    }
+};
+
+QTEST_MAIN(TestEventLoop)
+#include "test-eventloop.moc"
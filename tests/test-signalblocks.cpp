@@ -0,0 +1,155 @@
+#include <QDebug>
+#include <QtTest>
+#include <array>
+
+#include "datactl/datatypes.h"
+
+using namespace Syntalos;
+
+static FloatSignalBlock createFloatBlock(uint sampleCount, uint channelCount)
+{
+    FloatSignalBlock block(sampleCount, channelCount);
+    for (uint i = 0; i < sampleCount; ++i) {
+        block.timestamps[i] = 1000 + i * 50;
+        for (uint j = 0; j < channelCount; ++j)
+            block.data(i, j) = (i * 0.195) - j;
+    }
+    return block;
+}
+
+static IntSignalBlock createIntBlock(uint sampleCount, uint channelCount)
+{
+    IntSignalBlock block(sampleCount, channelCount);
+    for (uint i = 0; i < sampleCount; ++i) {
+        block.timestamps[i] = 1000 + i * 50;
+        for (uint j = 0; j < channelCount; ++j)
+            block.data(i, j) = (i % 2 == 0) ? j : -j;
+    }
+    return block;
+}
+
+/**
+ * The previous serialization format, for comparison.
+ */
+template<typename T>
+static QByteArray serializeBlockQDataStream(const T &block)
+{
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    serializeEigen(stream, block.timestamps);
+    serializeEigen(stream, block.data);
+    return bytes;
+}
+
+class TestSignalBlocks : public QObject
+{
+    Q_OBJECT
+private slots:
+    void runFloatRoundtrip()
+    {
+        const auto block = createFloatBlock(2048, 16);
+
+        QByteArray memory(block.memorySize(), Qt::Uninitialized);
+        QVERIFY(block.writeToMemory(memory.data(), memory.size()));
+        const auto result = FloatSignalBlock::fromMemory(memory.constData(), memory.size());
+        QCOMPARE(result.timestamps, block.timestamps);
+        QCOMPARE(result.data, block.data);
+
+        // data serialized via toBytes() must be readable too
+        const auto bytes = block.toBytes();
+        QCOMPARE(bytes.size(), (int)block.memorySize());
+        const auto result2 = FloatSignalBlock::fromMemory(bytes.constData(), bytes.size());
+        QCOMPARE(result2.data, block.data);
+    }
+
+    void runIntRoundtrip()
+    {
+        const auto block = createIntBlock(60, 8);
+
+        QByteArray memory(block.memorySize(), Qt::Uninitialized);
+        QVERIFY(block.writeToMemory(memory.data(), memory.size()));
+        const auto result = IntSignalBlock::fromMemory(memory.constData(), memory.size());
+        QCOMPARE(result.timestamps, block.timestamps);
+        QCOMPARE(result.data, block.data);
+        QCOMPARE(result.rows(), (size_t)60);
+        QCOMPARE(result.cols(), (size_t)8);
+    }
+
+    void runFloat32Roundtrip()
+    {
+        Float32SignalBlock block(128, 4);
+        for (uint i = 0; i < 128; ++i) {
+            block.timestamps[i] = i;
+            for (uint j = 0; j < 4; ++j)
+                block.data(i, j) = 0.195F * (float(i) - 32768.0F) + j;
+        }
+
+        const auto bytes = block.toBytes();
+        QCOMPARE(bytes.size(), (int)block.memorySize());
+        const auto result = Float32SignalBlock::fromMemory(bytes.constData(), bytes.size());
+        QCOMPARE(result.timestamps, block.timestamps);
+        QCOMPARE(result.data, block.data);
+
+        const auto f64Block = result.toFloatSignalBlock();
+        QCOMPARE(f64Block.timestamps, block.timestamps);
+        QCOMPARE(f64Block.data, block.data.cast<double>().eval());
+    }
+
+    void runEdgeCases()
+    {
+        // a block without timestamps, as created from a plain vector
+        const FloatSignalBlock vecBlock(std::vector<float>{1.5, 2.5, 3.5}, 42);
+        auto bytes = vecBlock.toBytes();
+        const auto vecResult = FloatSignalBlock::fromMemory(bytes.constData(), bytes.size());
+        QCOMPARE(vecResult.data, vecBlock.data);
+        QCOMPARE(vecResult.length(), vecBlock.length());
+
+        // writing to a too small buffer must fail
+        const auto block = createIntBlock(60, 4);
+        QByteArray memory(block.memorySize() - 1, Qt::Uninitialized);
+        QVERIFY(!block.writeToMemory(memory.data(), memory.size()));
+
+        // reading truncated data must not crash, and return an empty block
+        bytes = block.toBytes();
+        const auto truncResult = IntSignalBlock::fromMemory(bytes.constData(), bytes.size() / 2);
+        QCOMPARE(truncResult.length(), (size_t)0);
+
+        // header values whose byte sizes wrap around must be rejected
+        for (const auto &header : {
+                 std::array<quint64, 3>{(1ULL << 61) + 1, 1, 1},
+                 std::array<quint64, 3>{0, 1ULL << 32, 1ULL << 32},
+                 std::array<quint64, 3>{0, 1ULL << 62, 1}}) {
+            QByteArray forged(reinterpret_cast<const char *>(header.data()), sizeof(quint64) * header.size());
+            forged.append(QByteArray(64, '\0'));
+            const auto forgedResult = IntSignalBlock::fromMemory(forged.constData(), forged.size());
+            QCOMPARE(forgedResult.length(), (size_t)0);
+        }
+    }
+
+    void benchFloatQDataStream()
+    {
+        const auto block = createFloatBlock(2048, 16);
+        QBENCHMARK {
+            const auto bytes = serializeBlockQDataStream(block);
+            QByteArray copy(bytes.constData(), bytes.size());
+            QDataStream stream(copy);
+            auto timestamps = deserializeEigen<VectorXul>(stream);
+            auto data = deserializeEigen<MatrixXd>(stream);
+            QCOMPARE(data.rows(), block.data.rows());
+        }
+    }
+
+    void benchFloatMemory()
+    {
+        const auto block = createFloatBlock(2048, 16);
+        QByteArray memory(block.memorySize(), Qt::Uninitialized);
+        QBENCHMARK {
+            block.writeToMemory(memory.data(), memory.size());
+            const auto result = FloatSignalBlock::fromMemory(memory.constData(), memory.size());
+            QCOMPARE(result.data.rows(), block.data.rows());
+        }
+    }
+};
+
+QTEST_MAIN(TestSignalBlocks)
+#include "test-signalblocks.moc"
@@ -0,0 +1,120 @@
+#include <QDebug>
+#include <QtTest>
+#include <cstring>
+#include <random>
+
+#include "datactl/signalconv.h"
+
+using namespace Syntalos;
+
+/**
+ * The previous per-channel conversion of the Intan module, for comparison.
+ */
+static void convertRawPerChannel(
+    const uint16_t *rawBuf,
+    size_t numSamples,
+    int numAmplifierChannels,
+    const std::vector<int> &rawIndices,
+    std::vector<std::vector<double>> &columns)
+{
+    for (size_t ch = 0; ch < rawIndices.size(); ++ch) {
+        for (size_t i = 0; i < numSamples; ++i)
+            columns[ch][i] = 0.195F * (((double)rawBuf[numAmplifierChannels * i + rawIndices[ch]]) - 32768.0F);
+    }
+}
+
+static std::vector<uint16_t> createRawData(size_t numSamples, size_t numChannels)
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 0xFFFF);
+    std::vector<uint16_t> raw(numSamples * numChannels);
+    for (auto &v : raw)
+        v = static_cast<uint16_t>(dist(gen));
+
+    // ensure the extreme values are present
+    raw[0] = 0;
+    raw[1] = 0xFFFF;
+    raw[2] = 32768;
+    return raw;
+}
+
+static void verifyConversion(size_t numSamples, int numAmplifierChannels, const std::vector<int> &rawIndices)
+{
+    const auto raw = createRawData(numSamples, numAmplifierChannels);
+
+    std::vector<std::vector<double>> expected(rawIndices.size(), std::vector<double>(numSamples));
+    convertRawPerChannel(raw.data(), numSamples, numAmplifierChannels, rawIndices, expected);
+
+    std::vector<std::vector<double>> result(rawIndices.size(), std::vector<double>(numSamples));
+    std::vector<double *> columns;
+    for (auto &col : result)
+        columns.push_back(col.data());
+    convertInterleavedRawToMicrovolts(
+        raw.data(), numSamples, numAmplifierChannels, rawIndices.data(), columns.data(), columns.size());
+
+    for (size_t ch = 0; ch < rawIndices.size(); ++ch)
+        QVERIFY(std::memcmp(expected[ch].data(), result[ch].data(), numSamples * sizeof(double)) == 0);
+}
+
+class TestSignalConv : public QObject
+{
+    Q_OBJECT
+private slots:
+    void runBitExact()
+    {
+        // all channels, in order
+        std::vector<int> indices(128);
+        for (int i = 0; i < 128; ++i)
+            indices[i] = i;
+        verifyConversion(128, 128, indices);
+
+        // sample counts that are not a multiple of any tile or vector size
+        verifyConversion(1, 128, indices);
+        verifyConversion(61, 128, indices);
+        verifyConversion(1003, 128, indices);
+
+        // more channels than fit in one tile
+        std::vector<int> manyIndices(300);
+        for (int i = 0; i < 300; ++i)
+            manyIndices[i] = 299 - i;
+        verifyConversion(67, 300, manyIndices);
+
+        // a sparse, unordered selection of channels
+        verifyConversion(257, 64, {63, 0, 17, 5, 42});
+    }
+
+    void benchPerChannel()
+    {
+        const size_t numSamples = 640;
+        const auto raw = createRawData(numSamples, 128);
+        std::vector<int> indices(128);
+        for (int i = 0; i < 128; ++i)
+            indices[i] = i;
+        std::vector<std::vector<double>> columns(indices.size(), std::vector<double>(numSamples));
+
+        QBENCHMARK {
+            convertRawPerChannel(raw.data(), numSamples, 128, indices, columns);
+        }
+    }
+
+    void benchInterleaved()
+    {
+        const size_t numSamples = 640;
+        const auto raw = createRawData(numSamples, 128);
+        std::vector<int> indices(128);
+        for (int i = 0; i < 128; ++i)
+            indices[i] = i;
+        std::vector<std::vector<double>> result(indices.size(), std::vector<double>(numSamples));
+        std::vector<double *> columns;
+        for (auto &col : result)
+            columns.push_back(col.data());
+
+        QBENCHMARK {
+            convertInterleavedRawToMicrovolts(
+                raw.data(), numSamples, 128, indices.data(), columns.data(), columns.size());
+        }
+    }
+};
+
+QTEST_MAIN(TestSignalConv)
+#include "test-signalconv.moc"
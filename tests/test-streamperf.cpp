@@ -171,6 +171,148 @@ static void consumer_instant(const std::string &threadName, Barrier *barrier, Da
     }
 }
 
+static void producer_signals(DataStream<FloatSignalBlock> *stream, bool shared)
+{
+    for (size_t i = 1; i <= N_OF_DATAFRAMES; ++i) {
+        FloatSignalBlock block(2048, 1);
+        block.timestamps.setConstant(i);
+        block.data.setConstant(i * 0.195);
+
+        if (shared)
+            stream->pushShared(std::make_shared<const FloatSignalBlock>(std::move(block)));
+        else
+            stream->push(block);
+    }
+    stream->terminate();
+}
+
+static void consumer_signals(Barrier *barrier, DataStream<FloatSignalBlock> *stream, bool shared, size_t *received)
+{
+    size_t count = 0;
+
+    auto sub = stream->subscribe();
+    barrier->wait();
+    while (true) {
+        quint64 firstTs;
+        if (shared) {
+            auto data = sub->nextShared();
+            if (data == nullptr)
+                break; // subscription has been terminated
+            firstTs = data->timestamps[0];
+        } else {
+            auto data = sub->next();
+            if (!data.has_value())
+                break; // subscription has been terminated
+            firstTs = data->timestamps[0];
+        }
+
+        if (firstTs != count + 1)
+            std::cout << "Value dropped (signal consumer) [" << firstTs << "]" << std::endl;
+        count++;
+    }
+
+    *received = count;
+}
+
+static void run_signal_fanout(bool shared, StreamBackend backend = StreamBackend::SubscriberQueues)
+{
+    const uint consumerCount = 3;
+    Barrier barrier(consumerCount + 1);
+    std::vector<std::thread> threads;
+    std::vector<size_t> received(consumerCount, 0);
+    std::shared_ptr<DataStream<FloatSignalBlock>> stream(new DataStream<FloatSignalBlock>());
+    stream->setBackend(backend);
+
+    for (uint i = 0; i < consumerCount; ++i)
+        threads.push_back(std::thread(consumer_signals, &barrier, stream.get(), shared, &received[i]));
+
+    barrier.wait();
+    stream->start();
+    producer_signals(stream.get(), shared);
+
+    for (auto &t : threads)
+        t.join();
+    for (const auto &count : received)
+        QCOMPARE(count, (size_t)N_OF_DATAFRAMES);
+}
+
+static void run_small_items(bool batched)
+{
+    const size_t itemCount = 500000;
+    std::shared_ptr<DataStream<FirmataData>> stream(new DataStream<FirmataData>());
+    auto sub = stream->subscribe();
+    stream->start();
+
+    std::thread consumer([&]() {
+        size_t count = 0;
+        if (batched) {
+            std::vector<FirmataData> batch;
+            batch.reserve(256);
+            while (true) {
+                batch.clear();
+                if (sub->nextBatch(batch, 256) == 0 && !sub->active())
+                    break;
+                count += batch.size();
+            }
+        } else {
+            while (sub->next().has_value())
+                count++;
+        }
+
+        if (count != itemCount)
+            std::cout << "Small-item consumer received only " << count << " elements out of " << itemCount
+                      << std::endl;
+    });
+
+    FirmataData data;
+    data.pinId = 2;
+    data.isDigital = true;
+    for (size_t i = 0; i < itemCount; ++i) {
+        data.value = i % 2;
+        data.time = microseconds_t(i);
+        stream->push(data);
+    }
+    stream->terminate();
+    consumer.join();
+}
+
+static void run_small_items_fanout(StreamBackend backend)
+{
+    const size_t itemCount = 200000;
+    const uint consumerCount = 4;
+    std::shared_ptr<DataStream<FirmataData>> stream(new DataStream<FirmataData>());
+    stream->setBackend(backend);
+
+    std::vector<std::shared_ptr<StreamSubscription<FirmataData>>> subs;
+    for (uint i = 0; i < consumerCount; ++i)
+        subs.push_back(stream->subscribe());
+    stream->start();
+
+    std::vector<size_t> received(consumerCount, 0);
+    std::vector<std::thread> threads;
+    for (uint i = 0; i < consumerCount; ++i) {
+        threads.push_back(std::thread([&, i]() {
+            while (subs[i]->next().has_value())
+                received[i]++;
+        }));
+    }
+
+    FirmataData data;
+    data.pinId = 2;
+    data.isDigital = true;
+    for (size_t i = 0; i < itemCount; ++i) {
+        data.value = i % 2;
+        data.time = microseconds_t(i);
+        stream->push(data);
+    }
+    stream->terminate();
+
+    for (auto &t : threads)
+        t.join();
+    for (const auto &count : received)
+        QCOMPARE(count, itemCount);
+}
+
 static void transformer_fast(
     const std::string &threadName,
     Barrier *barrier,
@@ -255,6 +397,114 @@ private slots:
                 t.join();
         }
     }
+
+    void runPendingBytes()
+    {
+        DataStream<FloatSignalBlock> stream;
+        auto sub = stream.subscribe();
+        stream.start();
+
+        // pending memory is estimated from the reported size of pushed elements
+        FloatSignalBlock block(1000, 8);
+        for (int i = 0; i < 3; i++)
+            stream.push(block);
+        QCOMPARE(sub->approxPendingBytes(), 3 * static_cast<size_t>(block.memorySize()));
+
+        sub->next();
+        QCOMPARE(sub->approxPendingBytes(), 2 * static_cast<size_t>(block.memorySize()));
+        stream.stop();
+    }
+
+    void runRingForcedEndMarker()
+    {
+        DataStream<FirmataData> stream;
+        stream.setBackend(StreamBackend::SharedRing);
+        auto sub = stream.subscribe();
+        stream.start();
+
+        // a forced end marker must arrive after the data that was pushed before it, like with subscriber queues
+        FirmataData data;
+        for (int i = 0; i < 3; i++) {
+            data.value = i;
+            stream.push(data);
+            if (i == 1)
+                sub->forcePushNullopt();
+        }
+
+        QCOMPARE(sub->peekNext()->value, (uint16_t)0);
+        QCOMPARE(sub->peekNext()->value, (uint16_t)1);
+        QVERIFY(!sub->peekNext().has_value());
+        QCOMPARE(sub->peekNext()->value, (uint16_t)2);
+        stream.stop();
+    }
+
+    void runDrainIntoCount()
+    {
+        DataStream<FirmataData> stream;
+        auto sub = stream.subscribe();
+        stream.start();
+
+        FirmataData data;
+        stream.push(data);
+        stream.push(data);
+        sub->forcePushNullopt();
+
+        // the end-of-stream marker is consumed, but not counted as processed element
+        size_t calls = 0;
+        QCOMPARE(sub->drainInto([&](const FirmataData &) { calls++; }), (size_t)2);
+        QCOMPARE(calls, (size_t)2);
+        QCOMPARE(sub->approxPendingCount(), (size_t)0);
+        stream.stop();
+    }
+
+    void runSmallItemsSingle()
+    {
+        QBENCHMARK {
+            run_small_items(false);
+        }
+    }
+
+    void runSmallItemsBatched()
+    {
+        QBENCHMARK {
+            run_small_items(true);
+        }
+    }
+
+    void runSignalFanoutCopy()
+    {
+        QBENCHMARK {
+            run_signal_fanout(false);
+        }
+    }
+
+    void runSignalFanoutShared()
+    {
+        QBENCHMARK {
+            run_signal_fanout(true);
+        }
+    }
+
+    void runSignalFanoutRing()
+    {
+        QBENCHMARK {
+            run_signal_fanout(false, StreamBackend::SharedRing);
+        }
+    }
+
+    void runSmallItemsFanoutQueues()
+    {
+        QBENCHMARK {
+            run_small_items_fanout(StreamBackend::SubscriberQueues);
+        }
+    }
+
+    void runSmallItemsFanoutRing()
+    {
+        QBENCHMARK {
+            run_small_items_fanout(StreamBackend::SharedRing);
+        }
+    }
 };
 
 QTEST_MAIN(TestStreamPerf)
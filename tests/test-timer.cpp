@@ -2,8 +2,10 @@
 #include <QDebug>
 #include <QtTest>
 #include <iostream>
+#include <random>
 #include <thread>
 
+#include "datactl/datatypes.h"
 #include "datactl/syclock.h"
 #include "datactl/timesync.h"
 #include "utils/misc.h"
@@ -361,6 +363,126 @@ private slots:
         }
     }
 
+    void runExClockSynchronizerDriftModel()
+    {
+        qDebug() << "\n#\n# External Clock Synchronizer (Drift Model)\n#";
+        std::shared_ptr<SyncTimer> syTimer(new SyncTimer());
+        std::unique_ptr<SecondaryClockSynchronizer> sync(new SecondaryClockSynchronizer(syTimer, nullptr));
+
+        const auto tsFilename = QStringLiteral("/tmp/tstest-%1").arg(createRandomString(8));
+        const auto toleranceValue = microseconds_t(1000);
+        const auto calibrationCount = 400;
+        sync->setStrategies(TimeSyncStrategy::SHIFT_TIMESTAMPS_BWD | TimeSyncStrategy::SHIFT_TIMESTAMPS_FWD);
+        sync->setOffsetEstimator(ClockOffsetEstimator::DRIFT_MODEL);
+        sync->setCalibrationPointsCount(calibrationCount);
+        sync->setTolerance(toleranceValue);
+        sync->setTimeSyncBasename(tsFilename, QUuid::createUuid());
+
+        syTimer->start();
+        QVERIFY(sync->start());
+
+        // The secondary clock runs 50ppm too fast, and the master timestamps are
+        // delayed by 0-400µs of transmission jitter, with an occasional large delay.
+        const double driftPpm = 50;
+        const double meanJitterUsec = 200;
+        std::mt19937 rng(0);
+        std::uniform_int_distribution<int> jitterDist(0, 400);
+        auto secondaryTS = [&](double trueMasterUsec) {
+            return microseconds_t(std::lround(11111 + trueMasterUsec * (1 + driftPpm / 1000.0 / 1000.0)));
+        };
+
+        auto lastMasterTS = microseconds_t(0);
+        auto lastCorrection = microseconds_t(0);
+        for (auto i = 0; i < 120 * 1000; ++i) {
+            // master clock pretends it was already running for half a second, new points arrive at 1kHz
+            const double trueMasterUsec = 500 * 1000 + i * 1000.0;
+            const auto curSecondaryTS = secondaryTS(trueMasterUsec);
+            auto syncMasterTS = microseconds_t(std::lround(trueMasterUsec) + jitterDist(rng));
+            if (i % 500 == 250)
+                syncMasterTS += microseconds_t(5000);
+            sync->processTimestamp(syncMasterTS, curSecondaryTS);
+
+            // timestamps must never go backwards
+            QVERIFY(syncMasterTS >= lastMasterTS);
+            lastMasterTS = syncMasterTS;
+            if (!sync->isCalibrated())
+                continue;
+
+            // corrections are applied smoothly, and not in steps
+            QVERIFY2(
+                abs((sync->clockCorrectionOffset() - lastCorrection).count()) <= 5,
+                qPrintable(QStringLiteral("%1 -> %2 at %3")
+                               .arg(lastCorrection.count())
+                               .arg(sync->clockCorrectionOffset().count())
+                               .arg(i)));
+            lastCorrection = sync->clockCorrectionOffset();
+
+            // once the drift is known, all timestamps must be corrected to within tolerance
+            if (i > 10 * 1000) {
+                const auto expectedMasterTS = trueMasterUsec + meanJitterUsec;
+                QVERIFY2(
+                    std::abs(syncMasterTS.count() - expectedMasterTS) < toleranceValue.count() / 2,
+                    qPrintable(QStringLiteral("%1 ~ %2").arg(syncMasterTS.count()).arg(expectedMasterTS)));
+            }
+        }
+
+        // the drift estimate should be close to the real one now
+        QVERIFY2(
+            std::abs(sync->driftModel().drift() - driftPpm) < 1,
+            qPrintable(QString::number(sync->driftModel().drift())));
+        sync->stop();
+
+        // the tsync file should hold few points, which still map the time within tolerance
+        TimeSyncFileReader tsReader;
+        QVERIFY(tsReader.open(tsFilename + QStringLiteral(".tsync")));
+        QCOMPARE(
+            tsReader.userData().value(QStringLiteral("clock_offset_estimator")).toString(),
+            clockOffsetEstimatorToString(ClockOffsetEstimator::DRIFT_MODEL));
+        const auto estimatorName = tsReader.userData().value(QStringLiteral("clock_offset_estimator")).toString();
+        QCOMPARE(clockOffsetEstimatorFromString(estimatorName), ClockOffsetEstimator::DRIFT_MODEL);
+        QVERIFY2(tsReader.entryCount() < 40, qPrintable(QString::number(tsReader.entryCount())));
+        for (auto i = 20 * 1000; i < 120 * 1000; i += 1000) {
+            const double trueMasterUsec = 500 * 1000 + i * 1000.0;
+            const auto mappedMasterTS = tsReader.mapTime1ToTime2(secondaryTS(trueMasterUsec).count());
+            QVERIFY2(
+                std::abs(mappedMasterTS - (trueMasterUsec + meanJitterUsec)) < toleranceValue.count() / 2,
+                qPrintable(QStringLiteral("%1 ~ %2").arg(mappedMasterTS).arg(trueMasterUsec + meanJitterUsec)));
+        }
+        QFile::remove(tsFilename + QStringLiteral(".tsync"));
+    }
+
+    void runSyncTelemetryBuffer()
+    {
+        SyncTelemetryBuffer buffer(8, 2);
+        FloatSignalBlock block;
+
+        // nothing pending, so the block must not be touched
+        QCOMPARE(buffer.takeAll(block), (size_t)0);
+
+        for (auto i = 0; i < 10; ++i) {
+            const bool added = buffer.append(microseconds_t(i * 1000), i, i / 2.0, -i);
+            QCOMPARE(added, i < 8);
+        }
+        QCOMPARE(buffer.droppedCount(), (size_t)2);
+
+        QCOMPARE(buffer.takeAll(block), (size_t)8);
+        QCOMPARE(block.length(), (size_t)8);
+        QCOMPARE(block.cols(), (size_t)4);
+        for (auto i = 0; i < 8; ++i) {
+            QCOMPARE(block.timestamps[i], (quint64)(i * 1000));
+            QCOMPARE(block.data(i, 0), (double)i);
+            QCOMPARE(block.data(i, 1), i / 2.0);
+            QCOMPARE(block.data(i, 2), (double)-i);
+            QCOMPARE(block.data(i, 3), 2.0);
+        }
+
+        // the buffer wraps around once records were taken
+        QVERIFY(buffer.append(microseconds_t(42), 1, 2, 3));
+        QCOMPARE(buffer.takeAll(block), (size_t)1);
+        QCOMPARE(block.timestamps[0], (quint64)42);
+        QCOMPARE(buffer.takeAll(block), (size_t)0);
+    }
+
     void runFreqCounterSynchronizer()
     {
         qDebug() << "\n#\n# External FreqCounter Synchronizer\n#";
@@ -639,6 +761,56 @@ private slots:
             }
         }
     }
+
+    void runFreqCounterSynchronizerRawBuffer()
+    {
+        qDebug() << "\n#\n# External FreqCounter Synchronizer (raw buffer API)\n#";
+        std::shared_ptr<SyncTimer> syTimer(new SyncTimer());
+        std::unique_ptr<FakeIndexDevice> idxDev(new FakeIndexDevice());
+
+        // one synchronizer uses the Eigen API, the other one the raw buffer API - both must agree
+        std::unique_ptr<FreqCounterSynchronizer> syncVec(
+            new FreqCounterSynchronizer(syTimer, nullptr, idxDev->freqHz()));
+        std::unique_ptr<FreqCounterSynchronizer> syncBuf(
+            new FreqCounterSynchronizer(syTimer, nullptr, idxDev->freqHz()));
+
+        const int calibrationCount = (idxDev->freqHz() / idxDev->blockSize()) / 2;
+        for (auto &sync : {syncVec.get(), syncBuf.get()}) {
+            sync->setStrategies(TimeSyncStrategy::SHIFT_TIMESTAMPS_BWD | TimeSyncStrategy::SHIFT_TIMESTAMPS_FWD);
+            sync->setCalibrationBlocksCount(calibrationCount);
+            sync->setTolerance(microseconds_t(1000));
+        }
+
+        syTimer->start();
+        QVERIFY(syncVec->start());
+        QVERIFY(syncBuf->start());
+
+        std::vector<uint32_t> rawIdx(idxDev->blockSize());
+        std::vector<quint64> bufIdx(idxDev->blockSize());
+        auto curMasterTS = microseconds_t(500 * 1000);
+        for (auto i = 0; i < calibrationCount * 12; ++i) {
+            // the secondary clock runs faster after calibration, so offsets need to be applied
+            curMasterTS = curMasterTS + milliseconds_t(1);
+            if (i > calibrationCount * 2 && i % 100 == 0)
+                curMasterTS = curMasterTS - microseconds_t(100);
+
+            for (auto blockIdx = 0; blockIdx < 2; ++blockIdx) {
+                auto vecBlock = idxDev->generateBlock();
+                for (uint j = 0; j < idxDev->blockSize(); ++j)
+                    rawIdx[j] = static_cast<uint32_t>(vecBlock[j]);
+
+                syncVec->processTimestamps(curMasterTS, blockIdx, 2, vecBlock);
+                syncBuf->processTimestamps(curMasterTS, blockIdx, 2, rawIdx.data(), bufIdx.data(), rawIdx.size());
+
+                QCOMPARE(syncBuf->indexOffset(), syncVec->indexOffset());
+                for (uint j = 0; j < idxDev->blockSize(); ++j)
+                    QCOMPARE(bufIdx[j], vecBlock[j]);
+            }
+        }
+
+        // we must actually have tested index adjustments
+        QVERIFY(syncVec->indexOffset() != 0);
+    }
 };
 
 QTEST_MAIN(TestTimer)
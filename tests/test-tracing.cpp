@@ -0,0 +1,107 @@
+
+#include <QtTest>
+#include <pthread.h>
+#include <thread>
+
+#include "tracing.h"
+
+using namespace Syntalos;
+
+class TestTracing : public QObject
+{
+    Q_OBJECT
+private slots:
+    void runDisabled()
+    {
+        TraceCollector collector;
+        collector.reset();
+
+        Tracing::setEnabled(false);
+        SY_TRACE_BEGIN("disabled");
+        SY_TRACE_COUNTER("disabled-counter", 1);
+        SY_TRACE_END("disabled");
+
+        collector.collect();
+        QCOMPARE(collector.eventCount(), (size_t)0);
+    }
+
+    void runRecordAndSave()
+    {
+        TraceCollector collector;
+        collector.reset();
+        Tracing::setEnabled(true);
+
+        const auto dynName = Tracing::internName(QStringLiteral("module \"quoted\""));
+        QCOMPARE(Tracing::internName(QStringLiteral("module \"quoted\"")), dynName);
+
+        std::thread thread([&]() {
+            pthread_setname_np(pthread_self(), "trace-worker");
+            for (int i = 0; i < 10; i++) {
+                SY_TRACE_SCOPE(dynName);
+                SY_TRACE_COUNTER("queue", i);
+            }
+        });
+        {
+            SY_TRACE_SCOPE("main");
+        }
+        thread.join();
+        Tracing::setEnabled(false);
+
+        collector.collect();
+        QCOMPARE(collector.eventCount(), (size_t)32);
+        QCOMPARE(collector.droppedCount(), (uint64_t)0);
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const auto fname = dir.filePath("trace.json");
+        QString error;
+        QVERIFY2(collector.saveJson(fname, &error), qPrintable(error));
+
+        QFile f(fname);
+        QVERIFY(f.open(QIODevice::ReadOnly));
+        QJsonParseError parseError;
+        const auto doc = QJsonDocument::fromJson(f.readAll(), &parseError);
+        QCOMPARE(parseError.error, QJsonParseError::NoError);
+
+        int begins = 0, ends = 0, counters = 0;
+        bool workerNamed = false;
+        for (const auto &v : doc.object().value("traceEvents").toArray()) {
+            const auto ev = v.toObject();
+            const auto ph = ev.value("ph").toString();
+            if (ph == "B")
+                begins++;
+            else if (ph == "E")
+                ends++;
+            else if (ph == "C")
+                counters++;
+            else if (ph == "M" && ev.value("args").toObject().value("name").toString() == "trace-worker")
+                workerNamed = true;
+
+            if (ph == "B" && ev.value("name").toString() != "main")
+                QCOMPARE(ev.value("name").toString(), QStringLiteral("module \"quoted\""));
+        }
+        QCOMPARE(begins, 11);
+        QCOMPARE(ends, 11);
+        QCOMPARE(counters, 10);
+        QVERIFY(workerNamed);
+    }
+
+    void runOverflow()
+    {
+        TraceCollector collector;
+        collector.reset();
+        Tracing::setEnabled(true);
+
+        // without draining, a thread buffer eventually fills up and drops new events
+        for (int i = 0; i < 100000; i++)
+            SY_TRACE_COUNTER("overflow", i);
+        Tracing::setEnabled(false);
+
+        collector.collect();
+        QVERIFY(collector.droppedCount() > 0);
+        QCOMPARE(collector.eventCount() + collector.droppedCount(), (uint64_t)100000);
+    }
+};
+
+QTEST_MAIN(TestTracing)
+#include "test-tracing.moc"
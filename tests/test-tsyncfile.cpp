@@ -1,7 +1,9 @@
 
 #include <QDebug>
 #include <QtTest>
+#include <atomic>
 #include <iostream>
+#include <thread>
 
 #include "datactl/syclock.h"
 #include "datactl/timesync.h"
@@ -14,7 +16,11 @@ class TestTSyncFile : public QObject
     Q_OBJECT
 private slots:
 
-    void tsyncFileRWForDTypes(TSyncFileDataType dt1, TSyncFileDataType dt2, int values_n = 142000)
+    void tsyncFileRWForDTypes(
+        TSyncFileDataType dt1,
+        TSyncFileDataType dt2,
+        int values_n = 142000,
+        TSyncFileEncoding encoding = TSyncFileEncoding::RAW)
     {
         auto tsFilename = QStringLiteral("/tmp/tstest-%1").arg(createRandomString(8));
 
@@ -22,6 +28,7 @@ private slots:
         auto tswriter = new TimeSyncFileWriter;
         tswriter->setFileName(tsFilename);
         tswriter->setTimeDataTypes(dt1, dt2);
+        tswriter->setEncoding(encoding);
         auto ret = tswriter->open(
             QStringLiteral("UnittestDummyModule"), QUuid("a12975f1-84b7-4350-8683-7a5fe9ed968f"), microseconds_t(1500));
         QVERIFY2(ret, qPrintable(tswriter->lastError()));
@@ -47,6 +54,7 @@ private slots:
         QCOMPARE(tsreader->tolerance().count(), 1500);
         QCOMPARE(tsreader->timeDTypes(), qMakePair(dt1, dt2));
         QCOMPARE(tsreader->syncMode(), TSyncFileMode::CONTINUOUS);
+        QCOMPARE(tsreader->encoding(), encoding);
 
         const auto timesRead = tsreader->times();
         QCOMPARE((int)timesRead.size(), values_n);
@@ -58,6 +66,59 @@ private slots:
         }
         delete tsreader;
 
+        // reading in parallel must yield the same data, with and without checksum verification
+        for (const auto verify : {true, false}) {
+            TimeSyncFileReader parReader;
+            parReader.setVerifyChecksums(verify);
+            ret = parReader.openParallel(tsFilename + QStringLiteral(".tsync"), 4);
+            QVERIFY2(ret, qPrintable(parReader.lastError()));
+            QVERIFY(!parReader.isMapped());
+            QCOMPARE(parReader.encoding(), encoding);
+            QVERIFY(parReader.times() == timesRead);
+        }
+
+        // random access on the memory-mapped file must yield the same data
+        TimeSyncFileReader mapReader;
+        ret = mapReader.openMapped(tsFilename + QStringLiteral(".tsync"));
+        QVERIFY2(ret, qPrintable(mapReader.lastError()));
+        QCOMPARE(mapReader.entryCount(), (size_t)values_n);
+        QVERIFY(mapReader.times().empty());
+        for (size_t i = 0; i < mapReader.entryCount(); i += 997) {
+            const auto pair = mapReader.entry(i);
+            QCOMPARE(pair.first, (long long)i * 1000);
+            QCOMPARE(pair.second, (long long)i * 1051);
+        }
+        QCOMPARE(mapReader.entry(values_n - 1).second, (long long)(values_n - 1) * 1051);
+
+        // lookups in between entries are interpolated
+        QCOMPARE(mapReader.mapTime1ToTime2(200500), 200.5 * 1051);
+        QCOMPARE(mapReader.mapTime2ToTime1(1051 * 42), 42000.0);
+
+        std::vector<long long> queries;
+        for (int i = 0; i < values_n; i += 13)
+            queries.push_back((long long)i * 1000 + 500);
+        std::vector<double> results(queries.size());
+        mapReader.mapTime1ToTime2(queries.data(), results.data(), queries.size());
+        for (size_t i = 0; i < queries.size(); ++i)
+            QCOMPARE(results[i], mapReader.mapTime1ToTime2(queries[i]));
+
+        // concurrent lookups must not interfere with each other, even if they hit different blocks
+        std::atomic_int mismatches(0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&, t]() {
+                for (size_t i = t; i < mapReader.entryCount(); i += 89) {
+                    const auto pair = mapReader.entry(i);
+                    if (pair.first != (long long)i * 1000 || pair.second != (long long)i * 1051)
+                        mismatches++;
+                }
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+        QCOMPARE(mismatches.load(), 0);
+        mapReader.close();
+
         // delete temporary file
         QFile file(tsFilename + QStringLiteral(".tsync"));
         file.remove();
@@ -83,6 +144,150 @@ private slots:
         tsyncFileRWForDTypes(TSyncFileDataType::UINT32, TSyncFileDataType::UINT64);
     }
 
+    QByteArray writeTSyncFile(const QString &fname, bool async, int values_n)
+    {
+        TimeSyncFileWriter tswriter;
+        tswriter.setFileName(fname);
+        tswriter.setTimeDataTypes(TSyncFileDataType::INT32, TSyncFileDataType::UINT64);
+        tswriter.setCreationTimeOverride(QDateTime::fromSecsSinceEpoch(1600000000));
+        tswriter.setAsyncWriting(async);
+        if (!tswriter.open(QStringLiteral("UnittestDummyModule"), QUuid("a12975f1-84b7-4350-8683-7a5fe9ed968f")))
+            return QByteArray();
+
+        for (int i = 0; i < values_n; ++i) {
+            const auto tbase = microseconds_t(i * 1000 - 8000);
+            tswriter.writeTimes(tbase, tbase + microseconds_t(i * 51));
+            if (i == values_n / 3)
+                tswriter.flush();
+        }
+        tswriter.close();
+
+        QFile file(fname + QStringLiteral(".tsync"));
+        if (!file.open(QIODevice::ReadOnly))
+            return QByteArray();
+        const auto data = file.readAll();
+        file.remove();
+        return data;
+    }
+
+    void runTestTSyncAsyncWrite()
+    {
+        // files written asynchronously must be identical to synchronously written ones
+        const auto tsFilename = QStringLiteral("/tmp/tstest-%1").arg(createRandomString(8));
+        for (const auto count : {0, 1, 2800, 2801, 100000}) {
+            const auto syncData = writeTSyncFile(tsFilename, false, count);
+            const auto asyncData = writeTSyncFile(tsFilename, true, count);
+            QVERIFY(!syncData.isEmpty());
+            QCOMPARE(asyncData, syncData);
+        }
+    }
+
+    void runTestTSyncUpdateUserData()
+    {
+        const auto tsFilename = QStringLiteral("/tmp/tstest-%1").arg(createRandomString(8));
+        TimeSyncFileWriter tswriter;
+        tswriter.setFileName(tsFilename);
+        tswriter.setTimeDataTypes(TSyncFileDataType::INT64, TSyncFileDataType::INT64);
+        tswriter.setEncoding(TSyncFileEncoding::DELTA);
+        tswriter.setAsyncWriting(true);
+        tswriter.setUserDataReserve(128);
+
+        QVariantHash userData;
+        userData.insert(QStringLiteral("initial"), 1);
+        QVERIFY2(
+            tswriter.open(
+                QStringLiteral("UnittestDummyModule"),
+                QUuid("a12975f1-84b7-4350-8683-7a5fe9ed968f"),
+                microseconds_t(1500),
+                userData),
+            qPrintable(tswriter.lastError()));
+        for (int i = 0; i < 5000; ++i)
+            tswriter.writeTimes(microseconds_t(i * 1000), microseconds_t(i * 1051));
+
+        QVariantHash finalData;
+        finalData.insert(QStringLiteral("final"), 2.5);
+        QVERIFY2(tswriter.updateUserData(finalData), qPrintable(tswriter.lastError()));
+        finalData.insert(QStringLiteral("too_large"), QString(128, 'x'));
+        QVERIFY(!tswriter.updateUserData(finalData));
+        tswriter.close();
+
+        TimeSyncFileReader tsreader;
+        QVERIFY2(tsreader.open(tsFilename + QStringLiteral(".tsync")), qPrintable(tsreader.lastError()));
+        QCOMPARE(tsreader.tolerance().count(), 1500);
+        QCOMPARE(tsreader.userData().value("initial").toInt(), 1);
+        QCOMPARE(tsreader.userData().value("final").toDouble(), 2.5);
+        QVERIFY(!tsreader.userData().contains("too_large"));
+
+        const auto timesRead = tsreader.times();
+        QCOMPARE((int)timesRead.size(), 5000);
+        QCOMPARE(timesRead.back().first, (long long)4999 * 1000);
+        QCOMPARE(timesRead.back().second, (long long)4999 * 1051);
+        QFile::remove(tsFilename + QStringLiteral(".tsync"));
+    }
+
+    void benchmarkWriteEntries(bool async)
+    {
+        const auto tsFilename = QStringLiteral("/tmp/tstest-%1").arg(createRandomString(8));
+        TimeSyncFileWriter tswriter;
+        tswriter.setFileName(tsFilename);
+        tswriter.setTimeDataTypes(TSyncFileDataType::INT64, TSyncFileDataType::INT64);
+        tswriter.setAsyncWriting(async);
+        QVERIFY2(
+            tswriter.open(QStringLiteral("UnittestDummyModule"), QUuid("a12975f1-84b7-4350-8683-7a5fe9ed968f")),
+            qPrintable(tswriter.lastError()));
+
+        // measure the time spent on the writing thread for 4096 entries
+        long long i = 0;
+        QBENCHMARK {
+            for (int j = 0; j < 4096; ++j) {
+                tswriter.writeTimes(microseconds_t(i * 1000), microseconds_t(i * 1051));
+                i++;
+            }
+        }
+        tswriter.close();
+        QFile::remove(tsFilename + QStringLiteral(".tsync"));
+    }
+
+    void runBenchmarkWriteSync()
+    {
+        benchmarkWriteEntries(false);
+    }
+
+    void runBenchmarkWriteAsync()
+    {
+        benchmarkWriteEntries(true);
+    }
+
+    void runTestTSyncDeltaInt64_Int64()
+    {
+        tsyncFileRWForDTypes(TSyncFileDataType::INT64, TSyncFileDataType::INT64, 142000, TSyncFileEncoding::DELTA);
+
+        // continuous time mappings need about two bytes per entry
+        const auto tsFilename = QStringLiteral("/tmp/tstest-%1").arg(createRandomString(8));
+        TimeSyncFileWriter tswriter;
+        tswriter.setFileName(tsFilename);
+        tswriter.setTimeDataTypes(TSyncFileDataType::INT64, TSyncFileDataType::INT64);
+        tswriter.setEncoding(TSyncFileEncoding::DELTA);
+        QVERIFY(tswriter.open(QStringLiteral("UnittestDummyModule"), QUuid("a12975f1-84b7-4350-8683-7a5fe9ed968f")));
+        for (int i = 0; i < 100000; ++i)
+            tswriter.writeTimes(microseconds_t(i * 1000), microseconds_t(i * 1051 + 20));
+        tswriter.close();
+
+        QFile file(tsFilename + QStringLiteral(".tsync"));
+        QVERIFY(file.size() < 100000 * 16 / 5);
+        file.remove();
+    }
+
+    void runTestTSyncDeltaUInt32_UInt64()
+    {
+        tsyncFileRWForDTypes(TSyncFileDataType::UINT32, TSyncFileDataType::UINT64, 142000, TSyncFileEncoding::DELTA);
+    }
+
+    void runTestTSyncDeltaInt16_Int32()
+    {
+        tsyncFileRWForDTypes(TSyncFileDataType::INT16, TSyncFileDataType::INT32, 30, TSyncFileEncoding::DELTA);
+    }
+
     void runBenchmark()
     {
         QBENCHMARK {
@@ -0,0 +1,114 @@
+#include <QDebug>
+#include <QtTest>
+#include <random>
+
+#include "datactl/eigenaux.h"
+#include "datactl/windowstats.h"
+
+using namespace Syntalos;
+
+class TestWindowStats : public QObject
+{
+    Q_OBJECT
+private:
+    /**
+     * Feed random values into a window and a plain vector, and compare
+     * the window statistics against the vector helper functions after every value.
+     */
+    void compareWithVector(size_t windowSize, int64_t base, int64_t spread)
+    {
+        std::mt19937_64 rng(windowSize);
+        std::uniform_int_distribution<int64_t> dist(-spread, spread);
+
+        SlidingWindowStats stats(windowSize);
+        VectorXsl vec = VectorXsl::Zero(windowSize);
+        size_t idx = 0;
+        for (int i = 0; i < 4000; ++i) {
+            const auto value = base + dist(rng);
+            stats.push(value);
+            vec[idx++] = value;
+            if (idx >= windowSize)
+                idx = 0;
+
+            QCOMPARE(stats.median(), vectorMedian(vec));
+            QCOMPARE(stats.mean(), (int64_t)vec.mean());
+            QCOMPARE(stats.sum(), (int64_t)vec.sum());
+            if (windowSize > 1) {
+                QCOMPARE(stats.variance(), vectorVariance(vec));
+                QCOMPARE(stats.variance(base + 0.5, false), vectorVariance(vec, base + 0.5, false));
+            }
+        }
+    }
+
+private slots:
+    void runInitialValues()
+    {
+        SlidingWindowStats stats(5, 42);
+        QCOMPARE(stats.size(), (size_t)5);
+        QCOMPARE(stats.mean(), (int64_t)42);
+        QCOMPARE(stats.median(), 42.0);
+        QCOMPARE(stats.variance(), 0.0);
+
+        // the window starts out full, so new values replace the initial ones
+        stats.push(2);
+        stats.push(2);
+        QCOMPARE(stats.median(), 42.0);
+        stats.push(2);
+        QCOMPARE(stats.median(), 2.0);
+        QCOMPARE(stats.mean(), (int64_t)((3 * 2 + 2 * 42) / 5));
+
+        stats.reset(2);
+        QCOMPARE(stats.median(), 0.0);
+        stats.push(-3);
+        QCOMPARE(stats.median(), -1.5);
+        QCOMPARE(stats.mean(), (int64_t)-1);
+    }
+
+    void runCompareSmallWindows()
+    {
+        for (const size_t size : {1, 2, 3, 4, 7, 16})
+            compareWithVector(size, 0, 3);
+    }
+
+    void runCompareOffsets()
+    {
+        compareWithVector(400, -2500, 1000000);
+        compareWithVector(501, 1200, 80);
+    }
+
+    void runCompareLargeValues()
+    {
+        // clock offsets can be large, with only a small spread
+        compareWithVector(250, 1700000000000000, 500);
+    }
+
+    void benchWindowStats()
+    {
+        std::mt19937_64 rng(0);
+        SlidingWindowStats stats(1000);
+        double result = 0;
+        QBENCHMARK {
+            stats.push(rng() % 100000);
+            result += stats.median() + stats.variance();
+        }
+        QVERIFY(result >= 0);
+    }
+
+    void benchVectorStats()
+    {
+        std::mt19937_64 rng(0);
+        VectorXsl vec = VectorXsl::Zero(1000);
+        size_t idx = 0;
+        double result = 0;
+        QBENCHMARK {
+            vec[idx++] = rng() % 100000;
+            if (idx >= 1000)
+                idx = 0;
+            result += vectorMedian(vec) + vectorVariance(vec);
+        }
+        QVERIFY(result >= 0);
+    }
+};
+
+QTEST_MAIN(TestWindowStats)
+#include "test-windowstats.moc"
@@ -41,11 +41,15 @@ int main(int argc, char *argv[])
         QStringLiteral("tsync"), QStringLiteral("Read data from a time-sync (.tsync) file"), QStringLiteral("file"));
     parser.addOption(tsyncOption);
 
+    QCommandLineOption noVerifyOption(
+        QStringLiteral("no-verify"), QStringLiteral("Do not verify data checksums, for faster reading of trusted files"));
+    parser.addOption(noVerifyOption);
+
     parser.process(a);
 
     QString tsyncFile = parser.value(tsyncOption);
     if (!tsyncFile.isEmpty())
-        return displayTSyncMetadata(tsyncFile);
+        return displayTSyncMetadata(tsyncFile, !parser.isSet(noVerifyOption));
     else {
         std::cout << parser.helpText().toStdString() << std::endl;
         return 0;
@@ -25,10 +25,11 @@
 
 using namespace Syntalos;
 
-int displayTSyncMetadata(const QString &fname)
+int displayTSyncMetadata(const QString &fname, bool verifyChecksums)
 {
     auto tsr = std::make_unique<TimeSyncFileReader>();
-    if (!tsr->open(fname)) {
+    tsr->setVerifyChecksums(verifyChecksums);
+    if (!tsr->openParallel(fname)) {
         std::cerr << "Unable to open file '" << fname.toStdString() << "': " << tsr->lastError().toStdString()
                   << std::endl;
         return 1;
@@ -44,7 +45,8 @@ int displayTSyncMetadata(const QString &fname)
               << "TimeDTypes: " << tsyncFileDataTypeToString(tsr->timeDTypes().first).toStdString() << "; "
               << tsyncFileDataTypeToString(tsr->timeDTypes().second).toStdString() << "\n"
               << "TimeUnits: " << tsyncFileTimeUnitToString(tsr->timeUnits().first).toStdString() << "; "
-              << tsyncFileTimeUnitToString(tsr->timeUnits().second).toStdString() << "\n";
+              << tsyncFileTimeUnitToString(tsr->timeUnits().second).toStdString() << "\n"
+              << "Encoding: " << tsyncFileEncodingToString(tsr->encoding()).toStdString() << "\n";
     if (tsr->tolerance().count() != 0)
         std::cout << "Tolerance: " << tsr->tolerance().count() << " µs\n";
     if (!tsr->userData().isEmpty()) {
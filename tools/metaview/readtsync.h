@@ -21,4 +21,4 @@
 
 #include <QString>
 
-int displayTSyncMetadata(const QString &fname);
+int displayTSyncMetadata(const QString &fname, bool verifyChecksums = true);